@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Decode cost of a scan-heavy event stream: mostly LE Advertising Reports,
+ * with some Number Of Completed Packets, Command Complete and Disconnection
+ * Complete events. The table-driven decoder is compared with the switch
+ * based decoder that hosts write by hand.
+ *
+ * Usage: bench_hci_evt [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "blectlr_hci_evt.h"
+
+#define EVENTS           256
+#define REPORT_DATA_SIZE 31
+
+static uint8_t events[EVENTS][HCI_EVENT_PACKET_MAX_SIZE];
+static enum blectlr_hci_evt_id expected_id[EVENTS];
+static uint32_t expected_reports;
+
+static volatile uint32_t sink;
+
+static size_t adv_report_build(uint8_t *buf, uint8_t num_reports, uint8_t seed)
+{
+	size_t len = 0;
+
+	buf[len++] = 0x3E;
+	len++;
+	buf[len++] = 0x02;
+	buf[len++] = num_reports;
+
+	for (uint8_t r = 0; r < num_reports; r++) {
+		uint8_t data_len = (uint8_t)((seed + r * 7) % REPORT_DATA_SIZE + 1);
+
+		buf[len++] = 0x00;
+		buf[len++] = 0x01;
+		for (int i = 0; i < 6; i++) {
+			buf[len++] = (uint8_t)(seed + r + i);
+		}
+		buf[len++] = data_len;
+		for (uint8_t i = 0; i < data_len; i++) {
+			buf[len++] = (uint8_t)(seed ^ i);
+		}
+		buf[len++] = (uint8_t)-60;
+	}
+
+	buf[1] = (uint8_t)(len - HCI_EVENT_HEADER_SIZE);
+
+	return len;
+}
+
+static void events_build(void)
+{
+	static const uint8_t num_completed[] = {
+		0x13, 0x05, 0x01, 0x00, 0x00, 0x02, 0x00,
+	};
+	static const uint8_t cmd_complete[] = {
+		0x0E, 0x04, 0x01, 0x0C, 0x20, 0x00,
+	};
+	static const uint8_t disconn[] = {
+		0x05, 0x04, 0x00, 0x00, 0x00, 0x13,
+	};
+
+	for (int i = 0; i < EVENTS; i++) {
+		switch (i % 10) {
+		case 7:
+			memcpy(events[i], num_completed, sizeof(num_completed));
+			expected_id[i] = BLECTLR_HCI_EVT_NUM_COMPLETED_PACKETS;
+			break;
+		case 8:
+			memcpy(events[i], cmd_complete, sizeof(cmd_complete));
+			expected_id[i] = BLECTLR_HCI_EVT_CMD_COMPLETE;
+			break;
+		case 9:
+			memcpy(events[i], disconn, sizeof(disconn));
+			expected_id[i] = BLECTLR_HCI_EVT_DISCONN_COMPLETE;
+			break;
+		default:
+			adv_report_build(events[i], (uint8_t)(i % 4 + 1),
+					 (uint8_t)i);
+			expected_id[i] = BLECTLR_HCI_EVT_LE_ADV_REPORT;
+			expected_reports += i % 4 + 1;
+			break;
+		}
+	}
+}
+
+/* The decoder a host writes without the library. It is kept out of line,
+ * like the library decoder, so the loops compare the decoders and not the
+ * call.
+ */
+static __attribute__((noinline)) enum blectlr_hci_evt_id
+switch_decode(hci_element_t const *buffer, struct blectlr_hci_evt *evt)
+{
+	evt->code = buffer[0];
+	evt->subevent = 0;
+	evt->len = buffer[1];
+	evt->params = &buffer[HCI_EVENT_HEADER_SIZE];
+	evt->id = BLECTLR_HCI_EVT_UNKNOWN;
+
+	switch (evt->code) {
+	case 0x05:
+		if (evt->len >= 4) {
+			evt->id = BLECTLR_HCI_EVT_DISCONN_COMPLETE;
+		}
+		break;
+	case 0x0E:
+		if (evt->len >= 3) {
+			evt->id = BLECTLR_HCI_EVT_CMD_COMPLETE;
+		}
+		break;
+	case 0x0F:
+		if (evt->len >= 4) {
+			evt->id = BLECTLR_HCI_EVT_CMD_STATUS;
+		}
+		break;
+	case 0x13:
+		if (evt->len >= 1) {
+			evt->id = BLECTLR_HCI_EVT_NUM_COMPLETED_PACKETS;
+		}
+		break;
+	case 0x3E:
+		if (evt->len < 1) {
+			break;
+		}
+		evt->subevent = buffer[HCI_EVENT_HEADER_SIZE];
+		evt->len--;
+		evt->params = &buffer[HCI_EVENT_HEADER_SIZE + 1];
+
+		switch (evt->subevent) {
+		case 0x01:
+			if (evt->len >= 18) {
+				evt->id = BLECTLR_HCI_EVT_LE_CONN_COMPLETE;
+			}
+			break;
+		case 0x02:
+			if (evt->len >= 1) {
+				evt->id = BLECTLR_HCI_EVT_LE_ADV_REPORT;
+			}
+			break;
+		case 0x03:
+			if (evt->len >= 9) {
+				evt->id = BLECTLR_HCI_EVT_LE_CONN_UPDATE_COMPLETE;
+			}
+			break;
+		default:
+			break;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return evt->id;
+}
+
+static void count_handler(void *context, struct blectlr_hci_evt const *evt)
+{
+	(*(uint32_t *)context) += evt->len;
+}
+
+static double elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1e9 +
+	       (now.tv_nsec - start->tv_nsec);
+}
+
+static void report(const char *name, double ns, unsigned long count)
+{
+	printf("%-28s %8.2f ns/event %10.0f events/s\n", name, ns / count,
+	       count * 1e9 / ns);
+}
+
+int main(int argc, char **argv)
+{
+	blectlr_hci_evt_handler_t handlers[BLECTLR_HCI_EVT_COUNT] = {
+		[BLECTLR_HCI_EVT_LE_ADV_REPORT] = count_handler,
+		[BLECTLR_HCI_EVT_NUM_COMPLETED_PACKETS] = count_handler,
+		[BLECTLR_HCI_EVT_CMD_COMPLETE] = count_handler,
+		[BLECTLR_HCI_EVT_DISCONN_COMPLETE] = count_handler,
+	};
+	unsigned long iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) :
+						100000;
+	unsigned long count = iterations * EVENTS;
+	struct blectlr_hci_evt evt;
+	struct timespec start;
+	uint32_t acc = 0;
+	uint32_t reports = 0;
+	int failures = 0;
+
+	events_build();
+
+	/* Check the decoders and the report iterator once. */
+	for (int i = 0; i < EVENTS; i++) {
+		struct blectlr_hci_adv_report_iter iter;
+
+		if (blectlr_hci_evt_decode(events[i], &evt) != expected_id[i] ||
+		    switch_decode(events[i], &evt) != expected_id[i]) {
+			fprintf(stderr, "event %d: wrong identifier\n", i);
+			failures++;
+		}
+		if (evt.id == BLECTLR_HCI_EVT_LE_ADV_REPORT) {
+			blectlr_hci_adv_report_iter_init(&iter, &evt);
+			while (blectlr_hci_adv_report_next(&iter)) {
+				reports++;
+			}
+		}
+	}
+	if (reports != expected_reports) {
+		fprintf(stderr, "%u reports, expected %u\n", reports,
+			expected_reports);
+		failures++;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long n = 0; n < iterations; n++) {
+		for (int i = 0; i < EVENTS; i++) {
+			acc += switch_decode(events[i], &evt);
+		}
+	}
+	report("switch decode", elapsed_ns(&start), count);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long n = 0; n < iterations; n++) {
+		for (int i = 0; i < EVENTS; i++) {
+			acc += blectlr_hci_evt_decode(events[i], &evt);
+		}
+	}
+	report("blectlr_hci_evt_decode", elapsed_ns(&start), count);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long n = 0; n < iterations; n++) {
+		for (int i = 0; i < EVENTS; i++) {
+			blectlr_hci_evt_dispatch(handlers, &acc, events[i]);
+		}
+	}
+	report("blectlr_hci_evt_dispatch", elapsed_ns(&start), count);
+
+	reports = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long n = 0; n < iterations; n++) {
+		for (int i = 0; i < EVENTS; i++) {
+			struct blectlr_hci_adv_report_iter iter;
+			struct blectlr_hci_adv_report const *r;
+
+			if (blectlr_hci_evt_decode(events[i], &evt) !=
+			    BLECTLR_HCI_EVT_LE_ADV_REPORT) {
+				continue;
+			}
+			blectlr_hci_adv_report_iter_init(&iter, &evt);
+			while ((r = blectlr_hci_adv_report_next(&iter))) {
+				acc += blectlr_hci_adv_report_rssi(r);
+				reports++;
+			}
+		}
+	}
+	report("decode + report iteration", elapsed_ns(&start), count);
+	printf("%u advertising reports\n", reports);
+
+	sink = acc;
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef BLECTLR_ADV_H__
+#define BLECTLR_ADV_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup blectlr_adv
+ * @{
+ *
+ * @brief Double-buffered advertising data helper.
+ *
+ * The helper keeps the advertising (or scan response) payload that was last
+ * given to the Controller together with a staging copy. The application
+ * updates the staging copy, either as a whole or by patching single fields at
+ * a fixed offset, and then commits it. A commit issues a single
+ * HCI LE Set Advertising Data (or Scan Response Data) command. Advertising
+ * does not have to be disabled: the Controller starts using the new payload
+ * from the next advertising event.
+ *
+ * Commits of a payload identical to the one already in the Controller are
+ * skipped, so applications can commit periodically without generating
+ * redundant HCI traffic.
+ *
+ * The committed payload only becomes the active one when the Controller
+ * reports success in the Command Complete event, passed to
+ * @ref blectlr_adv_data_cmd_complete. Until then the context does not
+ * accept new payloads.
+ *
+ * @note The helper is not reentrant. All functions operating on the same
+ *       context must be called from the same execution context.
+ **/
+
+/** @brief The maximum size of legacy advertising or scan response data. */
+#define BLECTLR_ADV_DATA_MAX_SIZE (31)
+
+/** @brief Payload type handled by a @ref blectlr_adv_data context. */
+enum blectlr_adv_data_type {
+	BLECTLR_ADV_DATA_TYPE_ADV,      /**< Advertising data. */
+	BLECTLR_ADV_DATA_TYPE_SCAN_RSP  /**< Scan response data. */
+};
+
+/** @brief Double-buffered advertising data context.
+ *
+ * @note The members are internal and must not be accessed directly.
+ */
+struct blectlr_adv_data {
+	uint8_t buf[2][BLECTLR_ADV_DATA_MAX_SIZE];
+	uint8_t len[2];
+	uint8_t active;
+	uint8_t type;
+	bool staged;
+	bool pending;
+};
+
+/**
+ * @brief      Initialize an advertising data context.
+ *
+ * The initial payload is treated as already present in the Controller, that
+ * is, the application is expected to have set it through HCI before enabling
+ * advertising.
+ *
+ * @param[out] adv   Context to initialize.
+ * @param[in]  type  Payload type, see @ref blectlr_adv_data_type.
+ * @param[in]  data  Initial payload. Can be NULL if @p len is 0.
+ * @param[in]  len   Length of the initial payload.
+ *
+ * @retval ::NRF_SUCCESS              Initialized successfully.
+ * @retval ::NRF_ERROR_NULL           @p adv is NULL, or @p data is NULL and @p len is not 0.
+ * @retval ::NRF_ERROR_INVALID_PARAM  Invalid payload type.
+ * @retval ::NRF_ERROR_INVALID_LENGTH @p len exceeds @ref BLECTLR_ADV_DATA_MAX_SIZE.
+ */
+uint32_t blectlr_adv_data_init(struct blectlr_adv_data *adv,
+			       enum blectlr_adv_data_type type,
+			       uint8_t const *data, uint8_t len);
+
+/**
+ * @brief      Replace the whole staged payload.
+ *
+ * @param[in]  adv   Context.
+ * @param[in]  data  New payload. Can be NULL if @p len is 0.
+ * @param[in]  len   Length of the new payload.
+ *
+ * @retval ::NRF_SUCCESS              Payload staged.
+ * @retval ::NRF_ERROR_NULL           @p adv is NULL, or @p data is NULL and @p len is not 0.
+ * @retval ::NRF_ERROR_INVALID_LENGTH @p len exceeds @ref BLECTLR_ADV_DATA_MAX_SIZE.
+ * @retval ::NRF_ERROR_INVALID_STATE  A committed payload awaits its Command Complete event.
+ */
+uint32_t blectlr_adv_data_stage(struct blectlr_adv_data *adv,
+				uint8_t const *data, uint8_t len);
+
+/**
+ * @brief      Patch a field of the staged payload.
+ *
+ * If nothing has been staged since the last commit, the staging copy is first
+ * initialized with the payload currently in the Controller. The patch must
+ * fall within the length of the staged payload.
+ *
+ * @param[in]  adv     Context.
+ * @param[in]  offset  Offset of the field within the payload.
+ * @param[in]  data    New field value.
+ * @param[in]  len     Length of the field.
+ *
+ * @retval ::NRF_SUCCESS              Field patched.
+ * @retval ::NRF_ERROR_NULL           @p adv or @p data is NULL.
+ * @retval ::NRF_ERROR_INVALID_LENGTH The field does not fit in the staged payload.
+ * @retval ::NRF_ERROR_INVALID_STATE  A committed payload awaits its Command Complete event.
+ */
+uint32_t blectlr_adv_data_patch(struct blectlr_adv_data *adv, uint8_t offset,
+				uint8_t const *data, uint8_t len);
+
+/**
+ * @brief      Send the staged payload to the Controller.
+ *
+ * The Command Complete event for the issued command is delivered through
+ * @ref hci_event_packet_get as for any other HCI command, and must be passed
+ * to @ref blectlr_adv_data_cmd_complete.
+ *
+ * @param[in]  adv  Context.
+ *
+ * @retval ::NRF_SUCCESS              Payload sent, or nothing to send.
+ * @retval ::NRF_ERROR_NULL           @p adv is NULL.
+ * @retval ::NRF_ERROR_BUSY           The Controller did not accept the command.
+ *                                    The payload stays staged.
+ * @retval ::NRF_ERROR_INVALID_STATE  A committed payload awaits its Command Complete event.
+ */
+uint32_t blectlr_adv_data_commit(struct blectlr_adv_data *adv);
+
+/**
+ * @brief      Apply the Command Complete event of a commit.
+ *
+ * On success the committed buffer becomes the active one. On failure it
+ * stays staged, so that it can be committed again.
+ *
+ * @param[in]  adv     Context.
+ * @param[in]  opcode  Command opcode of the Command Complete event.
+ * @param[in]  status  Status return parameter of the event.
+ *
+ * @retval ::NRF_SUCCESS              The event completed the commit of @p adv.
+ * @retval ::NRF_ERROR_NULL           @p adv is NULL.
+ * @retval ::NRF_ERROR_NOT_FOUND      No commit of @p adv awaits an event with @p opcode.
+ */
+uint32_t blectlr_adv_data_cmd_complete(struct blectlr_adv_data *adv,
+				       uint16_t opcode, uint8_t status);
+
+/**
+ * @brief      Get the payload currently in the Controller.
+ *
+ * @param[in]  adv  Context.
+ * @param[out] len  Length of the payload.
+ *
+ * @return     Pointer to the active payload.
+ */
+uint8_t const *blectlr_adv_data_active_get(struct blectlr_adv_data const *adv,
+					   uint8_t *len);
+
+/** @} **/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLECTLR_ADV_H__ */
@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef BLECTLR_HCI_EVT_H__
+#define BLECTLR_HCI_EVT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blectlr_hci.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup blectlr_hci_evt
+ * @{
+ *
+ * @brief Table-driven decoder for packets from @ref hci_event_packet_get.
+ *
+ * The decoder maps the event code, and for LE Meta events the subevent code,
+ * to a dense @ref blectlr_hci_evt_id through lookup tables that are built at
+ * compile time. It checks the parameter length against the minimum length of
+ * the event and gives access to the parameters through typed views that
+ * point directly into the packet buffer. No data is copied.
+ *
+ * The views only contain byte members, so they can be overlaid on any buffer
+ * position. Multi-octet fields are read with @ref blectlr_hci_le16.
+ *
+ * Applications either call @ref blectlr_hci_evt_decode and switch on the
+ * returned identifier, or fill a handler table indexed by
+ * @ref blectlr_hci_evt_id and call @ref blectlr_hci_evt_dispatch.
+ **/
+
+/** @brief Dense identifiers of the decoded events. */
+enum blectlr_hci_evt_id {
+	BLECTLR_HCI_EVT_UNKNOWN,
+	BLECTLR_HCI_EVT_DISCONN_COMPLETE,
+	BLECTLR_HCI_EVT_ENCRYPT_CHANGE,
+	BLECTLR_HCI_EVT_REMOTE_VERSION_INFO,
+	BLECTLR_HCI_EVT_CMD_COMPLETE,
+	BLECTLR_HCI_EVT_CMD_STATUS,
+	BLECTLR_HCI_EVT_HARDWARE_ERROR,
+	BLECTLR_HCI_EVT_NUM_COMPLETED_PACKETS,
+	BLECTLR_HCI_EVT_DATA_BUF_OVERFLOW,
+	BLECTLR_HCI_EVT_ENCRYPT_KEY_REFRESH_COMPLETE,
+	BLECTLR_HCI_EVT_AUTH_PAYLOAD_TIMEOUT_EXP,
+	BLECTLR_HCI_EVT_LE_CONN_COMPLETE,
+	BLECTLR_HCI_EVT_LE_ADV_REPORT,
+	BLECTLR_HCI_EVT_LE_CONN_UPDATE_COMPLETE,
+	BLECTLR_HCI_EVT_LE_REMOTE_FEAT_COMPLETE,
+	BLECTLR_HCI_EVT_LE_LTK_REQUEST,
+	BLECTLR_HCI_EVT_LE_CONN_PARAM_REQ,
+	BLECTLR_HCI_EVT_LE_DATA_LEN_CHANGE,
+	BLECTLR_HCI_EVT_LE_P256_PUBLIC_KEY_COMPLETE,
+	BLECTLR_HCI_EVT_LE_GENERATE_DHKEY_COMPLETE,
+	BLECTLR_HCI_EVT_LE_ENH_CONN_COMPLETE,
+	BLECTLR_HCI_EVT_LE_DIRECT_ADV_REPORT,
+	BLECTLR_HCI_EVT_LE_PHY_UPDATE_COMPLETE,
+	BLECTLR_HCI_EVT_LE_CHAN_SEL_ALGO,
+	BLECTLR_HCI_EVT_COUNT
+};
+
+/** @brief Disconnection Complete event parameters. */
+struct blectlr_hci_evt_disconn_complete {
+	uint8_t status;
+	uint8_t handle[2];
+	uint8_t reason;
+};
+
+/** @brief Encryption Change event parameters. */
+struct blectlr_hci_evt_encrypt_change {
+	uint8_t status;
+	uint8_t handle[2];
+	uint8_t encrypt;
+};
+
+/** @brief Read Remote Version Information Complete event parameters. */
+struct blectlr_hci_evt_remote_version_info {
+	uint8_t status;
+	uint8_t handle[2];
+	uint8_t version;
+	uint8_t manufacturer[2];
+	uint8_t subversion[2];
+};
+
+/** @brief Command Complete event parameters. */
+struct blectlr_hci_evt_cmd_complete {
+	uint8_t ncmd;
+	uint8_t opcode[2];
+	/** Return parameters, starting with the status for most commands. */
+	uint8_t params[];
+};
+
+/** @brief Command Status event parameters. */
+struct blectlr_hci_evt_cmd_status {
+	uint8_t status;
+	uint8_t ncmd;
+	uint8_t opcode[2];
+};
+
+/** @brief Hardware Error event parameters. */
+struct blectlr_hci_evt_hardware_error {
+	uint8_t hardware_code;
+};
+
+/** @brief Number Of Completed Packets event parameters. */
+struct blectlr_hci_evt_num_completed_packets {
+	uint8_t num_handles;
+	/** num_handles pairs of Connection_Handle and completed count. */
+	struct {
+		uint8_t handle[2];
+		uint8_t count[2];
+	} h[];
+};
+
+/** @brief Data Buffer Overflow event parameters. */
+struct blectlr_hci_evt_data_buf_overflow {
+	uint8_t link_type;
+};
+
+/** @brief Encryption Key Refresh Complete event parameters. */
+struct blectlr_hci_evt_encrypt_key_refresh_complete {
+	uint8_t status;
+	uint8_t handle[2];
+};
+
+/** @brief Authenticated Payload Timeout Expired event parameters. */
+struct blectlr_hci_evt_auth_payload_timeout_exp {
+	uint8_t handle[2];
+};
+
+/** @brief LE Connection Complete event parameters. */
+struct blectlr_hci_evt_le_conn_complete {
+	uint8_t status;
+	uint8_t handle[2];
+	uint8_t role;
+	uint8_t peer_addr_type;
+	uint8_t peer_addr[6];
+	uint8_t interval[2];
+	uint8_t latency[2];
+	uint8_t supv_timeout[2];
+	uint8_t clock_accuracy;
+};
+
+/** @brief LE Advertising Report event parameters.
+ *
+ * Iterate the reports with @ref blectlr_hci_adv_report_iter_init and
+ * @ref blectlr_hci_adv_report_next.
+ */
+struct blectlr_hci_evt_le_adv_report {
+	uint8_t num_reports;
+	uint8_t reports[];
+};
+
+/** @brief Single report within an LE Advertising Report event.
+ *
+ * The RSSI follows the data, see @ref blectlr_hci_adv_report_rssi.
+ */
+struct blectlr_hci_adv_report {
+	uint8_t evt_type;
+	uint8_t addr_type;
+	uint8_t addr[6];
+	uint8_t length;
+	uint8_t data[];
+};
+
+/** @brief Iterator over the reports of an LE Advertising Report event.
+ *
+ * @note The members are internal and must not be accessed directly.
+ */
+struct blectlr_hci_adv_report_iter {
+	uint8_t const *reports;
+	uint8_t len;
+	uint8_t pos;
+	uint8_t remaining;
+};
+
+/** @brief LE Connection Update Complete event parameters. */
+struct blectlr_hci_evt_le_conn_update_complete {
+	uint8_t status;
+	uint8_t handle[2];
+	uint8_t interval[2];
+	uint8_t latency[2];
+	uint8_t supv_timeout[2];
+};
+
+/** @brief LE Read Remote Features Complete event parameters. */
+struct blectlr_hci_evt_le_remote_feat_complete {
+	uint8_t status;
+	uint8_t handle[2];
+	uint8_t features[8];
+};
+
+/** @brief LE Long Term Key Request event parameters. */
+struct blectlr_hci_evt_le_ltk_request {
+	uint8_t handle[2];
+	uint8_t rand[8];
+	uint8_t ediv[2];
+};
+
+/** @brief LE Remote Connection Parameter Request event parameters. */
+struct blectlr_hci_evt_le_conn_param_req {
+	uint8_t handle[2];
+	uint8_t interval_min[2];
+	uint8_t interval_max[2];
+	uint8_t latency[2];
+	uint8_t timeout[2];
+};
+
+/** @brief LE Data Length Change event parameters. */
+struct blectlr_hci_evt_le_data_len_change {
+	uint8_t handle[2];
+	uint8_t max_tx_octets[2];
+	uint8_t max_tx_time[2];
+	uint8_t max_rx_octets[2];
+	uint8_t max_rx_time[2];
+};
+
+/** @brief LE Read Local P-256 Public Key Complete event parameters. */
+struct blectlr_hci_evt_le_p256_public_key_complete {
+	uint8_t status;
+	uint8_t key[64];
+};
+
+/** @brief LE Generate DHKey Complete event parameters. */
+struct blectlr_hci_evt_le_generate_dhkey_complete {
+	uint8_t status;
+	uint8_t dhkey[32];
+};
+
+/** @brief LE Enhanced Connection Complete event parameters. */
+struct blectlr_hci_evt_le_enh_conn_complete {
+	uint8_t status;
+	uint8_t handle[2];
+	uint8_t role;
+	uint8_t peer_addr_type;
+	uint8_t peer_addr[6];
+	uint8_t local_rpa[6];
+	uint8_t peer_rpa[6];
+	uint8_t interval[2];
+	uint8_t latency[2];
+	uint8_t supv_timeout[2];
+	uint8_t clock_accuracy;
+};
+
+/** @brief LE Directed Advertising Report event parameters. */
+struct blectlr_hci_evt_le_direct_adv_report {
+	uint8_t num_reports;
+	/** num_reports fixed-size reports. */
+	struct {
+		uint8_t evt_type;
+		uint8_t addr_type;
+		uint8_t addr[6];
+		uint8_t dir_addr_type;
+		uint8_t dir_addr[6];
+		int8_t rssi;
+	} reports[];
+};
+
+/** @brief LE PHY Update Complete event parameters. */
+struct blectlr_hci_evt_le_phy_update_complete {
+	uint8_t status;
+	uint8_t handle[2];
+	uint8_t tx_phy;
+	uint8_t rx_phy;
+};
+
+/** @brief LE Channel Selection Algorithm event parameters. */
+struct blectlr_hci_evt_le_chan_sel_algo {
+	uint8_t handle[2];
+	uint8_t chan_sel_algo;
+};
+
+/** @brief Decoded event. */
+struct blectlr_hci_evt {
+	/** Event identifier. */
+	enum blectlr_hci_evt_id id;
+	/** Event code of the packet. */
+	uint8_t code;
+	/** Subevent code for LE Meta events, 0 otherwise. */
+	uint8_t subevent;
+	/** Length of the parameters pointed to by @ref params. */
+	uint8_t len;
+	/** Event parameters, to be cast to the view matching @ref id. For LE
+	 *  Meta events, the subevent code is not part of the parameters.
+	 */
+	void const *params;
+};
+
+/**
+ * @brief      Event handler.
+ *
+ * @param[in]  context  Context given to @ref blectlr_hci_evt_dispatch.
+ * @param[in]  evt      Decoded event.
+ */
+typedef void (*blectlr_hci_evt_handler_t)(void *context,
+					  struct blectlr_hci_evt const *evt);
+
+/**
+ * @brief      Read a little-endian 16-bit field of a view.
+ *
+ * @param[in]  field  The field.
+ *
+ * @return     Field value.
+ */
+static inline uint16_t blectlr_hci_le16(uint8_t const field[2])
+{
+	return (uint16_t)(field[0] | (field[1] << 8));
+}
+
+/**
+ * @brief      Decode an HCI event packet.
+ *
+ * @param[in]  buffer  HCI event packet as returned by @ref hci_event_packet_get.
+ * @param[out] evt     Decoded event. For events that are not known, or that
+ *                     are shorter than their minimum length, @p evt->id is
+ *                     @ref BLECTLR_HCI_EVT_UNKNOWN while the remaining
+ *                     members are still set.
+ *
+ * @return     The event identifier.
+ */
+enum blectlr_hci_evt_id blectlr_hci_evt_decode(hci_element_t const *buffer,
+					       struct blectlr_hci_evt *evt);
+
+/**
+ * @brief      Decode an HCI event packet and call its handler.
+ *
+ * @param[in]  handlers  Table of @ref BLECTLR_HCI_EVT_COUNT handlers indexed by
+ *                       @ref blectlr_hci_evt_id. Entries can be NULL. The
+ *                       @ref BLECTLR_HCI_EVT_UNKNOWN entry receives all events
+ *                       that are not decoded.
+ * @param[in]  context   Context passed to the handler.
+ * @param[in]  buffer    HCI event packet as returned by @ref hci_event_packet_get.
+ *
+ * @return     True if a handler was called.
+ */
+bool blectlr_hci_evt_dispatch(blectlr_hci_evt_handler_t const *handlers,
+			      void *context, hci_element_t const *buffer);
+
+/**
+ * @brief      Start iterating the reports of an LE Advertising Report event.
+ *
+ * @param[out] iter  Iterator.
+ * @param[in]  evt   Decoded @ref BLECTLR_HCI_EVT_LE_ADV_REPORT event.
+ */
+void blectlr_hci_adv_report_iter_init(struct blectlr_hci_adv_report_iter *iter,
+				      struct blectlr_hci_evt const *evt);
+
+/**
+ * @brief      Get the next report of an LE Advertising Report event.
+ *
+ * Each call costs the same, whatever the number of reports already returned.
+ *
+ * @param[in,out] iter  Iterator set up with
+ *                      @ref blectlr_hci_adv_report_iter_init.
+ *
+ * @return     The next report, or NULL after Num_Reports reports or if the
+ *             next report does not fit in the event.
+ */
+struct blectlr_hci_adv_report const *
+blectlr_hci_adv_report_next(struct blectlr_hci_adv_report_iter *iter);
+
+/**
+ * @brief      Get the RSSI of an advertising report.
+ *
+ * @param[in]  report  Report returned by @ref blectlr_hci_adv_report_next.
+ *
+ * @return     RSSI in dBm.
+ */
+static inline int8_t
+blectlr_hci_adv_report_rssi(struct blectlr_hci_adv_report const *report)
+{
+	return (int8_t)report->data[report->length];
+}
+
+/** @} **/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLECTLR_HCI_EVT_H__ */
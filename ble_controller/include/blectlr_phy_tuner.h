@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef BLECTLR_PHY_TUNER_H__
+#define BLECTLR_PHY_TUNER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup blectlr_phy_tuner
+ * @{
+ *
+ * @brief Per-connection PHY and data length tuner.
+ *
+ * The tuner is a host-side policy engine. The host periodically feeds it
+ * link quality samples for a connection: RSSI (for example from
+ * HCI Read RSSI), the number of received packets and of packets with CRC
+ * errors, and the number of payload bytes transferred. Based on these, the
+ * tuner selects the PHY and the maximum transmit data length, and issues
+ * HCI LE Set PHY and HCI LE Set Data Length commands when a change is
+ * needed.
+ *
+ * The data length grows while the link is clean and traffic flows, as long
+ * as it pays off: if the bytes transferred in the first sample after a
+ * longer data length took effect are not more than in the sample before
+ * it, the tuner goes back to the previous length and stays at or below it
+ * until the PHY changes or @ref BLECTLR_PHY_TUNER_CEILING_SAMPLES samples
+ * have passed.
+ *
+ * A new setting is only used once the Controller reports it, through
+ * @ref blectlr_phy_tuner_phy_updated and
+ * @ref blectlr_phy_tuner_data_len_changed. Until then, no new command of
+ * the same kind is issued. A command the Controller rejects, reported
+ * through @ref blectlr_phy_tuner_cmd_status, or one without a report
+ * within @ref BLECTLR_PHY_TUNER_PENDING_SAMPLES samples, is given up.
+ *
+ * A decision has to be reached in @ref blectlr_phy_tuner_cfg::stable_samples
+ * consecutive samples before it is applied, and RSSI thresholds are applied
+ * with @ref blectlr_phy_tuner_cfg::hysteresis_db of hysteresis, so the link
+ * does not oscillate between two settings.
+ *
+ * @note The helper is not reentrant. All functions operating on the same
+ *       tuner must be called from the same execution context.
+ **/
+
+/** @brief PHY bit for LE 1M. */
+#define BLECTLR_PHY_1M    (0x01)
+
+/** @brief PHY bit for LE 2M. */
+#define BLECTLR_PHY_2M    (0x02)
+
+/** @brief PHY bit for LE Coded. */
+#define BLECTLR_PHY_CODED (0x04)
+
+/** @brief The smallest transmit data length allowed by the specification. */
+#define BLECTLR_DATA_LEN_MIN (27)
+
+/** @brief Samples after which a command without a report is given up. */
+#define BLECTLR_PHY_TUNER_PENDING_SAMPLES (8)
+
+/** @brief Samples after which a data length that did not pay off is tried
+ *         again.
+ */
+#define BLECTLR_PHY_TUNER_CEILING_SAMPLES (64)
+
+/** @brief Tuner configuration. */
+struct blectlr_phy_tuner_cfg {
+	/** Switch to LE 2M above this RSSI. */
+	int8_t rssi_2m_dbm;
+	/** Switch to LE Coded below this RSSI. */
+	int8_t rssi_coded_dbm;
+	/** Hysteresis applied around the RSSI thresholds. */
+	uint8_t hysteresis_db;
+	/** CRC error rate, in percent, above which the link is degraded. */
+	uint8_t crc_err_pct_max;
+	/** Number of consecutive samples agreeing on a decision. */
+	uint8_t stable_samples;
+	/** PHYs the tuner may use, as a combination of BLECTLR_PHY_* bits. */
+	uint8_t phys;
+	/** Upper bound for the transmit data length. */
+	uint16_t data_len_max;
+};
+
+/** @brief Link quality sample for one evaluation period. */
+struct blectlr_phy_tuner_sample {
+	int8_t rssi_dbm;      /**< Averaged RSSI in the period. */
+	uint32_t rx_ok;       /**< Packets received with a valid CRC. */
+	uint32_t rx_crc_err;  /**< Packets received with a CRC error. */
+	uint32_t bytes;       /**< Payload bytes transferred. */
+};
+
+/** @brief Tuner statistics. */
+struct blectlr_phy_tuner_stats {
+	uint32_t samples;          /**< Samples evaluated. */
+	uint32_t phy_changes;      /**< HCI LE Set PHY commands issued. */
+	uint32_t data_len_changes; /**< HCI LE Set Data Length commands issued. */
+	uint32_t cmd_failures;     /**< Commands the Controller did not accept. */
+	uint32_t cmd_timeouts;     /**< Commands given up without a report. */
+	uint32_t data_len_reverts; /**< Longer data lengths that did not pay off. */
+	uint32_t last_bytes;       /**< Goodput of the last sample. */
+	uint8_t last_crc_err_pct;  /**< CRC error rate of the last sample. */
+};
+
+/** @brief Per-connection tuner.
+ *
+ * @note The members are internal and must not be accessed directly.
+ */
+struct blectlr_phy_tuner {
+	struct blectlr_phy_tuner_cfg cfg;
+	struct blectlr_phy_tuner_stats stats;
+	uint16_t conn_handle;
+	uint16_t data_len;
+	uint16_t data_len_candidate;
+	uint16_t data_len_requested;
+	uint16_t data_len_prev;
+	uint16_t data_len_ceiling;
+	uint32_t bytes_ref;
+	uint8_t phy;
+	uint8_t phy_candidate;
+	uint8_t phy_votes;
+	uint8_t data_len_votes;
+	uint8_t phy_pending_samples;
+	uint8_t data_len_pending_samples;
+	uint8_t ceiling_samples;
+	bool phy_pending;
+	bool data_len_pending;
+	bool data_len_probe;
+};
+
+/**
+ * @brief      Fill a tuner configuration with default values.
+ *
+ * @param[out] cfg  Configuration to fill.
+ */
+void blectlr_phy_tuner_cfg_default(struct blectlr_phy_tuner_cfg *cfg);
+
+/**
+ * @brief      Initialize a tuner for a connection.
+ *
+ * The connection is assumed to use LE 1M and the minimum data length.
+ *
+ * @param[out] tuner        Tuner to initialize.
+ * @param[in]  conn_handle  Connection handle.
+ * @param[in]  cfg          Configuration. Copied by the tuner.
+ *
+ * @retval ::NRF_SUCCESS              Initialized successfully.
+ * @retval ::NRF_ERROR_NULL           @p tuner or @p cfg is NULL.
+ * @retval ::NRF_ERROR_INVALID_PARAM  Invalid configuration.
+ */
+uint32_t blectlr_phy_tuner_init(struct blectlr_phy_tuner *tuner,
+				uint16_t conn_handle,
+				struct blectlr_phy_tuner_cfg const *cfg);
+
+/**
+ * @brief      Evaluate a link quality sample.
+ *
+ * Issues HCI commands if the sample completes a decision.
+ *
+ * @param[in]  tuner   Tuner.
+ * @param[in]  sample  Link quality sample.
+ *
+ * @retval ::NRF_SUCCESS     Sample evaluated.
+ * @retval ::NRF_ERROR_NULL  @p tuner or @p sample is NULL.
+ * @retval ::NRF_ERROR_BUSY  The Controller did not accept a command. The
+ *                           decision is retried on the next sample.
+ */
+uint32_t blectlr_phy_tuner_sample(struct blectlr_phy_tuner *tuner,
+				  struct blectlr_phy_tuner_sample const *sample);
+
+/**
+ * @brief      Report the PHY in use after an LE PHY Update Complete event.
+ *
+ * @param[in]  tuner   Tuner.
+ * @param[in]  tx_phy  TX_PHY field of the event: 1 for LE 1M, 2 for LE 2M
+ *                     and 3 for LE Coded.
+ */
+void blectlr_phy_tuner_phy_updated(struct blectlr_phy_tuner *tuner,
+				   uint8_t tx_phy);
+
+/**
+ * @brief      Report the data length in use after an LE Data Length Change
+ *             event.
+ *
+ * @param[in]  tuner          Tuner.
+ * @param[in]  max_tx_octets  MaxTxOctets field of the event.
+ */
+void blectlr_phy_tuner_data_len_changed(struct blectlr_phy_tuner *tuner,
+					uint16_t max_tx_octets);
+
+/**
+ * @brief      Report the status of a command issued by the tuner.
+ *
+ * Call it with the Command Status event of HCI LE Set PHY and the Command
+ * Complete event of HCI LE Set Data Length for the connection of the tuner.
+ * Other opcodes are ignored.
+ *
+ * @param[in]  tuner   Tuner.
+ * @param[in]  opcode  Command opcode.
+ * @param[in]  status  Status of the event. A non-zero status gives up the
+ *                     command, and the decision is retried on later samples.
+ */
+void blectlr_phy_tuner_cmd_status(struct blectlr_phy_tuner *tuner,
+				  uint16_t opcode, uint8_t status);
+
+/**
+ * @brief      Get the tuner statistics.
+ *
+ * @param[in]  tuner  Tuner.
+ *
+ * @return     Pointer to the statistics.
+ */
+struct blectlr_phy_tuner_stats const *
+blectlr_phy_tuner_stats_get(struct blectlr_phy_tuner const *tuner);
+
+/** @} **/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLECTLR_PHY_TUNER_H__ */
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef BLECTLR_SYNC_H__
+#define BLECTLR_SYNC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "nrf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup blectlr_sync
+ * @{
+ *
+ * @brief Lock-free primitives for sharing state between the radio timeslot
+ *        signal callback and thread context.
+ *
+ * The signal callback runs at interrupt priority 0, so masking interrupts
+ * around shared state delays it and adds jitter to radio timing. The
+ * primitives below never mask interrupts:
+ *
+ *  - A single-producer, single-consumer queue of fixed-size elements. The
+ *    producer and the consumer may run at any priority relative to each other.
+ *  - A sequence lock, for state written by one context and read by others.
+ *    Readers retry if the writer updated the state while they were reading,
+ *    so the writer must not be preempted by a reader, which typically means
+ *    the writer is the signal callback.
+ *
+ * For mutual exclusion, see nrf_mutex_try_lock() in nrf_soc.h.
+ **/
+
+/** @brief Single-producer, single-consumer queue.
+ *
+ * @note The members are internal and must not be accessed directly.
+ */
+struct blectlr_spsc {
+	uint8_t *buf;
+	uint16_t elem_size;
+	uint16_t mask;
+	volatile uint32_t head;
+	volatile uint32_t tail;
+};
+
+/**
+ * @brief      Initialize a queue.
+ *
+ * @param[out] q          Queue to initialize.
+ * @param[in]  buf        Storage for @p capacity elements of @p elem_size bytes.
+ * @param[in]  elem_size  Size of one element.
+ * @param[in]  capacity   Number of elements. Must be a power of two.
+ *
+ * @retval true   Initialized successfully.
+ * @retval false  @p capacity is not a power of two.
+ */
+static inline bool blectlr_spsc_init(struct blectlr_spsc *q, void *buf,
+				     uint16_t elem_size, uint16_t capacity)
+{
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+		return false;
+	}
+
+	q->buf = buf;
+	q->elem_size = elem_size;
+	q->mask = capacity - 1;
+	q->head = 0;
+	q->tail = 0;
+
+	return true;
+}
+
+/**
+ * @brief      Add an element to the queue. Producer only.
+ *
+ * @param[in]  q     Queue.
+ * @param[in]  elem  Element to copy into the queue.
+ *
+ * @retval true   Element added.
+ * @retval false  Queue full.
+ */
+static inline bool blectlr_spsc_put(struct blectlr_spsc *q, void const *elem)
+{
+	uint32_t head = q->head;
+
+	if (head - q->tail > q->mask) {
+		return false;
+	}
+
+	memcpy(&q->buf[(head & q->mask) * q->elem_size], elem, q->elem_size);
+
+	/* Publish the element before the index. */
+	__DMB();
+	q->head = head + 1;
+
+	return true;
+}
+
+/**
+ * @brief      Remove an element from the queue. Consumer only.
+ *
+ * @param[in]  q     Queue.
+ * @param[out] elem  Buffer receiving the element.
+ *
+ * @retval true   Element removed.
+ * @retval false  Queue empty.
+ */
+static inline bool blectlr_spsc_get(struct blectlr_spsc *q, void *elem)
+{
+	uint32_t tail = q->tail;
+
+	if (tail == q->head) {
+		return false;
+	}
+
+	/* Read the element only after observing the index. */
+	__DMB();
+	memcpy(elem, &q->buf[(tail & q->mask) * q->elem_size], q->elem_size);
+
+	/* Release the slot only after the element has been read. */
+	__DMB();
+	q->tail = tail + 1;
+
+	return true;
+}
+
+/**
+ * @brief      Check whether the queue is empty.
+ *
+ * @param[in]  q  Queue.
+ *
+ * @return     True if the queue is empty.
+ */
+static inline bool blectlr_spsc_is_empty(struct blectlr_spsc const *q)
+{
+	return q->head == q->tail;
+}
+
+/** @brief Sequence lock. Zero-initialize before use. */
+struct blectlr_seqlock {
+	volatile uint32_t seq;
+};
+
+/**
+ * @brief      Start updating the protected state.
+ *
+ * @param[in]  lock  Lock.
+ */
+static inline void blectlr_seqlock_write_begin(struct blectlr_seqlock *lock)
+{
+	lock->seq++;
+	__DMB();
+}
+
+/**
+ * @brief      Finish updating the protected state.
+ *
+ * @param[in]  lock  Lock.
+ */
+static inline void blectlr_seqlock_write_end(struct blectlr_seqlock *lock)
+{
+	__DMB();
+	lock->seq++;
+}
+
+/**
+ * @brief      Start reading the protected state.
+ *
+ * @param[in]  lock  Lock.
+ *
+ * @return     Sequence number to pass to @ref blectlr_seqlock_read_retry.
+ */
+static inline uint32_t blectlr_seqlock_read_begin(struct blectlr_seqlock const *lock)
+{
+	uint32_t seq = lock->seq;
+
+	__DMB();
+	return seq;
+}
+
+/**
+ * @brief      Check whether the state read since
+ *             @ref blectlr_seqlock_read_begin must be read again.
+ *
+ * @param[in]  lock  Lock.
+ * @param[in]  seq   Value returned by @ref blectlr_seqlock_read_begin.
+ *
+ * @retval true   The state was updated while reading, read it again.
+ * @retval false  The state read is consistent.
+ */
+static inline bool blectlr_seqlock_read_retry(struct blectlr_seqlock const *lock,
+					      uint32_t seq)
+{
+	__DMB();
+	return (seq & 1) || lock->seq != seq;
+}
+
+/** @} **/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLECTLR_SYNC_H__ */
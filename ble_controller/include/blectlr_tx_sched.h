@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef BLECTLR_TX_SCHED_H__
+#define BLECTLR_TX_SCHED_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "blectlr_hci.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup blectlr_tx_sched
+ * @{
+ *
+ * @brief Weighted ACL data scheduler in front of @ref hci_data_packet_put.
+ *
+ * The Controller serves the ACL data it has accepted in FIFO order per
+ * connection. The scheduler keeps the host's data queued per connection and
+ * only hands a packet to the Controller when a Controller buffer is free.
+ * Which connection gets the next free buffer is decided by a smooth weighted
+ * round robin over the connections with queued data, where the weight is
+ * given by the priority class of the connection.
+ *
+ * In addition, a number of Controller buffers can be reserved for
+ * @ref BLECTLR_TX_PRIO_HIGH connections, so that bulk transfers on lower
+ * priority connections can never occupy all Controller buffers.
+ *
+ * The host must report freed Controller buffers from the HCI Number Of
+ * Completed Packets event through @ref blectlr_tx_sched_completed.
+ *
+ * @note The scheduler is not reentrant. All functions operating on the same
+ *       scheduler must be called from the same execution context.
+ **/
+
+#ifndef BLECTLR_TX_SCHED_CONN_MAX
+/** @brief The maximum number of connections handled by a scheduler. */
+#define BLECTLR_TX_SCHED_CONN_MAX (3)
+#endif
+
+/** @brief Connection priority classes. */
+enum blectlr_tx_prio {
+	BLECTLR_TX_PRIO_LOW,    /**< Bulk data, for example DFU. Weight 1. */
+	BLECTLR_TX_PRIO_NORMAL, /**< Default class. Weight 4. */
+	BLECTLR_TX_PRIO_HIGH,   /**< Latency-critical data, for example HID. Weight 16. */
+	BLECTLR_TX_PRIO_COUNT
+};
+
+/** @brief Queued ACL data packet.
+ *
+ * Provided by the caller and owned by the scheduler until passed back through
+ * @ref blectlr_tx_sched_done_t.
+ */
+struct blectlr_tx_sched_pkt {
+	/** Internal. */
+	struct blectlr_tx_sched_pkt *next;
+	/** HCI data packet in octet format, including the header. */
+	hci_element_t const *buffer;
+};
+
+/**
+ * @brief      Function called when the scheduler releases a packet.
+ *
+ * @param[in]  pkt   The released packet.
+ * @param[in]  sent  True if the packet was accepted by the Controller, false
+ *                   if it was dropped because its connection was removed.
+ */
+typedef void (*blectlr_tx_sched_done_t)(struct blectlr_tx_sched_pkt *pkt,
+					bool sent);
+
+/** @brief Per-connection scheduler state.
+ *
+ * @note The members are internal and must not be accessed directly.
+ */
+struct blectlr_tx_sched_conn {
+	struct blectlr_tx_sched_pkt *head;
+	struct blectlr_tx_sched_pkt *tail;
+	int32_t current;
+	uint16_t handle;
+	uint16_t in_flight;
+	uint8_t prio;
+	bool used;
+};
+
+/** @brief Scheduler.
+ *
+ * @note The members are internal and must not be accessed directly.
+ */
+struct blectlr_tx_sched {
+	struct blectlr_tx_sched_conn conn[BLECTLR_TX_SCHED_CONN_MAX];
+	blectlr_tx_sched_done_t done;
+	uint16_t credits;
+	uint16_t reserved;
+};
+
+/**
+ * @brief      Initialize a scheduler.
+ *
+ * @param[out] sched     Scheduler to initialize.
+ * @param[in]  credits   Number of Controller ACL data buffers, as returned by
+ *                       HCI LE Read Buffer Size.
+ * @param[in]  reserved  Number of Controller buffers only
+ *                       @ref BLECTLR_TX_PRIO_HIGH connections may use.
+ * @param[in]  done      Function called when a packet is released.
+ *
+ * @retval ::NRF_SUCCESS              Initialized successfully.
+ * @retval ::NRF_ERROR_NULL           @p sched or @p done is NULL.
+ * @retval ::NRF_ERROR_INVALID_PARAM  @p reserved is not smaller than @p credits.
+ */
+uint32_t blectlr_tx_sched_init(struct blectlr_tx_sched *sched,
+			       uint16_t credits, uint16_t reserved,
+			       blectlr_tx_sched_done_t done);
+
+/**
+ * @brief      Add a connection to the scheduler.
+ *
+ * @param[in]  sched   Scheduler.
+ * @param[in]  handle  Connection handle.
+ * @param[in]  prio    Priority class, see @ref blectlr_tx_prio.
+ *
+ * @retval ::NRF_SUCCESS              Connection added.
+ * @retval ::NRF_ERROR_INVALID_PARAM  Invalid priority class.
+ * @retval ::NRF_ERROR_INVALID_STATE  The connection is already added.
+ * @retval ::NRF_ERROR_NO_MEM         @ref BLECTLR_TX_SCHED_CONN_MAX reached.
+ */
+uint32_t blectlr_tx_sched_conn_add(struct blectlr_tx_sched *sched,
+				   uint16_t handle, enum blectlr_tx_prio prio);
+
+/**
+ * @brief      Change the priority class of a connection.
+ *
+ * @param[in]  sched   Scheduler.
+ * @param[in]  handle  Connection handle.
+ * @param[in]  prio    Priority class, see @ref blectlr_tx_prio.
+ *
+ * @retval ::NRF_SUCCESS              Priority class changed.
+ * @retval ::NRF_ERROR_INVALID_PARAM  Invalid priority class.
+ * @retval ::NRF_ERROR_NOT_FOUND      Unknown connection.
+ */
+uint32_t blectlr_tx_sched_conn_prio_set(struct blectlr_tx_sched *sched,
+					uint16_t handle,
+					enum blectlr_tx_prio prio);
+
+/**
+ * @brief      Remove a connection after it has been disconnected.
+ *
+ * Queued packets are released with the sent flag set to false. Controller
+ * buffers held by the connection are returned to the scheduler, as the
+ * Controller frees them on disconnection.
+ *
+ * @param[in]  sched   Scheduler.
+ * @param[in]  handle  Connection handle.
+ *
+ * @retval ::NRF_SUCCESS          Connection removed.
+ * @retval ::NRF_ERROR_NOT_FOUND  Unknown connection.
+ */
+uint32_t blectlr_tx_sched_conn_remove(struct blectlr_tx_sched *sched,
+				      uint16_t handle);
+
+/**
+ * @brief      Queue an ACL data packet.
+ *
+ * The connection handle is taken from the packet header. The packet is not
+ * sent until @ref blectlr_tx_sched_run is called.
+ *
+ * @param[in]  sched  Scheduler.
+ * @param[in]  pkt    Packet to queue.
+ *
+ * @retval ::NRF_SUCCESS          Packet queued.
+ * @retval ::NRF_ERROR_NULL       @p pkt or its buffer is NULL.
+ * @retval ::NRF_ERROR_NOT_FOUND  Unknown connection.
+ */
+uint32_t blectlr_tx_sched_put(struct blectlr_tx_sched *sched,
+			      struct blectlr_tx_sched_pkt *pkt);
+
+/**
+ * @brief      Hand queued packets to the Controller.
+ *
+ * Sends packets until no Controller buffer is available to any connection
+ * with queued data, or the Controller rejects a packet.
+ *
+ * @param[in]  sched  Scheduler.
+ *
+ * @return     The number of packets sent.
+ */
+uint32_t blectlr_tx_sched_run(struct blectlr_tx_sched *sched);
+
+/**
+ * @brief      Report Controller buffers freed by a connection.
+ *
+ * Call for each handle in the HCI Number Of Completed Packets event.
+ *
+ * @param[in]  sched   Scheduler.
+ * @param[in]  handle  Connection handle.
+ * @param[in]  count   Number of completed packets.
+ */
+void blectlr_tx_sched_completed(struct blectlr_tx_sched *sched,
+				uint16_t handle, uint16_t count);
+
+/** @} **/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLECTLR_TX_SCHED_H__ */
@@ -9,6 +9,7 @@
 #define NRF_SOC_H__
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "nrf.h"
 #include "nrf_error.h"
 
@@ -276,6 +277,55 @@ uint32_t sd_radio_session_close(void);
  */
 uint32_t sd_radio_request(nrf_radio_request_t const * p_request);
 
+/**@brief Initializes a mutex to the unlocked state.
+ *
+ * @param[in] p_mutex Pointer to the mutex to initialize.
+ */
+static inline void nrf_mutex_init(nrf_mutex_t * p_mutex)
+{
+  *p_mutex = 0;
+  __DMB();
+}
+
+/**@brief Attempts to lock a mutex without blocking.
+ *
+ * The mutex is taken with an exclusive load/store pair (LDREXB/STREXB), so interrupts are never
+ * masked. It can be used from thread context and from the radio timeslot signal callback alike.
+ *
+ * @note The function never waits for the mutex to be released. A context that preempts the owner
+ *       must not spin on this function, as the owner cannot run until the preempting context
+ *       returns.
+ *
+ * @param[in] p_mutex Pointer to the mutex to lock.
+ *
+ * @retval true  The mutex was locked by the caller.
+ * @retval false The mutex is held by another context.
+ */
+static inline bool nrf_mutex_try_lock(nrf_mutex_t * p_mutex)
+{
+  do
+  {
+    if (__LDREXB(p_mutex) != 0)
+    {
+      __CLREX();
+      return false;
+    }
+  } while (__STREXB(1, p_mutex) != 0);
+
+  __DMB();
+  return true;
+}
+
+/**@brief Unlocks a mutex locked with @ref nrf_mutex_try_lock.
+ *
+ * @param[in] p_mutex Pointer to the mutex to unlock.
+ */
+static inline void nrf_mutex_unlock(nrf_mutex_t * p_mutex)
+{
+  __DMB();
+  *p_mutex = 0;
+}
+
 /**@} */
 
 #ifdef __cplusplus
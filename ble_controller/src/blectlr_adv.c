@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+
+#include "blectlr_adv.h"
+#include "blectlr_hci.h"
+#include "nrf_error.h"
+
+#define HCI_OPCODE_LE_SET_ADV_DATA      (0x2008)
+#define HCI_OPCODE_LE_SET_SCAN_RSP_DATA (0x2009)
+
+/* Length octet followed by the zero padded payload. */
+#define ADV_DATA_CMD_PARAM_SIZE (1 + BLECTLR_ADV_DATA_MAX_SIZE)
+
+static uint8_t staging_idx(struct blectlr_adv_data const *adv)
+{
+	return adv->active ^ 1;
+}
+
+static uint16_t cmd_opcode(struct blectlr_adv_data const *adv)
+{
+	return (adv->type == BLECTLR_ADV_DATA_TYPE_SCAN_RSP) ?
+	       HCI_OPCODE_LE_SET_SCAN_RSP_DATA : HCI_OPCODE_LE_SET_ADV_DATA;
+}
+
+uint32_t blectlr_adv_data_init(struct blectlr_adv_data *adv,
+			       enum blectlr_adv_data_type type,
+			       uint8_t const *data, uint8_t len)
+{
+	if (!adv || (!data && len)) {
+		return NRF_ERROR_NULL;
+	}
+
+	if (type != BLECTLR_ADV_DATA_TYPE_ADV &&
+	    type != BLECTLR_ADV_DATA_TYPE_SCAN_RSP) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+
+	if (len > BLECTLR_ADV_DATA_MAX_SIZE) {
+		return NRF_ERROR_INVALID_LENGTH;
+	}
+
+	memset(adv, 0, sizeof(*adv));
+	adv->type = type;
+	if (len) {
+		memcpy(adv->buf[0], data, len);
+	}
+	adv->len[0] = len;
+
+	return NRF_SUCCESS;
+}
+
+uint32_t blectlr_adv_data_stage(struct blectlr_adv_data *adv,
+				uint8_t const *data, uint8_t len)
+{
+	uint8_t idx;
+
+	if (!adv || (!data && len)) {
+		return NRF_ERROR_NULL;
+	}
+
+	if (len > BLECTLR_ADV_DATA_MAX_SIZE) {
+		return NRF_ERROR_INVALID_LENGTH;
+	}
+
+	if (adv->pending) {
+		return NRF_ERROR_INVALID_STATE;
+	}
+
+	idx = staging_idx(adv);
+	memset(adv->buf[idx], 0, BLECTLR_ADV_DATA_MAX_SIZE);
+	if (len) {
+		memcpy(adv->buf[idx], data, len);
+	}
+	adv->len[idx] = len;
+	adv->staged = true;
+
+	return NRF_SUCCESS;
+}
+
+uint32_t blectlr_adv_data_patch(struct blectlr_adv_data *adv, uint8_t offset,
+				uint8_t const *data, uint8_t len)
+{
+	uint8_t idx;
+
+	if (!adv || !data) {
+		return NRF_ERROR_NULL;
+	}
+
+	if (adv->pending) {
+		return NRF_ERROR_INVALID_STATE;
+	}
+
+	idx = staging_idx(adv);
+	if (!adv->staged) {
+		memcpy(adv->buf[idx], adv->buf[adv->active],
+		       BLECTLR_ADV_DATA_MAX_SIZE);
+		adv->len[idx] = adv->len[adv->active];
+	}
+
+	if ((uint16_t)offset + len > adv->len[idx]) {
+		return NRF_ERROR_INVALID_LENGTH;
+	}
+
+	memcpy(&adv->buf[idx][offset], data, len);
+	adv->staged = true;
+
+	return NRF_SUCCESS;
+}
+
+uint32_t blectlr_adv_data_commit(struct blectlr_adv_data *adv)
+{
+	uint8_t cmd[HCI_CMD_HEADER_SIZE + ADV_DATA_CMD_PARAM_SIZE];
+	uint16_t opcode;
+	uint8_t idx;
+
+	if (!adv) {
+		return NRF_ERROR_NULL;
+	}
+
+	if (adv->pending) {
+		return NRF_ERROR_INVALID_STATE;
+	}
+
+	if (!adv->staged) {
+		return NRF_SUCCESS;
+	}
+
+	idx = staging_idx(adv);
+	if (adv->len[idx] == adv->len[adv->active] &&
+	    !memcmp(adv->buf[idx], adv->buf[adv->active], adv->len[idx])) {
+		/* Controller already holds this payload. */
+		adv->staged = false;
+		return NRF_SUCCESS;
+	}
+
+	opcode = cmd_opcode(adv);
+
+	cmd[0] = (uint8_t)opcode;
+	cmd[1] = (uint8_t)(opcode >> 8);
+	cmd[2] = ADV_DATA_CMD_PARAM_SIZE;
+	cmd[3] = adv->len[idx];
+	memcpy(&cmd[4], adv->buf[idx], BLECTLR_ADV_DATA_MAX_SIZE);
+
+	if (!hci_cmd_packet_put(cmd)) {
+		return NRF_ERROR_BUSY;
+	}
+
+	/* The staged buffer becomes active once the Controller accepts it. */
+	adv->pending = true;
+
+	return NRF_SUCCESS;
+}
+
+uint32_t blectlr_adv_data_cmd_complete(struct blectlr_adv_data *adv,
+				       uint16_t opcode, uint8_t status)
+{
+	if (!adv) {
+		return NRF_ERROR_NULL;
+	}
+
+	if (!adv->pending || opcode != cmd_opcode(adv)) {
+		return NRF_ERROR_NOT_FOUND;
+	}
+
+	adv->pending = false;
+	if (status == 0) {
+		adv->active = staging_idx(adv);
+		adv->staged = false;
+	}
+
+	return NRF_SUCCESS;
+}
+
+uint8_t const *blectlr_adv_data_active_get(struct blectlr_adv_data const *adv,
+					   uint8_t *len)
+{
+	if (len) {
+		*len = adv->len[adv->active];
+	}
+
+	return adv->buf[adv->active];
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stddef.h>
+
+#include "blectlr_hci_evt.h"
+
+#define HCI_EVT_LE_META       (0x3E)
+
+/* Size of the fixed part of a single advertising report, RSSI included. */
+#define ADV_REPORT_FIXED_SIZE (sizeof(struct blectlr_hci_adv_report) + 1)
+
+/* Identifier and minimum parameter length of an event, LE subevent code
+ * excluded. Both are read with a single lookup.
+ */
+struct evt_desc {
+	uint8_t id;
+	uint8_t min_len;
+};
+
+#define EVT_DESC(_id, _view) \
+	{ .id = (_id), .min_len = sizeof(struct _view) }
+
+static const struct evt_desc evt_descs[256] = {
+	[0x05] = EVT_DESC(BLECTLR_HCI_EVT_DISCONN_COMPLETE,
+			  blectlr_hci_evt_disconn_complete),
+	[0x08] = EVT_DESC(BLECTLR_HCI_EVT_ENCRYPT_CHANGE,
+			  blectlr_hci_evt_encrypt_change),
+	[0x0C] = EVT_DESC(BLECTLR_HCI_EVT_REMOTE_VERSION_INFO,
+			  blectlr_hci_evt_remote_version_info),
+	[0x0E] = EVT_DESC(BLECTLR_HCI_EVT_CMD_COMPLETE,
+			  blectlr_hci_evt_cmd_complete),
+	[0x0F] = EVT_DESC(BLECTLR_HCI_EVT_CMD_STATUS,
+			  blectlr_hci_evt_cmd_status),
+	[0x10] = EVT_DESC(BLECTLR_HCI_EVT_HARDWARE_ERROR,
+			  blectlr_hci_evt_hardware_error),
+	[0x13] = EVT_DESC(BLECTLR_HCI_EVT_NUM_COMPLETED_PACKETS,
+			  blectlr_hci_evt_num_completed_packets),
+	[0x1A] = EVT_DESC(BLECTLR_HCI_EVT_DATA_BUF_OVERFLOW,
+			  blectlr_hci_evt_data_buf_overflow),
+	[0x30] = EVT_DESC(BLECTLR_HCI_EVT_ENCRYPT_KEY_REFRESH_COMPLETE,
+			  blectlr_hci_evt_encrypt_key_refresh_complete),
+	[0x57] = EVT_DESC(BLECTLR_HCI_EVT_AUTH_PAYLOAD_TIMEOUT_EXP,
+			  blectlr_hci_evt_auth_payload_timeout_exp),
+};
+
+/* Covers every subevent code, so the code needs no range check. */
+static const struct evt_desc le_subevt_descs[256] = {
+	[0x01] = EVT_DESC(BLECTLR_HCI_EVT_LE_CONN_COMPLETE,
+			  blectlr_hci_evt_le_conn_complete),
+	[0x02] = EVT_DESC(BLECTLR_HCI_EVT_LE_ADV_REPORT,
+			  blectlr_hci_evt_le_adv_report),
+	[0x03] = EVT_DESC(BLECTLR_HCI_EVT_LE_CONN_UPDATE_COMPLETE,
+			  blectlr_hci_evt_le_conn_update_complete),
+	[0x04] = EVT_DESC(BLECTLR_HCI_EVT_LE_REMOTE_FEAT_COMPLETE,
+			  blectlr_hci_evt_le_remote_feat_complete),
+	[0x05] = EVT_DESC(BLECTLR_HCI_EVT_LE_LTK_REQUEST,
+			  blectlr_hci_evt_le_ltk_request),
+	[0x06] = EVT_DESC(BLECTLR_HCI_EVT_LE_CONN_PARAM_REQ,
+			  blectlr_hci_evt_le_conn_param_req),
+	[0x07] = EVT_DESC(BLECTLR_HCI_EVT_LE_DATA_LEN_CHANGE,
+			  blectlr_hci_evt_le_data_len_change),
+	[0x08] = EVT_DESC(BLECTLR_HCI_EVT_LE_P256_PUBLIC_KEY_COMPLETE,
+			  blectlr_hci_evt_le_p256_public_key_complete),
+	[0x09] = EVT_DESC(BLECTLR_HCI_EVT_LE_GENERATE_DHKEY_COMPLETE,
+			  blectlr_hci_evt_le_generate_dhkey_complete),
+	[0x0A] = EVT_DESC(BLECTLR_HCI_EVT_LE_ENH_CONN_COMPLETE,
+			  blectlr_hci_evt_le_enh_conn_complete),
+	[0x0B] = EVT_DESC(BLECTLR_HCI_EVT_LE_DIRECT_ADV_REPORT,
+			  blectlr_hci_evt_le_direct_adv_report),
+	[0x0C] = EVT_DESC(BLECTLR_HCI_EVT_LE_PHY_UPDATE_COMPLETE,
+			  blectlr_hci_evt_le_phy_update_complete),
+	[0x14] = EVT_DESC(BLECTLR_HCI_EVT_LE_CHAN_SEL_ALGO,
+			  blectlr_hci_evt_le_chan_sel_algo),
+};
+
+enum blectlr_hci_evt_id blectlr_hci_evt_decode(hci_element_t const *buffer,
+					       struct blectlr_hci_evt *evt)
+{
+	struct evt_desc desc;
+
+	evt->code = buffer[0];
+	evt->subevent = 0;
+	evt->len = buffer[1];
+	evt->params = &buffer[HCI_EVENT_HEADER_SIZE];
+
+	if (evt->code == HCI_EVT_LE_META) {
+		if (evt->len < 1) {
+			evt->id = BLECTLR_HCI_EVT_UNKNOWN;
+			return evt->id;
+		}
+
+		evt->subevent = buffer[HCI_EVENT_HEADER_SIZE];
+		evt->len--;
+		evt->params = &buffer[HCI_EVENT_HEADER_SIZE + 1];
+		desc = le_subevt_descs[evt->subevent];
+	} else {
+		desc = evt_descs[evt->code];
+	}
+
+	evt->id = (evt->len < desc.min_len) ?
+		  BLECTLR_HCI_EVT_UNKNOWN : (enum blectlr_hci_evt_id)desc.id;
+
+	return evt->id;
+}
+
+bool blectlr_hci_evt_dispatch(blectlr_hci_evt_handler_t const *handlers,
+			      void *context, hci_element_t const *buffer)
+{
+	struct blectlr_hci_evt evt;
+	blectlr_hci_evt_handler_t handler;
+
+	handler = handlers[blectlr_hci_evt_decode(buffer, &evt)];
+	if (!handler) {
+		return false;
+	}
+
+	handler(context, &evt);
+
+	return true;
+}
+
+void blectlr_hci_adv_report_iter_init(struct blectlr_hci_adv_report_iter *iter,
+				      struct blectlr_hci_evt const *evt)
+{
+	struct blectlr_hci_evt_le_adv_report const *adv = evt->params;
+
+	iter->reports = adv->reports;
+	iter->len = evt->len - sizeof(*adv);
+	iter->remaining = adv->num_reports;
+	iter->pos = 0;
+}
+
+struct blectlr_hci_adv_report const *
+blectlr_hci_adv_report_next(struct blectlr_hci_adv_report_iter *iter)
+{
+	struct blectlr_hci_adv_report const *report;
+	size_t left = iter->len - iter->pos;
+
+	/* Reject a report that does not fit in the event. */
+	if (!iter->remaining || left < ADV_REPORT_FIXED_SIZE) {
+		return NULL;
+	}
+
+	report = (struct blectlr_hci_adv_report const *)&iter->reports[iter->pos];
+	if (left < ADV_REPORT_FIXED_SIZE + report->length) {
+		return NULL;
+	}
+
+	iter->pos += ADV_REPORT_FIXED_SIZE + report->length;
+	iter->remaining--;
+
+	return report;
+}
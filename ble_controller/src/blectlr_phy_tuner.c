@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+
+#include "blectlr_phy_tuner.h"
+#include "blectlr_hci.h"
+#include "nrf_error.h"
+
+#define HCI_OPCODE_LE_SET_DATA_LENGTH (0x2022)
+#define HCI_OPCODE_LE_SET_PHY         (0x2032)
+
+#define LE_SET_DATA_LENGTH_PARAM_SIZE (6)
+#define LE_SET_PHY_PARAM_SIZE         (7)
+
+/* PHY_Options: prefer S=8 coding on LE Coded. */
+#define LE_SET_PHY_OPTIONS_CODED_S8   (0x0002)
+
+/* Limits of the TX_Time parameter of HCI LE Set Data Length. */
+#define DATA_TIME_MIN_US (328)
+#define DATA_TIME_MAX_US (17040)
+
+/* PHYs ordered from most robust to fastest. */
+static const uint8_t phy_levels[] = {
+	BLECTLR_PHY_CODED,
+	BLECTLR_PHY_1M,
+	BLECTLR_PHY_2M,
+};
+
+static int phy_level(uint8_t phy)
+{
+	for (int i = 0; i < (int)sizeof(phy_levels); i++) {
+		if (phy_levels[i] == phy) {
+			return i;
+		}
+	}
+
+	return 1;
+}
+
+/* Air time of a data channel PDU carrying octets payload bytes and a MIC. */
+static uint32_t data_time_us(uint8_t phy, uint16_t octets)
+{
+	switch (phy) {
+	case BLECTLR_PHY_2M:
+		return 4 * (octets + 15);
+	case BLECTLR_PHY_CODED:
+		return 400 + 64 * (octets + 9);
+	default:
+		return 8 * (octets + 14);
+	}
+}
+
+static uint8_t phy_slowest(uint8_t phys)
+{
+	for (int i = 0; i < (int)sizeof(phy_levels); i++) {
+		if (phys & phy_levels[i]) {
+			return phy_levels[i];
+		}
+	}
+
+	return BLECTLR_PHY_1M;
+}
+
+static bool cmd_send(uint16_t opcode, uint8_t const *param, uint8_t len)
+{
+	uint8_t cmd[HCI_CMD_HEADER_SIZE + LE_SET_PHY_PARAM_SIZE];
+
+	cmd[0] = (uint8_t)opcode;
+	cmd[1] = (uint8_t)(opcode >> 8);
+	cmd[2] = len;
+	memcpy(&cmd[HCI_CMD_HEADER_SIZE], param, len);
+
+	return hci_cmd_packet_put(cmd);
+}
+
+static bool phy_set(struct blectlr_phy_tuner *tuner, uint8_t phy)
+{
+	uint16_t options = (phy == BLECTLR_PHY_CODED) ?
+			   LE_SET_PHY_OPTIONS_CODED_S8 : 0;
+	uint8_t param[LE_SET_PHY_PARAM_SIZE] = {
+		(uint8_t)tuner->conn_handle,
+		(uint8_t)(tuner->conn_handle >> 8),
+		0x00, /* ALL_PHYS: both TX and RX preferences given. */
+		phy,
+		phy,
+		(uint8_t)options,
+		(uint8_t)(options >> 8),
+	};
+
+	return cmd_send(HCI_OPCODE_LE_SET_PHY, param, sizeof(param));
+}
+
+static bool data_len_set(struct blectlr_phy_tuner *tuner, uint16_t octets)
+{
+	/* Size TX_Time for the slowest PHY the tuner may select, so that a
+	 * later PHY change does not shrink the effective data length.
+	 */
+	uint32_t time = data_time_us(phy_slowest(tuner->cfg.phys), octets);
+	uint8_t param[LE_SET_DATA_LENGTH_PARAM_SIZE];
+
+	if (time < DATA_TIME_MIN_US) {
+		time = DATA_TIME_MIN_US;
+	} else if (time > DATA_TIME_MAX_US) {
+		time = DATA_TIME_MAX_US;
+	}
+
+	param[0] = (uint8_t)tuner->conn_handle;
+	param[1] = (uint8_t)(tuner->conn_handle >> 8);
+	param[2] = (uint8_t)octets;
+	param[3] = (uint8_t)(octets >> 8);
+	param[4] = (uint8_t)time;
+	param[5] = (uint8_t)(time >> 8);
+
+	return cmd_send(HCI_OPCODE_LE_SET_DATA_LENGTH, param, sizeof(param));
+}
+
+static uint8_t phy_target(struct blectlr_phy_tuner const *tuner,
+			  int8_t rssi, bool degraded)
+{
+	struct blectlr_phy_tuner_cfg const *cfg = &tuner->cfg;
+	int cur = phy_level(tuner->phy);
+	int h = cfg->hysteresis_db;
+	int th_2m = cfg->rssi_2m_dbm + ((tuner->phy == BLECTLR_PHY_2M) ? -h : h);
+	int th_coded = cfg->rssi_coded_dbm +
+		       ((tuner->phy == BLECTLR_PHY_CODED) ? h : -h);
+	int level;
+
+	if (rssi >= th_2m) {
+		level = 2;
+	} else if (rssi < th_coded) {
+		level = 0;
+	} else {
+		level = 1;
+	}
+
+	/* Step down from the current PHY while the link is losing packets. */
+	if (degraded && level >= cur && cur > 0) {
+		level = cur - 1;
+	}
+
+	while (!(cfg->phys & phy_levels[level])) {
+		level += (level < 1) ? 1 : -1;
+	}
+
+	return phy_levels[level];
+}
+
+static uint16_t data_len_target(struct blectlr_phy_tuner const *tuner,
+				uint8_t err_pct, bool degraded, bool active)
+{
+	uint16_t len = tuner->data_len;
+
+	if (degraded) {
+		len /= 2;
+		if (len < BLECTLR_DATA_LEN_MIN) {
+			len = BLECTLR_DATA_LEN_MIN;
+		}
+	} else if (active && err_pct <= tuner->cfg.crc_err_pct_max / 2) {
+		len *= 2;
+	}
+
+	if (len > tuner->data_len_ceiling) {
+		len = tuner->data_len_ceiling;
+	}
+
+	return len;
+}
+
+void blectlr_phy_tuner_cfg_default(struct blectlr_phy_tuner_cfg *cfg)
+{
+	cfg->rssi_2m_dbm = -65;
+	cfg->rssi_coded_dbm = -90;
+	cfg->hysteresis_db = 4;
+	cfg->crc_err_pct_max = 10;
+	cfg->stable_samples = 3;
+	cfg->phys = BLECTLR_PHY_1M | BLECTLR_PHY_2M;
+	cfg->data_len_max = HCI_DATA_MAX_SIZE;
+}
+
+uint32_t blectlr_phy_tuner_init(struct blectlr_phy_tuner *tuner,
+				uint16_t conn_handle,
+				struct blectlr_phy_tuner_cfg const *cfg)
+{
+	if (!tuner || !cfg) {
+		return NRF_ERROR_NULL;
+	}
+
+	if (!(cfg->phys & BLECTLR_PHY_1M) ||
+	    (cfg->phys & ~(BLECTLR_PHY_1M | BLECTLR_PHY_2M | BLECTLR_PHY_CODED)) ||
+	    cfg->data_len_max < BLECTLR_DATA_LEN_MIN ||
+	    cfg->data_len_max > HCI_DATA_MAX_SIZE ||
+	    cfg->rssi_coded_dbm >= cfg->rssi_2m_dbm ||
+	    cfg->stable_samples == 0) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+
+	memset(tuner, 0, sizeof(*tuner));
+	tuner->cfg = *cfg;
+	tuner->conn_handle = conn_handle;
+	tuner->phy = BLECTLR_PHY_1M;
+	tuner->phy_candidate = BLECTLR_PHY_1M;
+	tuner->data_len = BLECTLR_DATA_LEN_MIN;
+	tuner->data_len_candidate = BLECTLR_DATA_LEN_MIN;
+	tuner->data_len_ceiling = cfg->data_len_max;
+
+	return NRF_SUCCESS;
+}
+
+/* Gives up commands the Controller has not reported on in time. */
+static void pending_expire(struct blectlr_phy_tuner *tuner)
+{
+	if (tuner->phy_pending &&
+	    ++tuner->phy_pending_samples >= BLECTLR_PHY_TUNER_PENDING_SAMPLES) {
+		tuner->phy_pending = false;
+		tuner->stats.cmd_timeouts++;
+	}
+
+	if (tuner->data_len_pending &&
+	    ++tuner->data_len_pending_samples >=
+	    BLECTLR_PHY_TUNER_PENDING_SAMPLES) {
+		tuner->data_len_pending = false;
+		tuner->stats.cmd_timeouts++;
+	}
+}
+
+/* Compares the goodput of the first sample after a longer data length took
+ * effect with the one before it, and caps the data length if it did not
+ * improve.
+ */
+static void data_len_probe_check(struct blectlr_phy_tuner *tuner,
+				 uint32_t bytes)
+{
+	if (tuner->data_len_ceiling < tuner->cfg.data_len_max &&
+	    ++tuner->ceiling_samples >= BLECTLR_PHY_TUNER_CEILING_SAMPLES) {
+		tuner->data_len_ceiling = tuner->cfg.data_len_max;
+	}
+
+	if (!tuner->data_len_probe) {
+		return;
+	}
+
+	tuner->data_len_probe = false;
+
+	if (bytes <= tuner->bytes_ref) {
+		tuner->data_len_ceiling = tuner->data_len_prev;
+		tuner->ceiling_samples = 0;
+		tuner->stats.data_len_reverts++;
+	}
+}
+
+uint32_t blectlr_phy_tuner_sample(struct blectlr_phy_tuner *tuner,
+				  struct blectlr_phy_tuner_sample const *sample)
+{
+	uint32_t rx_total;
+	uint8_t err_pct = 0;
+	bool degraded;
+	uint8_t phy;
+	uint16_t len;
+	uint32_t err_code = NRF_SUCCESS;
+
+	if (!tuner || !sample) {
+		return NRF_ERROR_NULL;
+	}
+
+	rx_total = sample->rx_ok + sample->rx_crc_err;
+	if (rx_total) {
+		err_pct = (uint8_t)(((uint64_t)sample->rx_crc_err * 100) /
+				    rx_total);
+	}
+	degraded = err_pct > tuner->cfg.crc_err_pct_max;
+
+	tuner->stats.samples++;
+	tuner->stats.last_crc_err_pct = err_pct;
+
+	pending_expire(tuner);
+	data_len_probe_check(tuner, sample->bytes);
+
+	phy = phy_target(tuner, sample->rssi_dbm, degraded);
+	if (phy == tuner->phy || tuner->phy_pending) {
+		tuner->phy_votes = 0;
+	} else if (phy == tuner->phy_candidate && tuner->phy_votes) {
+		tuner->phy_votes++;
+	} else {
+		tuner->phy_candidate = phy;
+		tuner->phy_votes = 1;
+	}
+
+	if (tuner->phy_votes >= tuner->cfg.stable_samples) {
+		if (phy_set(tuner, phy)) {
+			/* The PHY is only updated on the LE PHY Update Complete
+			 * event, see blectlr_phy_tuner_phy_updated().
+			 */
+			tuner->phy_votes = 0;
+			tuner->phy_pending = true;
+			tuner->phy_pending_samples = 0;
+			tuner->stats.phy_changes++;
+		} else {
+			tuner->stats.cmd_failures++;
+			err_code = NRF_ERROR_BUSY;
+		}
+	}
+
+	len = data_len_target(tuner, err_pct, degraded, sample->bytes != 0);
+	if (len == tuner->data_len || tuner->data_len_pending) {
+		tuner->data_len_votes = 0;
+	} else if (len == tuner->data_len_candidate && tuner->data_len_votes) {
+		tuner->data_len_votes++;
+	} else {
+		tuner->data_len_candidate = len;
+		tuner->data_len_votes = 1;
+	}
+
+	if (tuner->data_len_votes >= tuner->cfg.stable_samples) {
+		if (data_len_set(tuner, len)) {
+			/* The data length is only updated on the LE Data Length
+			 * Change event, see blectlr_phy_tuner_data_len_changed().
+			 */
+			tuner->data_len_requested = len;
+			tuner->data_len_votes = 0;
+			tuner->data_len_pending = true;
+			tuner->data_len_pending_samples = 0;
+			tuner->stats.data_len_changes++;
+		} else {
+			tuner->stats.cmd_failures++;
+			err_code = NRF_ERROR_BUSY;
+		}
+	}
+
+	tuner->stats.last_bytes = sample->bytes;
+
+	return err_code;
+}
+
+void blectlr_phy_tuner_phy_updated(struct blectlr_phy_tuner *tuner,
+				   uint8_t tx_phy)
+{
+	switch (tx_phy) {
+	case 2:
+		tuner->phy = BLECTLR_PHY_2M;
+		break;
+	case 3:
+		tuner->phy = BLECTLR_PHY_CODED;
+		break;
+	default:
+		tuner->phy = BLECTLR_PHY_1M;
+		break;
+	}
+
+	tuner->phy_votes = 0;
+	tuner->phy_pending = false;
+
+	/* Data lengths that did not pay off on the previous PHY may on this
+	 * one.
+	 */
+	tuner->data_len_ceiling = tuner->cfg.data_len_max;
+}
+
+void blectlr_phy_tuner_data_len_changed(struct blectlr_phy_tuner *tuner,
+					uint16_t max_tx_octets)
+{
+	/* Only a longer data length the tuner asked for is probed. */
+	tuner->data_len_probe = tuner->data_len_pending &&
+				max_tx_octets > tuner->data_len &&
+				max_tx_octets <= tuner->data_len_requested;
+	tuner->bytes_ref = tuner->stats.last_bytes;
+	tuner->data_len_prev = tuner->data_len;
+	tuner->data_len = max_tx_octets;
+	tuner->data_len_votes = 0;
+	tuner->data_len_pending = false;
+}
+
+void blectlr_phy_tuner_cmd_status(struct blectlr_phy_tuner *tuner,
+				  uint16_t opcode, uint8_t status)
+{
+	if (!status) {
+		return;
+	}
+
+	switch (opcode) {
+	case HCI_OPCODE_LE_SET_PHY:
+		if (tuner->phy_pending) {
+			tuner->phy_pending = false;
+			tuner->stats.cmd_failures++;
+		}
+		break;
+	case HCI_OPCODE_LE_SET_DATA_LENGTH:
+		if (tuner->data_len_pending) {
+			tuner->data_len_pending = false;
+			tuner->stats.cmd_failures++;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+struct blectlr_phy_tuner_stats const *
+blectlr_phy_tuner_stats_get(struct blectlr_phy_tuner const *tuner)
+{
+	return &tuner->stats;
+}
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "blectlr_tx_sched.h"
+#include "nrf_error.h"
+
+/* Connection_Handle occupies the 12 least significant bits. */
+#define HCI_DATA_HANDLE_MASK (0x0FFF)
+
+static const uint8_t prio_weight[BLECTLR_TX_PRIO_COUNT] = {
+	[BLECTLR_TX_PRIO_LOW] = 1,
+	[BLECTLR_TX_PRIO_NORMAL] = 4,
+	[BLECTLR_TX_PRIO_HIGH] = 16,
+};
+
+static struct blectlr_tx_sched_conn *conn_find(struct blectlr_tx_sched *sched,
+					       uint16_t handle)
+{
+	for (size_t i = 0; i < BLECTLR_TX_SCHED_CONN_MAX; i++) {
+		if (sched->conn[i].used && sched->conn[i].handle == handle) {
+			return &sched->conn[i];
+		}
+	}
+
+	return NULL;
+}
+
+static bool conn_eligible(struct blectlr_tx_sched const *sched,
+			  struct blectlr_tx_sched_conn const *conn)
+{
+	if (!conn->used || !conn->head) {
+		return false;
+	}
+
+	if (conn->prio == BLECTLR_TX_PRIO_HIGH) {
+		return sched->credits > 0;
+	}
+
+	return sched->credits > sched->reserved;
+}
+
+/* Smooth weighted round robin: every eligible connection gains its weight,
+ * the one with the largest accumulated value is served and pays back the
+ * total weight of the round. Over time, each connection is served in
+ * proportion to its weight, and high weight connections are interleaved
+ * with, rather than bunched before, low weight ones.
+ *
+ * The winner is picked without updating the accumulated values, so that a
+ * round whose packet the Controller does not take leaves no trace.
+ */
+static struct blectlr_tx_sched_conn *conn_next(struct blectlr_tx_sched *sched)
+{
+	struct blectlr_tx_sched_conn *best = NULL;
+	int32_t best_value = 0;
+
+	for (size_t i = 0; i < BLECTLR_TX_SCHED_CONN_MAX; i++) {
+		struct blectlr_tx_sched_conn *conn = &sched->conn[i];
+		int32_t value;
+
+		if (!conn_eligible(sched, conn)) {
+			continue;
+		}
+
+		value = conn->current + prio_weight[conn->prio];
+		if (!best || value > best_value) {
+			best = conn;
+			best_value = value;
+		}
+	}
+
+	return best;
+}
+
+/* Applies the round won by the served connection. Called before the
+ * credits change, so the eligible set is the one conn_next() saw.
+ */
+static void conn_charge(struct blectlr_tx_sched *sched,
+			struct blectlr_tx_sched_conn *best)
+{
+	int32_t total = 0;
+
+	for (size_t i = 0; i < BLECTLR_TX_SCHED_CONN_MAX; i++) {
+		struct blectlr_tx_sched_conn *conn = &sched->conn[i];
+
+		if (!conn_eligible(sched, conn)) {
+			continue;
+		}
+
+		conn->current += prio_weight[conn->prio];
+		total += prio_weight[conn->prio];
+	}
+
+	best->current -= total;
+}
+
+uint32_t blectlr_tx_sched_init(struct blectlr_tx_sched *sched,
+			       uint16_t credits, uint16_t reserved,
+			       blectlr_tx_sched_done_t done)
+{
+	if (!sched || !done) {
+		return NRF_ERROR_NULL;
+	}
+
+	if (reserved >= credits) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+
+	memset(sched, 0, sizeof(*sched));
+	sched->credits = credits;
+	sched->reserved = reserved;
+	sched->done = done;
+
+	return NRF_SUCCESS;
+}
+
+uint32_t blectlr_tx_sched_conn_add(struct blectlr_tx_sched *sched,
+				   uint16_t handle, enum blectlr_tx_prio prio)
+{
+	if (prio >= BLECTLR_TX_PRIO_COUNT) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+
+	if (conn_find(sched, handle)) {
+		return NRF_ERROR_INVALID_STATE;
+	}
+
+	for (size_t i = 0; i < BLECTLR_TX_SCHED_CONN_MAX; i++) {
+		struct blectlr_tx_sched_conn *conn = &sched->conn[i];
+
+		if (!conn->used) {
+			memset(conn, 0, sizeof(*conn));
+			conn->handle = handle;
+			conn->prio = prio;
+			conn->used = true;
+			return NRF_SUCCESS;
+		}
+	}
+
+	return NRF_ERROR_NO_MEM;
+}
+
+uint32_t blectlr_tx_sched_conn_prio_set(struct blectlr_tx_sched *sched,
+					uint16_t handle,
+					enum blectlr_tx_prio prio)
+{
+	struct blectlr_tx_sched_conn *conn;
+
+	if (prio >= BLECTLR_TX_PRIO_COUNT) {
+		return NRF_ERROR_INVALID_PARAM;
+	}
+
+	conn = conn_find(sched, handle);
+	if (!conn) {
+		return NRF_ERROR_NOT_FOUND;
+	}
+
+	conn->prio = prio;
+	conn->current = 0;
+
+	return NRF_SUCCESS;
+}
+
+uint32_t blectlr_tx_sched_conn_remove(struct blectlr_tx_sched *sched,
+				      uint16_t handle)
+{
+	struct blectlr_tx_sched_conn *conn = conn_find(sched, handle);
+	struct blectlr_tx_sched_pkt *pkt;
+
+	if (!conn) {
+		return NRF_ERROR_NOT_FOUND;
+	}
+
+	sched->credits += conn->in_flight;
+	conn->used = false;
+
+	pkt = conn->head;
+	while (pkt) {
+		struct blectlr_tx_sched_pkt *next = pkt->next;
+
+		sched->done(pkt, false);
+		pkt = next;
+	}
+
+	return NRF_SUCCESS;
+}
+
+uint32_t blectlr_tx_sched_put(struct blectlr_tx_sched *sched,
+			      struct blectlr_tx_sched_pkt *pkt)
+{
+	struct blectlr_tx_sched_conn *conn;
+	uint16_t handle;
+
+	if (!pkt || !pkt->buffer) {
+		return NRF_ERROR_NULL;
+	}
+
+	handle = (pkt->buffer[0] | (pkt->buffer[1] << 8)) &
+		 HCI_DATA_HANDLE_MASK;
+
+	conn = conn_find(sched, handle);
+	if (!conn) {
+		return NRF_ERROR_NOT_FOUND;
+	}
+
+	pkt->next = NULL;
+	if (conn->tail) {
+		conn->tail->next = pkt;
+	} else {
+		conn->head = pkt;
+	}
+	conn->tail = pkt;
+
+	return NRF_SUCCESS;
+}
+
+uint32_t blectlr_tx_sched_run(struct blectlr_tx_sched *sched)
+{
+	struct blectlr_tx_sched_conn *conn;
+	uint32_t sent = 0;
+
+	while ((conn = conn_next(sched)) != NULL) {
+		struct blectlr_tx_sched_pkt *pkt = conn->head;
+
+		if (!hci_data_packet_put(pkt->buffer)) {
+			/* The packet is retried first on the next run. */
+			break;
+		}
+
+		conn_charge(sched, conn);
+
+		conn->head = pkt->next;
+		if (!conn->head) {
+			/* An idle connection does not bank turns. */
+			conn->tail = NULL;
+			conn->current = 0;
+		}
+
+		conn->in_flight++;
+		sched->credits--;
+		sent++;
+
+		sched->done(pkt, true);
+	}
+
+	return sent;
+}
+
+void blectlr_tx_sched_completed(struct blectlr_tx_sched *sched,
+				uint16_t handle, uint16_t count)
+{
+	struct blectlr_tx_sched_conn *conn = conn_find(sched, handle);
+
+	if (!conn) {
+		return;
+	}
+
+	if (count > conn->in_flight) {
+		count = conn->in_flight;
+	}
+
+	conn->in_flight -= count;
+	sched->credits += count;
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Parse cost of messages of tens of kilobytes, made of many short records
+ * or of a few long ones. Each message is parsed in full, then parsed again
+ * with nfc_ndef_parser_resume after a change in its last record, as after
+ * NFC_T4T_EVENT_NDEF_UPDATED. The parser does not read payloads, so the
+ * cost follows the number of records rather than the size of the message.
+ *
+ * Usage: bench_ndef_parser [iterations]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <nfc_ndef_msg.h>
+#include <nfc_ndef_parser.h>
+
+#define MSG_SIZE_MAX     (60 * 1024)
+#define SHORT_PAYLOAD    24
+#define LONG_RECORDS     4
+#define RECORD_COUNT_MAX (MSG_SIZE_MAX / SHORT_PAYLOAD)
+
+/* Header, type length, payload length and a one-byte type. */
+#define SHORT_HEADER 4
+#define LONG_HEADER  7
+
+static u8_t msg[MSG_SIZE_MAX];
+static u8_t payload[MSG_SIZE_MAX];
+static u32_t marks[RECORD_COUNT_MAX];
+static const struct nfc_ndef_record_desc *records[RECORD_COUNT_MAX];
+
+static int failures;
+
+static double elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1e9 +
+	       (now.tv_nsec - start->tv_nsec);
+}
+
+static u32_t msg_build(u32_t size, u32_t record_count)
+{
+	static const u8_t type[] = {'T'};
+	static struct nfc_ndef_record_desc record = {
+		.tnf = NFC_NDEF_TNF_WELL_KNOWN,
+		.type = type,
+		.type_length = sizeof(type),
+		.payload = payload,
+	};
+	struct nfc_ndef_msg_desc desc = {
+		.records = records,
+		.record_count = record_count,
+	};
+	u32_t length = sizeof(msg);
+	u32_t per_record = size / record_count;
+
+	/* Leave room for the record headers. */
+	record.payload_length = per_record - SHORT_HEADER;
+	if (record.payload_length > 255) {
+		record.payload_length = per_record - LONG_HEADER;
+	}
+
+	for (u32_t i = 0; i < record_count; i++) {
+		records[i] = &record;
+	}
+
+	if (nfc_ndef_msg_encode(&desc, NFC_NDEF_MSG_FORMAT_RAW, msg,
+				&length)) {
+		fprintf(stderr, "cannot encode %u records\n", record_count);
+		failures++;
+		return 0;
+	}
+
+	return length;
+}
+
+static u32_t parse(struct nfc_ndef_parser *parser)
+{
+	struct nfc_ndef_record_view record;
+	u32_t count = 0;
+	int err;
+
+	while (!(err = nfc_ndef_parser_next(parser, &record))) {
+		count++;
+	}
+
+	if (err != -ENOENT) {
+		fprintf(stderr, "parse error %d\n", err);
+		failures++;
+	}
+
+	return count;
+}
+
+static void bench(const char *shape, u32_t size, u32_t record_count,
+		  unsigned long iterations)
+{
+	struct nfc_ndef_parser parser;
+	struct timespec start;
+	u32_t length = msg_build(size, record_count);
+	u32_t count = 0;
+	double full_ns;
+	double resume_ns;
+
+	if (!length) {
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long n = 0; n < iterations; n++) {
+		nfc_ndef_parser_init(&parser, msg, length, marks,
+				     RECORD_COUNT_MAX);
+		count = parse(&parser);
+	}
+	full_ns = elapsed_ns(&start) / iterations;
+
+	if (count != record_count) {
+		fprintf(stderr, "%u records parsed, expected %u\n", count,
+			record_count);
+		failures++;
+	}
+
+	/* The marks of the full parse locate the last record. */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long n = 0; n < iterations; n++) {
+		nfc_ndef_parser_resume(&parser, length, length - 1);
+		count = parse(&parser);
+	}
+	resume_ns = elapsed_ns(&start) / iterations;
+
+	if (count != 1) {
+		fprintf(stderr, "%u records parsed on resume, expected 1\n",
+			count);
+		failures++;
+	}
+
+	printf("%-6s %6u B %5u records: full %9.0f ns %6.2f ns/record, "
+	       "resume %6.0f ns\n",
+	       shape, length, record_count, full_ns, full_ns / record_count,
+	       resume_ns);
+}
+
+int main(int argc, char **argv)
+{
+	static const u32_t sizes[] = {16 * 1024, 32 * 1024, MSG_SIZE_MAX};
+	unsigned long iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) :
+						2000;
+
+	if (!iterations) {
+		iterations = 1;
+	}
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		bench("short", sizes[i],
+		      sizes[i] / (SHORT_PAYLOAD + SHORT_HEADER), iterations);
+		bench("long", sizes[i], LONG_RECORDS, iterations);
+	}
+
+	return failures ? 1 : 0;
+}
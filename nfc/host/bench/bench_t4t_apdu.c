@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Dispatch cost of nfc_t4t_apdu_router for the commands of a PICC mode
+ * transaction: SELECT, a pre-encoded response, a handler, an unknown
+ * instruction, and a streamed response fetched with GET RESPONSE. The
+ * routes of the selected application are matched in order, so the handler
+ * route is placed last among several. A hand-written switch decoder
+ * answering the same handler command gives a reference.
+ *
+ * Usage: bench_t4t_apdu [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <misc/util.h>
+
+#include <nfc_t4t_apdu.h>
+
+#define RSP_SIZE      256
+#define STREAM_LENGTH 1024
+
+static volatile u32_t sink;
+static int failures;
+
+static u16_t read_handler(void *context, const struct nfc_t4t_apdu *apdu,
+			  struct nfc_t4t_apdu_rsp *rsp)
+{
+	size_t length = min(apdu->le, rsp->size);
+
+	memset(rsp->data, apdu->p2, length);
+	rsp->length = length;
+
+	return NFC_T4T_APDU_SW_OK;
+}
+
+static int stream_producer(void *context, u32_t offset, u8_t *buf,
+			   size_t length)
+{
+	memset(buf, (u8_t)offset, length);
+
+	return 0;
+}
+
+static u16_t stream_handler(void *context, const struct nfc_t4t_apdu *apdu,
+			    struct nfc_t4t_apdu_rsp *rsp)
+{
+	rsp->producer = stream_producer;
+	rsp->producer_length = STREAM_LENGTH;
+
+	return NFC_T4T_APDU_SW_OK;
+}
+
+static const u8_t version_rsp[] = {0x01, 0x02, 0x03, 0x04, 0x90, 0x00};
+
+static const struct nfc_t4t_apdu_route routes[] = {
+	NFC_T4T_APDU_ROUTE_STATIC(0xCA, version_rsp),
+	NFC_T4T_APDU_ROUTE_INS(0x20, read_handler, NULL),
+	NFC_T4T_APDU_ROUTE_INS(0x22, read_handler, NULL),
+	NFC_T4T_APDU_ROUTE_INS(0x24, read_handler, NULL),
+	NFC_T4T_APDU_ROUTE_INS(0x2A, read_handler, NULL),
+	NFC_T4T_APDU_ROUTE_INS(0x84, read_handler, NULL),
+	NFC_T4T_APDU_ROUTE_INS(0x88, read_handler, NULL),
+	NFC_T4T_APDU_ROUTE_INS(0xC2, stream_handler, NULL),
+	NFC_T4T_APDU_ROUTE_INS(0xB0, read_handler, NULL),
+};
+
+static const u8_t aids[4][7] = {
+	{0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10},
+	{0xA0, 0x00, 0x00, 0x00, 0x04, 0x10, 0x10},
+	{0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01},
+	{0xF0, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06},
+};
+
+static const struct nfc_t4t_apdu_app apps[] = {
+	{ .aid = aids[0], .aid_length = sizeof(aids[0]) },
+	{ .aid = aids[1], .aid_length = sizeof(aids[1]) },
+	{ .aid = aids[2], .aid_length = sizeof(aids[2]) },
+	{
+		.aid = aids[3],
+		.aid_length = sizeof(aids[3]),
+		.routes = routes,
+		.route_count = ARRAY_SIZE(routes),
+	},
+};
+
+static const u8_t cmd_select[] = {
+	0x00, 0xA4, 0x04, 0x00, 0x07,
+	0xF0, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x00,
+};
+static const u8_t cmd_static[] = {0x00, 0xCA, 0x00, 0x00, 0x00};
+static const u8_t cmd_handler[] = {0x00, 0xB0, 0x00, 0x5A, 0x20};
+static const u8_t cmd_unknown[] = {0x00, 0xEE, 0x00, 0x00};
+static const u8_t cmd_stream[] = {0x00, 0xC2, 0x00, 0x00, 0x00};
+static const u8_t cmd_get_response[] = {0x00, 0xC0, 0x00, 0x00, 0x00};
+
+/* The dispatcher an application writes without the router, for the
+ * handler command only.
+ */
+static void switch_dispatch(u8_t *rsp_buf, const u8_t *buf, size_t length,
+			    const u8_t **rsp, size_t *rsp_length)
+{
+	struct nfc_t4t_apdu apdu;
+	struct nfc_t4t_apdu_rsp out = {
+		.data = rsp_buf,
+		.size = RSP_SIZE - NFC_T4T_APDU_SW_SIZE,
+	};
+	u16_t sw;
+
+	if (nfc_t4t_apdu_parse(buf, length, &apdu)) {
+		sw = NFC_T4T_APDU_SW_WRONG_LENGTH;
+	} else {
+		switch (apdu.ins) {
+		case 0xB0:
+			sw = read_handler(NULL, &apdu, &out);
+			break;
+		default:
+			sw = NFC_T4T_APDU_SW_INS_NOT_SUPPORTED;
+			break;
+		}
+	}
+
+	rsp_buf[out.length] = (u8_t)(sw >> 8);
+	rsp_buf[out.length + 1] = (u8_t)sw;
+	*rsp = rsp_buf;
+	*rsp_length = out.length + NFC_T4T_APDU_SW_SIZE;
+}
+
+static u16_t sw_get(const u8_t *rsp, size_t rsp_length)
+{
+	return (u16_t)((rsp[rsp_length - 2] << 8) | rsp[rsp_length - 1]);
+}
+
+static void check(const char *name, const u8_t *rsp, size_t rsp_length,
+		  size_t expected_length, u16_t expected_sw)
+{
+	if (rsp_length != expected_length ||
+	    sw_get(rsp, rsp_length) != expected_sw) {
+		fprintf(stderr, "%s: %zu bytes, SW %04X\n", name, rsp_length,
+			sw_get(rsp, rsp_length));
+		failures++;
+	}
+}
+
+static double elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1e9 +
+	       (now.tv_nsec - start->tv_nsec);
+}
+
+static void report(const char *name, double ns, unsigned long count)
+{
+	printf("%-24s %8.2f ns/command\n", name, ns / count);
+}
+
+static void bench(struct nfc_t4t_apdu_router *router, const char *name,
+		  const u8_t *cmd, size_t cmd_length, size_t expected_length,
+		  u16_t expected_sw, unsigned long iterations)
+{
+	struct timespec start;
+	const u8_t *rsp = NULL;
+	size_t rsp_length = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long n = 0; n < iterations; n++) {
+		nfc_t4t_apdu_router_dispatch(router, cmd, cmd_length, &rsp,
+					     &rsp_length);
+		sink += rsp_length;
+	}
+	report(name, elapsed_ns(&start), iterations);
+
+	check(name, rsp, rsp_length, expected_length, expected_sw);
+}
+
+int main(int argc, char **argv)
+{
+	static u8_t rsp_buf[RSP_SIZE];
+	static u8_t switch_buf[RSP_SIZE];
+	unsigned long iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) :
+						1000000;
+	struct nfc_t4t_apdu_router router;
+	struct timespec start;
+	const u8_t *rsp = NULL;
+	size_t rsp_length = 0;
+	u32_t received;
+
+	if (!iterations) {
+		iterations = 1;
+	}
+
+	if (nfc_t4t_apdu_router_init(&router, apps, ARRAY_SIZE(apps), rsp_buf,
+				     sizeof(rsp_buf))) {
+		fprintf(stderr, "router init failed\n");
+		return 1;
+	}
+
+	bench(&router, "SELECT", cmd_select, sizeof(cmd_select),
+	      NFC_T4T_APDU_SW_SIZE, NFC_T4T_APDU_SW_OK, iterations);
+	bench(&router, "pre-encoded response", cmd_static,
+	      sizeof(cmd_static), sizeof(version_rsp), NFC_T4T_APDU_SW_OK,
+	      iterations);
+	bench(&router, "handler, last route", cmd_handler, sizeof(cmd_handler),
+	      0x20 + NFC_T4T_APDU_SW_SIZE, NFC_T4T_APDU_SW_OK, iterations);
+	bench(&router, "unknown instruction", cmd_unknown,
+	      sizeof(cmd_unknown), NFC_T4T_APDU_SW_SIZE,
+	      NFC_T4T_APDU_SW_INS_NOT_SUPPORTED, iterations);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long n = 0; n < iterations; n++) {
+		switch_dispatch(switch_buf, cmd_handler, sizeof(cmd_handler),
+				&rsp, &rsp_length);
+		sink += rsp_length;
+	}
+	report("handler, switch", elapsed_ns(&start), iterations);
+	check("handler, switch", rsp, rsp_length,
+	      0x20 + NFC_T4T_APDU_SW_SIZE, NFC_T4T_APDU_SW_OK);
+
+	/* A streamed response, from the command to the last chunk. */
+	received = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long n = 0; n < iterations / 8 + 1; n++) {
+		nfc_t4t_apdu_router_dispatch(&router, cmd_stream,
+					     sizeof(cmd_stream), &rsp,
+					     &rsp_length);
+		received = rsp_length - NFC_T4T_APDU_SW_SIZE;
+
+		while ((sw_get(rsp, rsp_length) & 0xFF00) ==
+		       NFC_T4T_APDU_SW_BYTES_REMAINING) {
+			nfc_t4t_apdu_router_dispatch(&router,
+						     cmd_get_response,
+						     sizeof(cmd_get_response),
+						     &rsp, &rsp_length);
+			received += rsp_length - NFC_T4T_APDU_SW_SIZE;
+		}
+	}
+	printf("%-24s %8.2f ns/response of %u bytes\n", "streamed response",
+	       elapsed_ns(&start) / (iterations / 8 + 1), STREAM_LENGTH);
+
+	if (received != STREAM_LENGTH ||
+	    sw_get(rsp, rsp_length) != NFC_T4T_APDU_SW_OK) {
+		fprintf(stderr, "streamed response: %u bytes, SW %04X\n",
+			received, sw_get(rsp, rsp_length));
+		failures++;
+	}
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Throughput and latency sweeps of nfc_vreader_bench over the host T2T and
+ * T4T libraries: T2T reads of growing length, T4T READ BINARY and UPDATE
+ * BINARY with growing chunks, and FWI settings with a modeled handling time
+ * of HANDLING_US per command. The figures are host handling plus modeled
+ * air time, not the timing of the nRF52 libraries.
+ *
+ * Usage: bench_vreader [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <misc/util.h>
+
+#include <nfc_ndef_msg.h>
+#include <nfc_t2t_lib.h>
+#include <nfc_t4t_lib.h>
+#include <nfc_vreader.h>
+#include <nfc_vreader_bench.h>
+
+#define T2T_MSG_SIZE  900
+#define T4T_FILE_SIZE 4096
+#define T4T_MSG_SIZE  4000
+#define HANDLING_US   2000
+
+/* Frame waiting time of FWI 0, in nanoseconds: 4096 / fc. */
+#define FWT0_NS 302065
+
+static int failures;
+
+static void t2t_callback(void *context, enum nfc_t2t_event event,
+			 const u8_t *data, size_t data_length)
+{
+}
+
+static void t4t_callback(void *context, enum nfc_t4t_event event,
+			 const u8_t *data, size_t data_length, u32_t flags)
+{
+}
+
+static void report(const char *name, size_t size,
+		   const struct nfc_vreader_bench_result *result)
+{
+	printf("%-7s %4zu B: %7u B/s, p50 %5u us, p90 %5u us, p99 %5u us, "
+	       "max %6u us, %u frames, %u WTX\n",
+	       name, size, result->bytes_per_s, result->p50_us,
+	       result->p90_us, result->p99_us, result->max_us, result->frames,
+	       result->wtx);
+}
+
+static void check(const char *name, int err,
+		  const struct nfc_vreader_bench_result *result,
+		  u32_t expected_bytes)
+{
+	if (err || result->bytes != expected_bytes) {
+		fprintf(stderr, "%s: error %d, %u bytes, expected %u\n", name,
+			err, result->bytes, expected_bytes);
+		failures++;
+	}
+}
+
+static void bench_t2t(unsigned long iterations)
+{
+	static const size_t lengths[] = {64, 256, 960};
+	static u8_t msg[T2T_MSG_SIZE];
+	struct nfc_vreader_bench_result result;
+	int err;
+
+	nfc_t2t_setup(t2t_callback, NULL);
+	nfc_t2t_payload_set(msg, sizeof(msg));
+	nfc_t2t_emulation_start();
+	nfc_vreader_field_on();
+
+	for (size_t i = 0; i < ARRAY_SIZE(lengths); i++) {
+		err = nfc_vreader_bench_t2t_read(lengths[i], iterations,
+						 &result);
+		check("t2t", err, &result, lengths[i] * iterations);
+		report("t2t", lengths[i], &result);
+	}
+
+	nfc_vreader_field_off();
+	nfc_t2t_done();
+}
+
+static void bench_t4t(unsigned long iterations)
+{
+	static const size_t chunks[] = {16, 64, 128, 255};
+	static u8_t file[T4T_FILE_SIZE];
+	static u8_t msg[T4T_MSG_SIZE];
+	struct nfc_vreader_bench_result result;
+	u32_t expected = (NFC_NDEF_MSG_NLEN_SIZE + sizeof(msg)) * iterations;
+	u32_t wtx_min;
+	int err;
+
+	for (size_t i = 0; i < sizeof(msg); i++) {
+		msg[i] = (u8_t)i;
+	}
+
+	nfc_t4t_setup(t4t_callback, NULL);
+	nfc_t4t_ndef_rwpayload_set(file, sizeof(file));
+	nfc_t4t_emulation_start();
+	nfc_vreader_field_on();
+
+	if (nfc_vreader_t4t_ndef_write(msg, sizeof(msg))) {
+		fprintf(stderr, "t4t: cannot write the message\n");
+		failures++;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(chunks); i++) {
+		err = nfc_vreader_bench_t4t_read(chunks[i], iterations,
+						 &result);
+		check("read", err, &result, expected);
+		report("read", chunks[i], &result);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(chunks); i++) {
+		err = nfc_vreader_bench_t4t_update(chunks[i], iterations,
+						   &result);
+		check("update", err, &result, expected);
+		report("update", chunks[i], &result);
+	}
+
+	/* A frame waiting time shorter than the handling costs S(WTX)
+	 * exchanges, a longer one none.
+	 */
+	nfc_vreader_bench_handling_set(HANDLING_US);
+
+	for (u8_t fwi = 0; fwi <= 4; fwi++) {
+		char name[8];
+
+		nfc_t4t_parameter_set(NFC_T4T_PARAM_FWI, &fwi, sizeof(fwi));
+		err = nfc_vreader_bench_t4t_read(255, iterations, &result);
+		snprintf(name, sizeof(name), "fwi %u", fwi);
+		check(name, err, &result, expected);
+		report(name, 255, &result);
+
+		wtx_min = (u32_t)(HANDLING_US * 1000ULL / (FWT0_NS << fwi)) *
+			  result.transactions;
+		if (result.wtx < wtx_min) {
+			fprintf(stderr, "%s: %u WTX, expected at least %u\n",
+				name, result.wtx, wtx_min);
+			failures++;
+		}
+	}
+
+	nfc_vreader_bench_handling_set(0);
+
+	nfc_vreader_field_off();
+	nfc_t4t_done();
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) :
+						200;
+
+	if (!iterations) {
+		iterations = 1;
+	}
+
+	bench_t2t(iterations);
+	bench_t4t(iterations);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_VREADER_H__
+#define NFC_VREADER_H__
+
+/** @file
+ *
+ * @defgroup nfc_vreader NFC virtual reader
+ * @{
+ * @ingroup nfc_api
+ * @brief Scriptable reader for host builds of NFC applications.
+ *
+ * On a Linux host, the T2T and T4T library APIs are provided by host
+ * implementations in nfc/host/src, and the virtual reader replaces the RF
+ * field and the remote reader. The application registers its callback and
+ * payloads as on target, and the virtual reader then runs tap sequences
+ * against it synchronously: field on, T2T READ commands or T4T command
+ * APDUs, field off. Callbacks run in the caller's context.
+ *
+ * In T4T NDEF mode, the host library emulates the NDEF application, its
+ * capability container and its NDEF file, as the target library does. In
+ * PICC mode, commands are delivered through @ref NFC_T4T_EVENT_DATA_IND,
+ * split into frames of the configured size, and the response is the PDU
+ * given to @ref nfc_t4t_response_pdu_send.
+ *
+ * Anticollision, timing and frame-level errors are not emulated.
+ */
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Default frame size used to fragment command APDUs. */
+#define NFC_VREADER_FRAME_SIZE_DEFAULT 253
+
+/** @brief Set the frame size used to fragment command APDUs in PICC mode.
+ *
+ * @param frame_size Frame size in bytes.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Frame size of 0.
+ */
+int nfc_vreader_frame_size_set(size_t frame_size);
+
+/** @brief Get the frame size used to fragment command APDUs.
+ *
+ * @return Frame size in bytes.
+ */
+size_t nfc_vreader_frame_size_get(void);
+
+/** @brief Bring the virtual reader into the field of the running tag. */
+void nfc_vreader_field_on(void);
+
+/** @brief Remove the virtual reader from the field. */
+void nfc_vreader_field_off(void);
+
+/** @brief Send a T2T READ command.
+ *
+ * @param block Block number.
+ * @param data Receives the 16 bytes returned by the tag.
+ *
+ * @retval 0 Success.
+ * @retval -ENOTCONN No T2T emulation running or no field.
+ * @retval -EINVAL Block outside of the tag memory.
+ */
+int nfc_vreader_t2t_read(u8_t block, u8_t *data);
+
+/** @brief Read the NDEF message of a T2T tag.
+ *
+ * Reads the tag memory block by block and walks its TLVs to the NDEF
+ * message TLV.
+ *
+ * @param msg Buffer receiving the NDEF message.
+ * @param length Size of @p msg on input. Receives the message length.
+ *
+ * @retval 0 Success.
+ * @retval -ENOTCONN No T2T emulation running or no field.
+ * @retval -ENOENT No NDEF message TLV found.
+ * @retval -ENOMEM @p msg is too small.
+ * @retval -EBADMSG Malformed capability container or TLV.
+ */
+int nfc_vreader_t2t_ndef_read(u8_t *msg, size_t *length);
+
+/** @brief Exchange a command APDU with a T4T tag.
+ *
+ * @param capdu Command APDU.
+ * @param capdu_length Length of the command APDU.
+ * @param rapdu Buffer receiving the response APDU.
+ * @param rapdu_length Size of @p rapdu on input. Receives the response
+ *		       length.
+ *
+ * @retval 0 Success.
+ * @retval -ENOTCONN No T4T emulation running or no field.
+ * @retval -EINPROGRESS The application has not answered yet. Fetch the
+ *	   response later with @ref nfc_vreader_t4t_response_get.
+ * @retval -ENOMEM @p rapdu is too small.
+ */
+int nfc_vreader_t4t_transceive(const u8_t *capdu, size_t capdu_length,
+			       u8_t *rapdu, size_t *rapdu_length);
+
+/** @brief Fetch a response that was not available during
+ *  @ref nfc_vreader_t4t_transceive.
+ *
+ * @param rapdu Buffer receiving the response APDU.
+ * @param rapdu_length Size of @p rapdu on input. Receives the response
+ *		       length.
+ *
+ * @retval 0 Success.
+ * @retval -EINPROGRESS The application has still not answered.
+ * @retval -ENOMEM @p rapdu is too small.
+ */
+int nfc_vreader_t4t_response_get(u8_t *rapdu, size_t *rapdu_length);
+
+/** @brief Read the NDEF message of a T4T tag.
+ *
+ * Runs the NFC Forum T4T read procedure: SELECT of the NDEF application,
+ * the capability container and the NDEF file, then READ BINARY of NLEN and
+ * of the message.
+ *
+ * @param msg Buffer receiving the NDEF message.
+ * @param length Size of @p msg on input. Receives the message length.
+ *
+ * @retval 0 Success.
+ * @retval -ENOTCONN No T4T emulation running or no field.
+ * @retval -EIO The tag answered with an error status word.
+ * @retval -ENOMEM @p msg is too small.
+ * @retval -EBADMSG Malformed capability container.
+ */
+int nfc_vreader_t4t_ndef_read(u8_t *msg, size_t *length);
+
+/** @brief Write an NDEF message to a T4T tag.
+ *
+ * Runs the NFC Forum T4T update procedure: NLEN is cleared, the message is
+ * written with UPDATE BINARY and NLEN is set last.
+ *
+ * @param msg NDEF message.
+ * @param length Length of the message.
+ *
+ * @retval 0 Success.
+ * @retval -ENOTCONN No T4T emulation running or no field.
+ * @retval -EIO The tag answered with an error status word.
+ * @retval -ENOMEM The message does not fit in the NDEF file.
+ * @retval -EBADMSG Malformed capability container.
+ */
+int nfc_vreader_t4t_ndef_write(const u8_t *msg, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_VREADER_H__ */
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_VREADER_BENCH_H__
+#define NFC_VREADER_BENCH_H__
+
+/** @file
+ *
+ * @defgroup nfc_vreader_bench NFC virtual reader throughput sweeps
+ * @{
+ * @ingroup nfc_vreader
+ * @brief Transaction throughput and latency of the emulated tag.
+ *
+ * The sweeps run T2T READ, T4T READ BINARY or T4T UPDATE BINARY
+ * transactions against the running tag through the virtual reader and
+ * report bytes per second and transaction latency percentiles, so that
+ * chunk sizes, FWI settings and payload layouts can be compared.
+ *
+ * What is measured is the host build: the host implementations of the
+ * T2T and T4T libraries in nfc/host/src and the application callbacks,
+ * running on the host CPU, plus a model of the air time. The nRF52
+ * library binaries are not run, and the results do not compare library
+ * versions or predict the timing of the target.
+ *
+ * The latency of a transaction is the air time of its frames, modeled
+ * for ISO/IEC 14443-A at 106 kbit/s with the minimum frame delay times,
+ * plus the handling time. T4T commands and responses are split into
+ * I-blocks of the virtual reader frame size, each chained block
+ * acknowledged with an R(ACK).
+ *
+ * The handling time is the time the host took to handle the command, plus
+ * the time set with @ref nfc_vreader_bench_handling_set for T4T commands.
+ * Handling that takes longer than the frame waiting time given by the FWI
+ * of the tag costs one S(WTX) exchange per elapsed frame waiting time.
+ * The host handles a command in microseconds, far below the shortest
+ * frame waiting time of about 300 us, so S(WTX) exchanges only appear
+ * with a handling time set, e.g. one measured on the target with
+ * nfc_latency.
+ *
+ * Reader turnaround, anticollision and activation are not included, so
+ * the results are lower bounds on the latency that compare
+ * configurations rather than predict a given reader.
+ */
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Number of transaction latencies kept for the percentiles. */
+#define NFC_VREADER_BENCH_SAMPLES_MAX 4096
+
+/** @brief Sweep results. */
+struct nfc_vreader_bench_result {
+	/** Transactions run. */
+	u32_t transactions;
+	/** Data bytes read or written. */
+	u32_t bytes;
+	/** Frames sent and received, S(WTX) and R(ACK) included. */
+	u32_t frames;
+	/** S(WTX) exchanges needed. */
+	u32_t wtx;
+	/** Total latency of all transactions, in microseconds. */
+	u64_t total_us;
+	/** Data bytes per second over the total latency. */
+	u32_t bytes_per_s;
+	/** Median transaction latency, in microseconds. */
+	u32_t p50_us;
+	/** 90th percentile of the transaction latency, in microseconds. */
+	u32_t p90_us;
+	/** 99th percentile of the transaction latency, in microseconds. */
+	u32_t p99_us;
+	/** Largest transaction latency, in microseconds. */
+	u32_t max_us;
+};
+
+/** @brief Set the handling time added to every T4T command.
+ *
+ * Models the time the application on the target takes to handle a
+ * command, such as a response computed in a handler, on top of the
+ * handling time measured on the host. The default is 0.
+ *
+ * @param handling_us Handling time in microseconds.
+ */
+void nfc_vreader_bench_handling_set(u32_t handling_us);
+
+/** @brief Read the T2T data area with READ commands.
+ *
+ * @param length Number of data area bytes to read, from its start.
+ * @param iterations Number of times the area is read.
+ * @param result Results.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument.
+ * @return Error code returned by @ref nfc_vreader_t2t_read.
+ */
+int nfc_vreader_bench_t2t_read(size_t length, u32_t iterations,
+			       struct nfc_vreader_bench_result *result);
+
+/** @brief Read the T4T NDEF file with READ BINARY commands.
+ *
+ * Selects the NDEF application and file, outside of the measurement,
+ * then reads NLEN and the message in chunks.
+ *
+ * @param chunk Bytes requested per READ BINARY, 1 to 255.
+ * @param iterations Number of times the file is read.
+ * @param result Results.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument.
+ * @retval -EIO The tag answered with an error status word.
+ * @return Error code returned by @ref nfc_vreader_t4t_transceive.
+ */
+int nfc_vreader_bench_t4t_read(size_t chunk, u32_t iterations,
+			       struct nfc_vreader_bench_result *result);
+
+/** @brief Write the T4T NDEF file with UPDATE BINARY commands.
+ *
+ * Selects the NDEF application and file and reads the message, outside
+ * of the measurement, then writes the same bytes back in chunks, NLEN
+ * included, so the content is unchanged.
+ *
+ * @param chunk Bytes written per UPDATE BINARY, 1 to 255.
+ * @param iterations Number of times the file is written.
+ * @param result Results.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument.
+ * @retval -EIO The tag answered with an error status word.
+ * @return Error code returned by @ref nfc_vreader_t4t_transceive.
+ */
+int nfc_vreader_bench_t4t_update(size_t chunk, u32_t iterations,
+				 struct nfc_vreader_bench_result *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_VREADER_BENCH_H__ */
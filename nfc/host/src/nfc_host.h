@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Interface between the host implementations of the tag libraries and the
+ * virtual reader.
+ */
+
+#ifndef NFC_HOST_H__
+#define NFC_HOST_H__
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+
+int nfc_platform_setup(void);
+
+bool nfc_host_t2t_running(void);
+void nfc_host_t2t_field_set(bool on);
+int nfc_host_t2t_read(u8_t block, u8_t *data);
+
+bool nfc_host_t4t_running(void);
+void nfc_host_t4t_field_set(bool on);
+int nfc_host_t4t_transceive(const u8_t *capdu, size_t capdu_length,
+			    size_t frame_size);
+int nfc_host_t4t_response_get(u8_t *rapdu, size_t *rapdu_length);
+
+#endif /* NFC_HOST_H__ */
@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include "nfc_host.h"
+
+/* There is no clock or NFCT peripheral to set up on the host. Field events
+ * come from the virtual reader instead of the NFCT driver.
+ */
+int nfc_platform_setup(void)
+{
+	return 0;
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+
+#include <nfc_t2t_lib.h>
+
+#include "nfc_host.h"
+
+#define T2T_BLOCK_SIZE       4
+#define T2T_READ_SIZE        16
+#define T2T_HEADER_SIZE      16
+#define T2T_MEMORY_SIZE      (T2T_HEADER_SIZE + NFC_T2T_MAX_PAYLOAD_SIZE_RAW)
+
+#define T2T_LOCK_OFFSET      10
+#define T2T_CC_OFFSET        12
+
+#define TLV_NDEF             0x03
+#define TLV_TERMINATOR       0xFE
+#define TLV_LONG_FORMAT      0xFF
+
+/* UID 5F 11 22 | 33 44 55 66 with the block check characters in place. */
+static const u8_t default_internal[NFC_T2T_SIZEOF_INTERNAL_BYTES] = {
+	0x5F, 0x11, 0x22, 0x88 ^ 0x5F ^ 0x11 ^ 0x22,
+	0x33, 0x44, 0x55, 0x66, 0x33 ^ 0x44 ^ 0x55 ^ 0x66,
+	0x48
+};
+
+/* Magic number, version 1.0, data area size / 8, read-only access. */
+static const u8_t cc[] = {
+	0xE1, 0x10, NFC_T2T_MAX_PAYLOAD_SIZE_RAW / 8, 0x0F
+};
+
+static nfc_t2t_callback_t callback;
+static void *callback_context;
+static u8_t internal[NFC_T2T_SIZEOF_INTERNAL_BYTES];
+static const u8_t *payload;
+static size_t payload_length;
+static bool raw;
+static bool running;
+static bool field;
+static bool data_read;
+
+static void event_send(enum nfc_t2t_event event)
+{
+	if (callback) {
+		callback(callback_context, event, NULL, 0);
+	}
+}
+
+int nfc_t2t_setup(nfc_t2t_callback_t cb, void *context)
+{
+	if (!cb || running) {
+		return -EINVAL;
+	}
+
+	callback = cb;
+	callback_context = context;
+	memcpy(internal, default_internal, sizeof(internal));
+
+	return nfc_platform_setup();
+}
+
+int nfc_t2t_parameter_set(enum nfc_t2t_param_id id, void *data,
+			  size_t data_length)
+{
+	return -ENOTSUP;
+}
+
+int nfc_t2t_parameter_get(enum nfc_t2t_param_id id, void *data,
+			  size_t *max_data_length)
+{
+	return -ENOTSUP;
+}
+
+static int payload_register(const u8_t *data, size_t length, bool is_raw,
+			    size_t max)
+{
+	if (data && length > max) {
+		return -EINVAL;
+	}
+
+	payload = data;
+	payload_length = data ? length : 0;
+	raw = is_raw;
+
+	return 0;
+}
+
+int nfc_t2t_payload_set(const u8_t *data, size_t length)
+{
+	return payload_register(data, length, false, NFC_T2T_MAX_PAYLOAD_SIZE);
+}
+
+int nfc_t2t_payload_raw_set(const u8_t *data, size_t length)
+{
+	return payload_register(data, length, true,
+				NFC_T2T_MAX_PAYLOAD_SIZE_RAW);
+}
+
+int nfc_t2t_internal_set(const u8_t *data, size_t data_length)
+{
+	if (!data) {
+		memcpy(internal, default_internal, sizeof(internal));
+		return 0;
+	}
+
+	if (data_length != NFC_T2T_SIZEOF_INTERNAL_BYTES) {
+		return -EINVAL;
+	}
+
+	memcpy(internal, data, sizeof(internal));
+
+	return 0;
+}
+
+int nfc_t2t_emulation_start(void)
+{
+	if (!callback || running) {
+		return -EINVAL;
+	}
+
+	running = true;
+
+	return 0;
+}
+
+int nfc_t2t_emulation_stop(void)
+{
+	if (!running) {
+		return -EINVAL;
+	}
+
+	nfc_host_t2t_field_set(false);
+	running = false;
+
+	return 0;
+}
+
+int nfc_t2t_done(void)
+{
+	if (running) {
+		nfc_t2t_emulation_stop();
+	}
+
+	event_send(NFC_T2T_EVENT_STOPPED);
+	callback = NULL;
+	payload = NULL;
+	payload_length = 0;
+
+	return 0;
+}
+
+bool nfc_host_t2t_running(void)
+{
+	return running;
+}
+
+void nfc_host_t2t_field_set(bool on)
+{
+	if (!running || on == field) {
+		return;
+	}
+
+	field = on;
+	data_read = false;
+	event_send(on ? NFC_T2T_EVENT_FIELD_ON : NFC_T2T_EVENT_FIELD_OFF);
+}
+
+/* Length of the data area content up to the last payload byte, NDEF TLV
+ * header included.
+ */
+static size_t data_length_get(void)
+{
+	if (raw) {
+		return payload_length;
+	}
+
+	return (payload_length < TLV_LONG_FORMAT ? 2 : 4) + payload_length;
+}
+
+static u8_t data_byte_get(size_t offset)
+{
+	size_t header;
+
+	if (raw) {
+		return offset < payload_length ? payload[offset] : 0;
+	}
+
+	if (payload_length < TLV_LONG_FORMAT) {
+		header = 2;
+		if (offset == 1) {
+			return (u8_t)payload_length;
+		}
+	} else {
+		header = 4;
+		if (offset == 1) {
+			return TLV_LONG_FORMAT;
+		} else if (offset == 2) {
+			return (u8_t)(payload_length >> 8);
+		} else if (offset == 3) {
+			return (u8_t)payload_length;
+		}
+	}
+
+	if (offset == 0) {
+		return payload ? TLV_NDEF : TLV_TERMINATOR;
+	} else if (offset < header + payload_length) {
+		return payload[offset - header];
+	} else if (offset == header + payload_length) {
+		return TLV_TERMINATOR;
+	}
+
+	return 0;
+}
+
+static u8_t memory_byte_get(size_t offset)
+{
+	if (offset < T2T_LOCK_OFFSET) {
+		return internal[offset];
+	} else if (offset < T2T_CC_OFFSET) {
+		return 0;
+	} else if (offset < T2T_HEADER_SIZE) {
+		return cc[offset - T2T_CC_OFFSET];
+	}
+
+	return data_byte_get(offset - T2T_HEADER_SIZE);
+}
+
+int nfc_host_t2t_read(u8_t block, u8_t *data)
+{
+	size_t start = (size_t)block * T2T_BLOCK_SIZE;
+
+	if (!running || !field) {
+		return -ENOTCONN;
+	}
+
+	if (start >= T2T_MEMORY_SIZE) {
+		return -EINVAL;
+	}
+
+	/* READ returns four blocks and rolls over at the end of memory. */
+	for (size_t i = 0; i < T2T_READ_SIZE; i++) {
+		data[i] = memory_byte_get((start + i) % T2T_MEMORY_SIZE);
+	}
+
+	if (!data_read && start < T2T_HEADER_SIZE + data_length_get() &&
+	    start + T2T_READ_SIZE >= T2T_HEADER_SIZE + data_length_get()) {
+		data_read = true;
+		event_send(NFC_T2T_EVENT_DATA_READ);
+	}
+
+	return 0;
+}
@@ -0,0 +1,466 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <misc/util.h>
+
+#include <nfc_t4t_lib.h>
+
+#include "nfc_host.h"
+
+#define APDU_INS_SELECT        0xA4
+#define APDU_INS_READ_BINARY   0xB0
+#define APDU_INS_UPDATE_BINARY 0xD6
+
+#define SELECT_BY_NAME         0x04
+#define SELECT_BY_FILE_ID      0x00
+
+#define FILE_NONE              0x0000
+#define FILE_CC                0xE103
+#define FILE_NDEF              0xE104
+
+#define NLEN_SIZE              2
+
+/* Maximum R-APDU data size (MLe) and C-APDU data size (MLc). */
+#define NDEF_MLE               0xFF
+#define NDEF_MLC               0xFF
+
+#define RAPDU_MAX_SIZE         (NDEF_MLE + 2)
+
+static const u8_t ndef_aid[] = {0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01};
+
+static nfc_t4t_callback_t callback;
+static void *callback_context;
+static enum nfc_t4t_emu_mode mode;
+static u8_t *ndef_file;
+static const u8_t *ndef_file_ro;
+static size_t ndef_file_size;
+static bool running;
+static bool field;
+static u8_t fwi = 4;
+
+/* NDEF application state. */
+static bool app_selected;
+static u16_t file_selected;
+static u8_t cc[15];
+static u8_t rapdu[RAPDU_MAX_SIZE];
+static size_t rapdu_length;
+
+/* PICC mode state. */
+static const u8_t *pending_rsp;
+static size_t pending_rsp_length;
+static bool rsp_expected;
+
+static void event_send(enum nfc_t4t_event event, const u8_t *data,
+		       size_t data_length, u32_t flags)
+{
+	if (callback) {
+		callback(callback_context, event, data, data_length, flags);
+	}
+}
+
+int nfc_t4t_setup(nfc_t4t_callback_t cb, void *context)
+{
+	if (running) {
+		return -ENOTSUP;
+	}
+
+	if (!cb) {
+		return -EINVAL;
+	}
+
+	callback = cb;
+	callback_context = context;
+	mode = NFC_T4T_EMUMODE_PICC;
+	ndef_file = NULL;
+	ndef_file_ro = NULL;
+	ndef_file_size = 0;
+
+	return nfc_platform_setup();
+}
+
+int nfc_t4t_ndef_rwpayload_set(u8_t *emulation_buffer, size_t buffer_length)
+{
+	if (running) {
+		return -ENOTSUP;
+	}
+
+	if (!emulation_buffer || buffer_length < NLEN_SIZE ||
+	    buffer_length > NFC_T4T_MAX_PAYLOAD_SIZE) {
+		return -EINVAL;
+	}
+
+	mode = NFC_T4T_EMUMODE_NDEF;
+	ndef_file = emulation_buffer;
+	ndef_file_ro = emulation_buffer;
+	ndef_file_size = buffer_length;
+
+	return 0;
+}
+
+int nfc_t4t_ndef_staticpayload_set(const u8_t *emulation_buffer,
+				   size_t buffer_length)
+{
+	if (running) {
+		return -ENOTSUP;
+	}
+
+	if (!emulation_buffer || buffer_length < NLEN_SIZE ||
+	    buffer_length > NFC_T4T_MAX_PAYLOAD_SIZE) {
+		return -EINVAL;
+	}
+
+	mode = NFC_T4T_EMUMODE_NDEF;
+	ndef_file = NULL;
+	ndef_file_ro = emulation_buffer;
+	ndef_file_size = buffer_length;
+
+	return 0;
+}
+
+int nfc_t4t_response_pdu_send(const u8_t *pdu, size_t pdu_length)
+{
+	if (mode != NFC_T4T_EMUMODE_PICC) {
+		return -ENOTSUP;
+	}
+
+	if (!pdu || !pdu_length) {
+		return -EINVAL;
+	}
+
+	if (!rsp_expected) {
+		return -ENOTSUP;
+	}
+
+	pending_rsp = pdu;
+	pending_rsp_length = pdu_length;
+	rsp_expected = false;
+
+	return 0;
+}
+
+int nfc_t4t_parameter_set(enum nfc_t4t_param_id id, void *data,
+			  size_t data_length)
+{
+	if (!data) {
+		return -EINVAL;
+	}
+
+	switch (id) {
+	case NFC_T4T_PARAM_FWI:
+		if (data_length != sizeof(fwi)) {
+			return -EINVAL;
+		}
+		fwi = *(u8_t *)data;
+		return 0;
+
+	case NFC_T4T_PARAM_SELRES:
+	case NFC_T4T_PARAM_NFCID1:
+		/* Accepted but irrelevant without anticollision. */
+		return 0;
+
+	default:
+		return -EINVAL;
+	}
+}
+
+int nfc_t4t_parameter_get(enum nfc_t4t_param_id id, void *data,
+			  size_t *max_data_length)
+{
+	if (!data || !max_data_length) {
+		return -EINVAL;
+	}
+
+	if (id != NFC_T4T_PARAM_FWI) {
+		return -EINVAL;
+	}
+
+	if (*max_data_length < sizeof(fwi)) {
+		*max_data_length = sizeof(fwi);
+		return -EINVAL;
+	}
+
+	*(u8_t *)data = fwi;
+	*max_data_length = sizeof(fwi);
+
+	return 0;
+}
+
+int nfc_t4t_emulation_start(void)
+{
+	if (running || !callback) {
+		return -ENOTSUP;
+	}
+
+	running = true;
+
+	return 0;
+}
+
+int nfc_t4t_emulation_stop(void)
+{
+	if (!running) {
+		return -ENOTSUP;
+	}
+
+	nfc_host_t4t_field_set(false);
+	running = false;
+
+	return 0;
+}
+
+int nfc_t4t_done(void)
+{
+	if (running) {
+		nfc_t4t_emulation_stop();
+	}
+
+	callback = NULL;
+	ndef_file = NULL;
+	ndef_file_ro = NULL;
+
+	return 0;
+}
+
+bool nfc_host_t4t_running(void)
+{
+	return running;
+}
+
+void nfc_host_t4t_field_set(bool on)
+{
+	if (!running || on == field) {
+		return;
+	}
+
+	field = on;
+	app_selected = false;
+	file_selected = FILE_NONE;
+	pending_rsp = NULL;
+	rsp_expected = false;
+
+	event_send(on ? NFC_T4T_EVENT_FIELD_ON : NFC_T4T_EVENT_FIELD_OFF,
+		   NULL, 0, 0);
+}
+
+static void sw_set(u16_t sw)
+{
+	rapdu[rapdu_length++] = (u8_t)(sw >> 8);
+	rapdu[rapdu_length++] = (u8_t)sw;
+}
+
+static void cc_build(void)
+{
+	size_t max_ndef = ndef_file_size;
+
+	cc[0] = 0x00;
+	cc[1] = sizeof(cc);
+	cc[2] = 0x20;
+	cc[3] = 0x00;
+	cc[4] = NDEF_MLE;
+	cc[5] = 0x00;
+	cc[6] = NDEF_MLC;
+	/* NDEF File Control TLV. */
+	cc[7] = 0x04;
+	cc[8] = 0x06;
+	cc[9] = (u8_t)(FILE_NDEF >> 8);
+	cc[10] = (u8_t)FILE_NDEF;
+	cc[11] = (u8_t)(max_ndef >> 8);
+	cc[12] = (u8_t)max_ndef;
+	cc[13] = 0x00;
+	cc[14] = ndef_file ? 0x00 : 0xFF;
+}
+
+static u16_t nlen_get(void)
+{
+	return (ndef_file_ro[0] << 8) | ndef_file_ro[1];
+}
+
+static u16_t select_handle(const u8_t *capdu, size_t length)
+{
+	u8_t lc;
+	u16_t file_id;
+
+	if (length < 5) {
+		return 0x6700;
+	}
+
+	lc = capdu[4];
+	if (length < 5u + lc) {
+		return 0x6700;
+	}
+
+	if (capdu[2] == SELECT_BY_NAME) {
+		if (lc != sizeof(ndef_aid) ||
+		    memcmp(&capdu[5], ndef_aid, sizeof(ndef_aid))) {
+			return 0x6A82;
+		}
+		app_selected = true;
+		file_selected = FILE_NONE;
+		return 0x9000;
+	}
+
+	if (capdu[2] != SELECT_BY_FILE_ID || lc != 2 || !app_selected) {
+		return 0x6A82;
+	}
+
+	file_id = (capdu[5] << 8) | capdu[6];
+	if (file_id != FILE_CC && file_id != FILE_NDEF) {
+		return 0x6A82;
+	}
+
+	file_selected = file_id;
+
+	return 0x9000;
+}
+
+static u16_t read_handle(const u8_t *capdu, size_t length)
+{
+	const u8_t *file;
+	size_t file_size;
+	size_t ndef_end;
+	size_t offset;
+	size_t le;
+
+	if (length != 5) {
+		return 0x6700;
+	}
+
+	if (file_selected == FILE_CC) {
+		file = cc;
+		file_size = sizeof(cc);
+	} else if (file_selected == FILE_NDEF) {
+		file = ndef_file_ro;
+		file_size = ndef_file_size;
+	} else {
+		return 0x6986;
+	}
+
+	offset = (capdu[2] << 8) | capdu[3];
+	le = capdu[4] ? capdu[4] : 256;
+	if (offset > file_size) {
+		return 0x6B00;
+	}
+
+	le = min(le, (size_t)NDEF_MLE);
+	le = min(le, file_size - offset);
+	memcpy(rapdu, &file[offset], le);
+	rapdu_length = le;
+
+	ndef_end = NLEN_SIZE + nlen_get();
+	if (file_selected == FILE_NDEF && ndef_end > NLEN_SIZE &&
+	    offset < ndef_end && offset + le >= ndef_end) {
+		event_send(NFC_T4T_EVENT_NDEF_READ, NULL, 0, 0);
+	}
+
+	return 0x9000;
+}
+
+static u16_t update_handle(const u8_t *capdu, size_t length)
+{
+	size_t offset;
+	u8_t lc;
+
+	if (file_selected != FILE_NDEF || !ndef_file) {
+		return 0x6982;
+	}
+
+	if (length < 5) {
+		return 0x6700;
+	}
+
+	lc = capdu[4];
+	if (length != 5u + lc) {
+		return 0x6700;
+	}
+
+	offset = (capdu[2] << 8) | capdu[3];
+	if (offset + lc > ndef_file_size) {
+		return 0x6B00;
+	}
+
+	memcpy(&ndef_file[offset], &capdu[5], lc);
+
+	if (offset < NLEN_SIZE) {
+		event_send(NFC_T4T_EVENT_NDEF_UPDATED, NULL, nlen_get(), 0);
+	}
+
+	return 0x9000;
+}
+
+static void ndef_transceive(const u8_t *capdu, size_t length)
+{
+	u16_t sw;
+
+	rapdu_length = 0;
+
+	if (length < 4) {
+		sw = 0x6700;
+	} else if (capdu[1] == APDU_INS_SELECT) {
+		cc_build();
+		sw = select_handle(capdu, length);
+	} else if (capdu[1] == APDU_INS_READ_BINARY) {
+		sw = read_handle(capdu, length);
+	} else if (capdu[1] == APDU_INS_UPDATE_BINARY) {
+		sw = update_handle(capdu, length);
+	} else {
+		sw = 0x6D00;
+	}
+
+	sw_set(sw);
+	pending_rsp = rapdu;
+	pending_rsp_length = rapdu_length;
+}
+
+int nfc_host_t4t_transceive(const u8_t *capdu, size_t capdu_length,
+			    size_t frame_size)
+{
+	if (!running || !field) {
+		return -ENOTCONN;
+	}
+
+	pending_rsp = NULL;
+
+	if (mode == NFC_T4T_EMUMODE_NDEF) {
+		ndef_transceive(capdu, capdu_length);
+		return 0;
+	}
+
+	/* Deliver the command in I-blocks of at most frame_size bytes. */
+	rsp_expected = true;
+	do {
+		size_t chunk = min(capdu_length, frame_size);
+		u32_t flags = (chunk < capdu_length) ?
+			      NFC_T4T_DI_FLAG_MORE : NFC_T4T_DI_FLAG_NONE;
+
+		event_send(NFC_T4T_EVENT_DATA_IND, capdu, chunk, flags);
+		capdu += chunk;
+		capdu_length -= chunk;
+	} while (capdu_length);
+
+	return pending_rsp ? 0 : -EINPROGRESS;
+}
+
+int nfc_host_t4t_response_get(u8_t *buf, size_t *length)
+{
+	if (!pending_rsp) {
+		return -EINPROGRESS;
+	}
+
+	if (pending_rsp_length > *length) {
+		return -ENOMEM;
+	}
+
+	memcpy(buf, pending_rsp, pending_rsp_length);
+	*length = pending_rsp_length;
+	pending_rsp = NULL;
+
+	if (mode == NFC_T4T_EMUMODE_PICC) {
+		event_send(NFC_T4T_EVENT_DATA_TRANSMITTED, NULL, 0, 0);
+	}
+
+	return 0;
+}
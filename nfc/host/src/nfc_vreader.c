@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <misc/util.h>
+
+#include <nfc_vreader.h>
+
+#include "nfc_host.h"
+
+#define T2T_READ_SIZE      16
+#define T2T_BLOCK_SIZE     4
+#define T2T_CC_OFFSET      12
+#define T2T_DATA_BLOCK     4
+#define T2T_CC_MAGIC       0xE1
+
+#define T2T_DATA_OFFSET    16
+#define T2T_AREAS_MAX      4
+
+#define TLV_NULL           0x00
+#define TLV_LOCK_CONTROL   0x01
+#define TLV_MEMORY_CONTROL 0x02
+#define TLV_NDEF           0x03
+#define TLV_TERMINATOR     0xFE
+#define TLV_LONG_FORMAT    0xFF
+
+#define SW_OK              0x9000
+#define SW_SIZE            2
+
+#define CC_FILE_ID         0xE103
+#define CC_SIZE            15
+#define CC_WRITE_GRANTED   0x00
+#define NLEN_SIZE          2
+
+/* Largest data field of a short APDU. */
+#define APDU_SHORT_MAX     0xFF
+
+#define RAPDU_MAX_SIZE     (256 + SW_SIZE)
+
+static const u8_t ndef_aid[] = {0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01};
+
+static size_t frame_size = NFC_VREADER_FRAME_SIZE_DEFAULT;
+
+int nfc_vreader_frame_size_set(size_t size)
+{
+	if (!size) {
+		return -EINVAL;
+	}
+
+	frame_size = size;
+
+	return 0;
+}
+
+size_t nfc_vreader_frame_size_get(void)
+{
+	return frame_size;
+}
+
+void nfc_vreader_field_on(void)
+{
+	nfc_host_t2t_field_set(true);
+	nfc_host_t4t_field_set(true);
+}
+
+void nfc_vreader_field_off(void)
+{
+	nfc_host_t2t_field_set(false);
+	nfc_host_t4t_field_set(false);
+}
+
+int nfc_vreader_t2t_read(u8_t block, u8_t *data)
+{
+	if (!nfc_host_t2t_running()) {
+		return -ENOTCONN;
+	}
+
+	return nfc_host_t2t_read(block, data);
+}
+
+/* Reads the T2T data area byte by byte through a window of one READ. */
+struct t2t_cursor {
+	u8_t window[T2T_READ_SIZE];
+	int window_block;
+	size_t size;
+	/* Areas reserved by Lock Control and Memory Control TLVs. */
+	size_t area_start[T2T_AREAS_MAX];
+	size_t area_size[T2T_AREAS_MAX];
+	size_t area_count;
+};
+
+static int t2t_byte_get(struct t2t_cursor *cursor, size_t offset, u8_t *byte)
+{
+	int block = T2T_DATA_BLOCK + offset / T2T_BLOCK_SIZE;
+	int err;
+
+	if (offset >= cursor->size) {
+		return -EBADMSG;
+	}
+
+	if (cursor->window_block < 0 || block < cursor->window_block ||
+	    block >= cursor->window_block + T2T_READ_SIZE / T2T_BLOCK_SIZE) {
+		err = nfc_host_t2t_read(block, cursor->window);
+		if (err) {
+			return err;
+		}
+		cursor->window_block = block;
+	}
+
+	*byte = cursor->window[(block - cursor->window_block) * T2T_BLOCK_SIZE +
+			       offset % T2T_BLOCK_SIZE];
+
+	return 0;
+}
+
+/* Moves the offset past any reserved area it falls in. */
+static size_t t2t_offset_skip(const struct t2t_cursor *cursor, size_t offset)
+{
+	size_t i = 0;
+
+	while (i < cursor->area_count) {
+		if (offset >= cursor->area_start[i] &&
+		    offset - cursor->area_start[i] < cursor->area_size[i]) {
+			offset = cursor->area_start[i] + cursor->area_size[i];
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	return offset;
+}
+
+static int t2t_tlv_byte_get(struct t2t_cursor *cursor, size_t *offset,
+			    u8_t *byte)
+{
+	*offset = t2t_offset_skip(cursor, *offset);
+
+	return t2t_byte_get(cursor, (*offset)++, byte);
+}
+
+/* Records the area reserved by a control TLV, as a reader has to skip it
+ * when reading the following TLVs.
+ */
+static int t2t_area_add(struct t2t_cursor *cursor, u8_t tag, size_t *offset)
+{
+	u8_t value[3];
+	size_t address;
+	size_t size;
+	int err;
+
+	for (size_t i = 0; i < sizeof(value); i++) {
+		err = t2t_tlv_byte_get(cursor, offset, &value[i]);
+		if (err) {
+			return err;
+		}
+	}
+
+	size = value[1] ? value[1] : 256;
+	if (tag == TLV_LOCK_CONTROL) {
+		size = (size + 7) / 8;
+	}
+
+	address = ((size_t)(value[0] >> 4) << (value[2] & 0x0F)) +
+		  (value[0] & 0x0F);
+	if (address < T2T_DATA_OFFSET ||
+	    cursor->area_count == T2T_AREAS_MAX) {
+		return -EBADMSG;
+	}
+
+	cursor->area_start[cursor->area_count] = address - T2T_DATA_OFFSET;
+	cursor->area_size[cursor->area_count] = size;
+	cursor->area_count++;
+
+	return 0;
+}
+
+int nfc_vreader_t2t_ndef_read(u8_t *msg, size_t *length)
+{
+	struct t2t_cursor cursor = { .window_block = -1 };
+	u8_t header[T2T_READ_SIZE];
+	size_t offset = 0;
+	int err;
+
+	err = nfc_vreader_t2t_read(0, header);
+	if (err) {
+		return err;
+	}
+
+	if (header[T2T_CC_OFFSET] != T2T_CC_MAGIC) {
+		return -EBADMSG;
+	}
+	cursor.size = header[T2T_CC_OFFSET + 2] * 8;
+
+	for (;;) {
+		u8_t tag;
+		u8_t byte;
+		size_t tlv_length;
+
+		err = t2t_tlv_byte_get(&cursor, &offset, &tag);
+		if (err) {
+			return err == -EBADMSG ? -ENOENT : err;
+		}
+
+		if (tag == TLV_NULL) {
+			continue;
+		} else if (tag == TLV_TERMINATOR) {
+			return -ENOENT;
+		}
+
+		err = t2t_tlv_byte_get(&cursor, &offset, &byte);
+		if (err) {
+			return err;
+		}
+
+		tlv_length = byte;
+		if (byte == TLV_LONG_FORMAT) {
+			u8_t lo;
+
+			err = t2t_tlv_byte_get(&cursor, &offset, &byte);
+			if (!err) {
+				err = t2t_tlv_byte_get(&cursor, &offset, &lo);
+			}
+			if (err) {
+				return err;
+			}
+			tlv_length = (byte << 8) | lo;
+		}
+
+		if ((tag == TLV_LOCK_CONTROL || tag == TLV_MEMORY_CONTROL) &&
+		    tlv_length == 3) {
+			err = t2t_area_add(&cursor, tag, &offset);
+			if (err) {
+				return err;
+			}
+			continue;
+		}
+
+		if (tag != TLV_NDEF) {
+			for (size_t i = 0; i < tlv_length; i++) {
+				offset = t2t_offset_skip(&cursor, offset) + 1;
+			}
+			continue;
+		}
+
+		if (tlv_length > *length) {
+			return -ENOMEM;
+		}
+
+		for (size_t i = 0; i < tlv_length; i++) {
+			err = t2t_tlv_byte_get(&cursor, &offset, &msg[i]);
+			if (err) {
+				return err;
+			}
+		}
+
+		*length = tlv_length;
+		return 0;
+	}
+}
+
+int nfc_vreader_t4t_transceive(const u8_t *capdu, size_t capdu_length,
+			       u8_t *rapdu, size_t *rapdu_length)
+{
+	int err;
+
+	if (!nfc_host_t4t_running()) {
+		return -ENOTCONN;
+	}
+
+	err = nfc_host_t4t_transceive(capdu, capdu_length, frame_size);
+	if (err) {
+		return err;
+	}
+
+	return nfc_host_t4t_response_get(rapdu, rapdu_length);
+}
+
+int nfc_vreader_t4t_response_get(u8_t *rapdu, size_t *rapdu_length)
+{
+	return nfc_host_t4t_response_get(rapdu, rapdu_length);
+}
+
+/* Exchanges a command and checks its status word. On success, rsp_length
+ * receives the length of the response data.
+ */
+static int t4t_command(const u8_t *capdu, size_t capdu_length, u8_t *rsp,
+		       size_t *rsp_length)
+{
+	size_t length = RAPDU_MAX_SIZE;
+	int err;
+
+	err = nfc_vreader_t4t_transceive(capdu, capdu_length, rsp, &length);
+	if (err) {
+		return err;
+	}
+
+	if (length < SW_SIZE ||
+	    ((rsp[length - 2] << 8) | rsp[length - 1]) != SW_OK) {
+		return -EIO;
+	}
+
+	*rsp_length = length - SW_SIZE;
+
+	return 0;
+}
+
+static int t4t_select_file(u16_t file_id, u8_t *rsp)
+{
+	const u8_t capdu[] = {
+		0x00, 0xA4, 0x00, 0x0C, 0x02, (u8_t)(file_id >> 8),
+		(u8_t)file_id
+	};
+	size_t length;
+
+	return t4t_command(capdu, sizeof(capdu), rsp, &length);
+}
+
+static int t4t_read_binary(u16_t offset, u8_t le, u8_t *rsp,
+			   size_t *rsp_length)
+{
+	const u8_t capdu[] = {
+		0x00, 0xB0, (u8_t)(offset >> 8), (u8_t)offset, le
+	};
+
+	return t4t_command(capdu, sizeof(capdu), rsp, rsp_length);
+}
+
+static int t4t_update_binary(u16_t offset, const u8_t *data, u8_t lc,
+			     u8_t *rsp)
+{
+	u8_t capdu[5 + APDU_SHORT_MAX];
+	size_t length;
+
+	capdu[0] = 0x00;
+	capdu[1] = 0xD6;
+	capdu[2] = (u8_t)(offset >> 8);
+	capdu[3] = (u8_t)offset;
+	capdu[4] = lc;
+	memcpy(&capdu[5], data, lc);
+
+	return t4t_command(capdu, 5 + lc, rsp, &length);
+}
+
+struct t4t_cc {
+	size_t mle;
+	size_t mlc;
+	u16_t file_id;
+	size_t file_size;
+	bool writable;
+};
+
+/* Selects the NDEF application and file, and reads the capability
+ * container on the way.
+ */
+static int t4t_ndef_file_select(struct t4t_cc *cc, u8_t *rsp)
+{
+	u8_t capdu[6 + sizeof(ndef_aid)];
+	size_t length;
+	int err;
+
+	capdu[0] = 0x00;
+	capdu[1] = 0xA4;
+	capdu[2] = 0x04;
+	capdu[3] = 0x00;
+	capdu[4] = sizeof(ndef_aid);
+	memcpy(&capdu[5], ndef_aid, sizeof(ndef_aid));
+	capdu[5 + sizeof(ndef_aid)] = 0x00;
+
+	err = t4t_command(capdu, sizeof(capdu), rsp, &length);
+	if (!err) {
+		err = t4t_select_file(CC_FILE_ID, rsp);
+	}
+	if (!err) {
+		err = t4t_read_binary(0, CC_SIZE, rsp, &length);
+	}
+	if (err) {
+		return err;
+	}
+
+	if (length < CC_SIZE || rsp[7] != 0x04) {
+		return -EBADMSG;
+	}
+
+	cc->mle = min((size_t)((rsp[3] << 8) | rsp[4]), (size_t)APDU_SHORT_MAX);
+	cc->mlc = min((size_t)((rsp[5] << 8) | rsp[6]), (size_t)APDU_SHORT_MAX);
+	cc->file_id = (rsp[9] << 8) | rsp[10];
+	cc->file_size = (rsp[11] << 8) | rsp[12];
+	cc->writable = rsp[14] == CC_WRITE_GRANTED;
+
+	if (!cc->mle || !cc->mlc || cc->file_size < NLEN_SIZE) {
+		return -EBADMSG;
+	}
+
+	return t4t_select_file(cc->file_id, rsp);
+}
+
+int nfc_vreader_t4t_ndef_read(u8_t *msg, size_t *length)
+{
+	u8_t rsp[RAPDU_MAX_SIZE];
+	struct t4t_cc cc;
+	size_t rsp_length;
+	size_t nlen;
+	size_t done = 0;
+	int err;
+
+	err = t4t_ndef_file_select(&cc, rsp);
+	if (!err) {
+		err = t4t_read_binary(0, NLEN_SIZE, rsp, &rsp_length);
+	}
+	if (err) {
+		return err;
+	}
+
+	if (rsp_length != NLEN_SIZE) {
+		return -EBADMSG;
+	}
+
+	nlen = (rsp[0] << 8) | rsp[1];
+	if (nlen > cc.file_size - NLEN_SIZE) {
+		return -EBADMSG;
+	}
+	if (nlen > *length) {
+		return -ENOMEM;
+	}
+
+	while (done < nlen) {
+		size_t chunk = min(nlen - done, cc.mle);
+
+		err = t4t_read_binary(NLEN_SIZE + done, chunk, rsp,
+				      &rsp_length);
+		if (err) {
+			return err;
+		}
+		if (rsp_length != chunk) {
+			return -EBADMSG;
+		}
+
+		memcpy(&msg[done], rsp, chunk);
+		done += chunk;
+	}
+
+	*length = nlen;
+
+	return 0;
+}
+
+int nfc_vreader_t4t_ndef_write(const u8_t *msg, size_t length)
+{
+	static const u8_t nlen_clear[NLEN_SIZE];
+	u8_t rsp[RAPDU_MAX_SIZE];
+	u8_t nlen[NLEN_SIZE];
+	struct t4t_cc cc;
+	size_t done = 0;
+	int err;
+
+	err = t4t_ndef_file_select(&cc, rsp);
+	if (err) {
+		return err;
+	}
+
+	if (!cc.writable) {
+		return -EIO;
+	}
+
+	if (length > cc.file_size - NLEN_SIZE) {
+		return -ENOMEM;
+	}
+
+	err = t4t_update_binary(0, nlen_clear, NLEN_SIZE, rsp);
+	if (err) {
+		return err;
+	}
+
+	while (done < length) {
+		size_t chunk = min(length - done, cc.mlc);
+
+		err = t4t_update_binary(NLEN_SIZE + done, &msg[done], chunk,
+					rsp);
+		if (err) {
+			return err;
+		}
+
+		done += chunk;
+	}
+
+	nlen[0] = (u8_t)(length >> 8);
+	nlen[1] = (u8_t)length;
+
+	return t4t_update_binary(0, nlen, NLEN_SIZE, rsp);
+}
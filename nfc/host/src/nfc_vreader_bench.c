@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <misc/util.h>
+
+#include <nfc_t4t_lib.h>
+#include <nfc_vreader.h>
+#include <nfc_vreader_bench.h>
+
+#include "nfc_host.h"
+
+#define FC_HZ              13560000ULL
+#define NSEC_PER_SEC       1000000000ULL
+#define USEC_PER_SEC       1000000ULL
+
+/* 106 kbit/s: one bit per 128 carrier cycles, 8 data bits and a parity
+ * bit per byte, start and end of frame.
+ */
+#define BIT_CYCLES         128
+#define BYTE_BITS          9
+#define FRAME_EXTRA_BITS   2
+
+/* Minimum frame delay time, ISO/IEC 14443-3, for the last bit being 1. */
+#define FDT_CYCLES         1172
+
+/* Frame waiting time unit, FWT = 256 * 16 / fc * 2^FWI. */
+#define FWT_CYCLES         4096
+
+#define T2T_DATA_BLOCK     4
+#define T2T_READ_SIZE      16
+#define T2T_READ_CMD_SIZE  2
+
+#define CRC_SIZE           2
+#define PCB_SIZE           1
+#define R_BLOCK_SIZE       (PCB_SIZE + CRC_SIZE)
+#define S_WTX_SIZE         (PCB_SIZE + 1 + CRC_SIZE)
+
+#define SW_OK              0x9000
+#define SW_SIZE            2
+#define CC_FILE_ID         0xE103
+#define CC_SIZE            15
+#define NLEN_SIZE          2
+#define APDU_SHORT_MAX     0xFF
+#define RAPDU_MAX_SIZE     (256 + SW_SIZE)
+#define NDEF_FILE_MAX      0xFFFE
+
+static const u8_t ndef_aid[] = {0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01};
+
+static u32_t samples[NFC_VREADER_BENCH_SAMPLES_MAX];
+static u8_t file_copy[NDEF_FILE_MAX];
+static u64_t handling_add_ns;
+
+struct t4t_file {
+	size_t mle;
+	size_t mlc;
+	size_t length;
+};
+
+static u64_t cycles_to_ns(u64_t cycles)
+{
+	return cycles * NSEC_PER_SEC / FC_HZ;
+}
+
+/* Air time of a frame and of the frame delay time that follows it. */
+static u64_t frame_ns(size_t bytes)
+{
+	return cycles_to_ns((u64_t)(bytes * BYTE_BITS + FRAME_EXTRA_BITS) *
+			    BIT_CYCLES + FDT_CYCLES);
+}
+
+static u64_t host_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (u64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void result_start(struct nfc_vreader_bench_result *result)
+{
+	memset(result, 0, sizeof(*result));
+}
+
+static void sample_add(struct nfc_vreader_bench_result *result,
+		       u64_t latency_ns, size_t bytes)
+{
+	u32_t latency_us = (u32_t)(latency_ns / 1000);
+
+	if (result->transactions < NFC_VREADER_BENCH_SAMPLES_MAX) {
+		samples[result->transactions] = latency_us;
+	}
+
+	result->transactions++;
+	result->bytes += bytes;
+	result->total_us += latency_us;
+}
+
+static int sample_cmp(const void *a, const void *b)
+{
+	u32_t x = *(const u32_t *)a;
+	u32_t y = *(const u32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of the sorted samples. */
+static u32_t percentile(u32_t count, u32_t p)
+{
+	u32_t rank = (p * count + 99) / 100;
+
+	return samples[rank ? rank - 1 : 0];
+}
+
+static void result_finish(struct nfc_vreader_bench_result *result)
+{
+	u32_t count = min(result->transactions,
+			  (u32_t)NFC_VREADER_BENCH_SAMPLES_MAX);
+
+	if (!count) {
+		return;
+	}
+
+	qsort(samples, count, sizeof(samples[0]), sample_cmp);
+
+	result->p50_us = percentile(count, 50);
+	result->p90_us = percentile(count, 90);
+	result->p99_us = percentile(count, 99);
+	result->max_us = samples[count - 1];
+
+	if (result->total_us) {
+		result->bytes_per_s = (u32_t)((u64_t)result->bytes *
+					      USEC_PER_SEC /
+					      result->total_us);
+	}
+}
+
+void nfc_vreader_bench_handling_set(u32_t handling_us)
+{
+	handling_add_ns = (u64_t)handling_us * 1000;
+}
+
+int nfc_vreader_bench_t2t_read(size_t length, u32_t iterations,
+			       struct nfc_vreader_bench_result *result)
+{
+	u8_t data[T2T_READ_SIZE];
+	u64_t start;
+	int err;
+
+	if (!length || !result) {
+		return -EINVAL;
+	}
+
+	result_start(result);
+
+	for (u32_t i = 0; i < iterations; i++) {
+		for (size_t offset = 0; offset < length;
+		     offset += T2T_READ_SIZE) {
+			start = host_ns();
+			err = nfc_vreader_t2t_read(T2T_DATA_BLOCK + offset / 4,
+						   data);
+			if (err) {
+				return err;
+			}
+
+			result->frames += 2;
+			sample_add(result, host_ns() - start +
+				   frame_ns(T2T_READ_CMD_SIZE + CRC_SIZE) +
+				   frame_ns(T2T_READ_SIZE + CRC_SIZE),
+				   min(length - offset, (size_t)T2T_READ_SIZE));
+		}
+	}
+
+	result_finish(result);
+
+	return 0;
+}
+
+/* Air time of an APDU split into I-blocks, the chained ones each
+ * acknowledged by the other side.
+ */
+static u64_t apdu_ns(size_t length, size_t frame_size, u32_t *frames)
+{
+	size_t blocks = max((length + frame_size - 1) / frame_size,
+			    (size_t)1);
+	u64_t ns = 0;
+
+	for (size_t i = 0; i < blocks; i++) {
+		size_t inf = min(length - i * frame_size, frame_size);
+
+		ns += frame_ns(PCB_SIZE + inf + CRC_SIZE);
+		(*frames)++;
+
+		if (i + 1 < blocks) {
+			ns += frame_ns(R_BLOCK_SIZE);
+			(*frames)++;
+		}
+	}
+
+	return ns;
+}
+
+static u64_t fwt_ns(void)
+{
+	size_t length = sizeof(u8_t);
+	u8_t fwi = 4;
+
+	nfc_t4t_parameter_get(NFC_T4T_PARAM_FWI, &fwi, &length);
+
+	return cycles_to_ns((u64_t)FWT_CYCLES << fwi);
+}
+
+/* Runs a command and checks its status word. Adds the transaction to the
+ * results if given.
+ */
+static int t4t_command(const u8_t *capdu, size_t capdu_length, u8_t *rsp,
+		       size_t *rsp_length,
+		       struct nfc_vreader_bench_result *result, size_t bytes)
+{
+	size_t frame_size = nfc_vreader_frame_size_get();
+	size_t length = RAPDU_MAX_SIZE;
+	u64_t handling;
+	u64_t latency;
+	u64_t fwt;
+	u32_t wtx;
+	int err;
+
+	handling = host_ns();
+	err = nfc_vreader_t4t_transceive(capdu, capdu_length, rsp, &length);
+	handling = host_ns() - handling + handling_add_ns;
+	if (err) {
+		return err;
+	}
+
+	if (length < SW_SIZE ||
+	    ((rsp[length - 2] << 8) | rsp[length - 1]) != SW_OK) {
+		return -EIO;
+	}
+
+	if (result) {
+		fwt = fwt_ns();
+		wtx = (u32_t)(handling / fwt);
+
+		latency = apdu_ns(capdu_length, frame_size, &result->frames) +
+			  handling +
+			  wtx * 2 * frame_ns(S_WTX_SIZE) +
+			  apdu_ns(length, frame_size, &result->frames);
+
+		result->frames += 2 * wtx;
+		result->wtx += wtx;
+		sample_add(result, latency, bytes);
+	}
+
+	*rsp_length = length - SW_SIZE;
+
+	return 0;
+}
+
+static int t4t_select(u8_t p1, u8_t p2, const u8_t *id, u8_t id_length)
+{
+	u8_t capdu[5 + sizeof(ndef_aid)];
+	u8_t rsp[RAPDU_MAX_SIZE];
+	size_t length;
+
+	capdu[0] = 0x00;
+	capdu[1] = 0xA4;
+	capdu[2] = p1;
+	capdu[3] = p2;
+	capdu[4] = id_length;
+	memcpy(&capdu[5], id, id_length);
+
+	return t4t_command(capdu, 5 + id_length, rsp, &length, NULL, 0);
+}
+
+static int t4t_read(size_t offset, size_t le, u8_t *data,
+		    struct nfc_vreader_bench_result *result)
+{
+	const u8_t capdu[] = {
+		0x00, 0xB0, (u8_t)(offset >> 8), (u8_t)offset, (u8_t)le
+	};
+	u8_t rsp[RAPDU_MAX_SIZE];
+	size_t length;
+	int err;
+
+	err = t4t_command(capdu, sizeof(capdu), rsp, &length, result, le);
+	if (err) {
+		return err;
+	}
+
+	if (length != le) {
+		return -EIO;
+	}
+
+	memcpy(data, rsp, le);
+
+	return 0;
+}
+
+static int t4t_update(size_t offset, const u8_t *data, size_t lc,
+		      struct nfc_vreader_bench_result *result)
+{
+	u8_t capdu[5 + APDU_SHORT_MAX];
+	u8_t rsp[RAPDU_MAX_SIZE];
+	size_t length;
+
+	capdu[0] = 0x00;
+	capdu[1] = 0xD6;
+	capdu[2] = (u8_t)(offset >> 8);
+	capdu[3] = (u8_t)offset;
+	capdu[4] = (u8_t)lc;
+	memcpy(&capdu[5], data, lc);
+
+	return t4t_command(capdu, 5 + lc, rsp, &length, result, lc);
+}
+
+/* Selects the NDEF file and reads its length, outside of the
+ * measurement.
+ */
+static int t4t_file_open(struct t4t_file *file)
+{
+	const u8_t cc_id[] = {(u8_t)(CC_FILE_ID >> 8), (u8_t)CC_FILE_ID};
+	u8_t cc[CC_SIZE];
+	u8_t nlen[NLEN_SIZE];
+	int err;
+
+	err = t4t_select(0x04, 0x00, ndef_aid, sizeof(ndef_aid));
+	if (!err) {
+		err = t4t_select(0x00, 0x0C, cc_id, sizeof(cc_id));
+	}
+	if (!err) {
+		err = t4t_read(0, sizeof(cc), cc, NULL);
+	}
+	if (!err) {
+		err = t4t_select(0x00, 0x0C, &cc[9], 2);
+	}
+	if (!err) {
+		err = t4t_read(0, sizeof(nlen), nlen, NULL);
+	}
+	if (err) {
+		return err;
+	}
+
+	file->mle = min((size_t)((cc[3] << 8) | cc[4]),
+			(size_t)APDU_SHORT_MAX);
+	file->mlc = min((size_t)((cc[5] << 8) | cc[6]),
+			(size_t)APDU_SHORT_MAX);
+	file->length = NLEN_SIZE + ((nlen[0] << 8) | nlen[1]);
+
+	if (!file->mle || !file->mlc || file->length > sizeof(file_copy)) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int nfc_vreader_bench_t4t_read(size_t chunk, u32_t iterations,
+			       struct nfc_vreader_bench_result *result)
+{
+	struct t4t_file file;
+	int err;
+
+	if (!chunk || chunk > APDU_SHORT_MAX || !result) {
+		return -EINVAL;
+	}
+
+	result_start(result);
+
+	err = t4t_file_open(&file);
+	if (err) {
+		return err;
+	}
+
+	chunk = min(chunk, file.mle);
+
+	for (u32_t i = 0; i < iterations; i++) {
+		for (size_t offset = 0; offset < file.length;
+		     offset += chunk) {
+			err = t4t_read(offset,
+				       min(chunk, file.length - offset),
+				       &file_copy[offset], result);
+			if (err) {
+				return err;
+			}
+		}
+	}
+
+	result_finish(result);
+
+	return 0;
+}
+
+int nfc_vreader_bench_t4t_update(size_t chunk, u32_t iterations,
+				 struct nfc_vreader_bench_result *result)
+{
+	struct t4t_file file;
+	int err;
+
+	if (!chunk || chunk > APDU_SHORT_MAX || !result) {
+		return -EINVAL;
+	}
+
+	result_start(result);
+
+	err = t4t_file_open(&file);
+	if (err) {
+		return err;
+	}
+
+	for (size_t offset = 0; offset < file.length; offset += file.mle) {
+		err = t4t_read(offset, min(file.mle, file.length - offset),
+			       &file_copy[offset], NULL);
+		if (err) {
+			return err;
+		}
+	}
+
+	chunk = min(chunk, file.mlc);
+
+	for (u32_t i = 0; i < iterations; i++) {
+		for (size_t offset = 0; offset < file.length;
+		     offset += chunk) {
+			err = t4t_update(offset, &file_copy[offset],
+					 min(chunk, file.length - offset),
+					 result);
+			if (err) {
+				return err;
+			}
+		}
+	}
+
+	result_finish(result);
+
+	return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* CRC-16-CCITT as computed by the Zephyr crc16_ccitt(). */
+
+#ifndef FAKE_CRC16_H__
+#define FAKE_CRC16_H__
+
+#include <stddef.h>
+#include <zephyr/types.h>
+
+static inline u16_t crc16_ccitt(u16_t seed, const u8_t *src, size_t len)
+{
+	for (; len > 0; len--) {
+		u8_t e = seed ^ *src++;
+		u8_t f = e ^ (e << 4);
+
+		seed = (seed >> 8) ^ (f << 8) ^ (f << 3) ^ (f >> 4);
+	}
+
+	return seed;
+}
+
+#endif /* FAKE_CRC16_H__ */
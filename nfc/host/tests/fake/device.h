@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Fake of the Zephyr device API. Devices are opaque to the modules. */
+
+#ifndef FAKE_DEVICE_H__
+#define FAKE_DEVICE_H__
+
+struct device;
+
+#endif /* FAKE_DEVICE_H__ */
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Fake of the Zephyr flash API. The test program defines the functions. */
+
+#ifndef FAKE_FLASH_H__
+#define FAKE_FLASH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <device.h>
+
+int flash_read(struct device *dev, off_t offset, void *data, size_t len);
+int flash_write(struct device *dev, off_t offset, const void *data,
+		size_t len);
+int flash_erase(struct device *dev, off_t offset, size_t size);
+int flash_write_protection_set(struct device *dev, bool enable);
+size_t flash_get_write_block_size(struct device *dev);
+
+#endif /* FAKE_FLASH_H__ */
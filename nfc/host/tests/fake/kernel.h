@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Fake of the Zephyr kernel API used by the helper modules under test.
+ * Work items run right away in the caller, and mutexes and interrupt locks
+ * do nothing, as the tests are single-threaded.
+ */
+
+#ifndef FAKE_KERNEL_H__
+#define FAKE_KERNEL_H__
+
+#include <zephyr/types.h>
+#include <misc/util.h>
+
+#define ARG_UNUSED(x) (void)(x)
+
+#define BUILD_ASSERT_MSG(expr, msg) _Static_assert(expr, msg)
+
+#define K_FOREVER (-1)
+
+struct k_work;
+
+typedef void (*k_work_handler_t)(struct k_work *work);
+
+struct k_work {
+	k_work_handler_t handler;
+};
+
+#define K_WORK_DEFINE(work, work_handler) \
+	struct k_work work = { .handler = work_handler }
+
+static inline void k_work_submit(struct k_work *work)
+{
+	work->handler(work);
+}
+
+struct k_mutex {
+	int unused;
+};
+
+#define K_MUTEX_DEFINE(name) struct k_mutex name
+
+static inline int k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
+{
+	return 0;
+}
+
+static inline void k_mutex_unlock(struct k_mutex *mutex)
+{
+}
+
+static inline unsigned int irq_lock(void)
+{
+	return 0;
+}
+
+static inline void irq_unlock(unsigned int key)
+{
+}
+
+#endif /* FAKE_KERNEL_H__ */
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* nfc_ble_oob with AES-CTR from OpenSSL in place of nrf_oberon. AES-CMAC is
+ * checked against the RFC 4493 examples and f4 against the Bluetooth Core
+ * Specification sample data, so the module is included to reach them. The
+ * P-256 public key is a stand-in derived from the private key, as only its
+ * use in the confirmation value is under test.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <openssl/evp.h>
+
+#include "nfc_ble_oob.c"
+
+#include "test_util.h"
+
+void ocrypto_aes_ctr_init(ocrypto_aes_ctr_ctx *ctx, const uint8_t *key,
+			  size_t size, const uint8_t iv[16])
+{
+	memcpy(ctx->xkey, key, size);
+	memcpy(ctx->counter, iv, sizeof(ctx->counter));
+	ctx->size = size;
+}
+
+void ocrypto_aes_ctr_encrypt(ocrypto_aes_ctr_ctx *ctx, uint8_t *ct,
+			     const uint8_t *pt, size_t pt_len)
+{
+	EVP_CIPHER_CTX *evp = EVP_CIPHER_CTX_new();
+	int length;
+
+	TEST_CHECK_EQ(ctx->size, 16);
+	EVP_EncryptInit_ex(evp, EVP_aes_128_ctr(), NULL,
+			   (const u8_t *)ctx->xkey, ctx->counter);
+	EVP_EncryptUpdate(evp, ct, &length, pt, pt_len);
+	EVP_CIPHER_CTX_free(evp);
+}
+
+int ocrypto_ecdh_p256_public_key(uint8_t r[64], const uint8_t s[32])
+{
+	for (size_t i = 0; i < 64; i++) {
+		r[i] = s[i % 32] ^ (u8_t)i;
+	}
+
+	return 0;
+}
+
+static int rand_fill(u8_t *buf, size_t length)
+{
+	static u8_t next = 1;
+
+	for (size_t i = 0; i < length; i++) {
+		buf[i] = next++;
+	}
+
+	return 0;
+}
+
+static void hex_decode(const char *hex, u8_t *out, size_t length)
+{
+	for (size_t i = 0; i < length; i++) {
+		sscanf(&hex[2 * i], "%2hhx", &out[i]);
+	}
+}
+
+static void test_cmac(void)
+{
+	static const size_t lengths[] = {16, 40, 64};
+	static const char *const macs[] = {
+		"070a16b46b4d4144f79bdd9dd04a287c",
+		"dfa66747de9ae63030ca32611497c827",
+		"51f0bebf7e3b9d92fc49741779363cfe",
+	};
+	u8_t key[16];
+	u8_t msg[64];
+	u8_t mac[16];
+	u8_t expected[16];
+
+	hex_decode("2b7e151628aed2a6abf7158809cf4f3c", key, sizeof(key));
+	hex_decode("6bc1bee22e409f96e93d7e117393172a"
+		   "ae2d8a571e03ac9c9eb76fac45af8e51"
+		   "30c81c46a35ce411e5fbc1191a0a52ef"
+		   "f69f2445df4f9b17ad2b417be66c3710", msg, sizeof(msg));
+
+	/* Examples 2 to 4, the module never authenticates empty messages. */
+	for (size_t i = 0; i < ARRAY_SIZE(lengths); i++) {
+		aes_cmac(key, msg, lengths[i], mac);
+		hex_decode(macs[i], expected, sizeof(expected));
+		TEST_CHECK(!memcmp(mac, expected, sizeof(mac)));
+	}
+}
+
+static void test_f4(void)
+{
+	u8_t u[32];
+	u8_t v[32];
+	u8_t x[16];
+	u8_t out[16];
+	u8_t expected[16];
+
+	hex_decode("20b003d2f297be2c5e2c83a7e9f9a5b9"
+		   "eff49111acf4fddbcc0301480e359de6", u, sizeof(u));
+	hex_decode("55188b3d32f6bb9a900afcfbeed4e72a"
+		   "59cb9ac2f19d7cfb6b4fdd49f47fc5fd", v, sizeof(v));
+	hex_decode("d5cb8454d177733effffb2ec712baeab", x, sizeof(x));
+	hex_decode("f2c916f107a9bd1cf1eda1bea974872d", expected,
+		   sizeof(expected));
+
+	f4(u, v, x, 0, out);
+	TEST_CHECK(!memcmp(out, expected, sizeof(out)));
+}
+
+static bool contains(const u8_t *buf, size_t length, const u8_t *value,
+		     size_t value_length)
+{
+	for (size_t i = 0; i + value_length <= length; i++) {
+		if (!memcmp(&buf[i], value, value_length)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void test_msg(void)
+{
+	const struct nfc_ble_oob_config config = {
+		.addr = {1, 2, 3, 4, 5, 6},
+		.addr_type = 1,
+		.role = NFC_BLE_OOB_ROLE_PERIPH,
+		.rand = rand_fill,
+	};
+	const struct nfc_ble_oob_config no_rand = {0};
+	struct nfc_ble_oob_sc sc;
+	struct nfc_ble_oob_sc next;
+	u8_t msg[NFC_BLE_OOB_MSG_MAX_SIZE];
+	u8_t r[16];
+	u8_t c[16];
+	u32_t length;
+
+	TEST_CHECK_EQ(nfc_ble_oob_init(&no_rand), -EINVAL);
+	TEST_CHECK_EQ(nfc_ble_oob_init(&config), 0);
+	TEST_CHECK_EQ(nfc_ble_oob_sc_get(&sc), 0);
+
+	/* The values are little-endian, f4 works on big-endian ones. */
+	swap_copy(r, sc.r, sizeof(r));
+	f4(sc.pk, sc.pk, r, 0, c);
+	swap_copy(r, c, sizeof(c));
+	TEST_CHECK(!memcmp(sc.c, r, sizeof(sc.c)));
+
+	length = sizeof(msg);
+	TEST_CHECK_EQ(nfc_ble_oob_msg_get(NFC_NDEF_MSG_FORMAT_T4T, msg,
+					  &length), 0);
+	TEST_CHECK_EQ((msg[0] << 8) | msg[1], length - NFC_NDEF_MSG_NLEN_SIZE);
+	TEST_CHECK(contains(msg, length, config.addr, sizeof(config.addr)));
+	TEST_CHECK(contains(msg, length, sc.c, sizeof(sc.c)));
+	TEST_CHECK(contains(msg, length, sc.r, sizeof(sc.r)));
+
+	length = 10;
+	TEST_CHECK_EQ(nfc_ble_oob_msg_get(NFC_NDEF_MSG_FORMAT_RAW, msg,
+					  &length), -ENOMEM);
+
+	/* The fake work queue runs the refresh at once. */
+	nfc_ble_oob_refresh();
+	TEST_CHECK_EQ(nfc_ble_oob_sc_get(&next), 0);
+	TEST_CHECK(memcmp(next.r, sc.r, sizeof(sc.r)));
+	TEST_CHECK(memcmp(next.c, sc.c, sizeof(sc.c)));
+
+	length = sizeof(msg);
+	TEST_CHECK_EQ(nfc_ble_oob_msg_get(NFC_NDEF_MSG_FORMAT_RAW, msg,
+					  &length), 0);
+	TEST_CHECK(contains(msg, length, next.c, sizeof(next.c)));
+}
+
+int main(void)
+{
+	test_cmac();
+	test_f4();
+	test_msg();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* nfc_ndef_journal over a simulated flash. Every update is followed by a
+ * reboot, i.e. a recovery into a fresh file, and then updates are synced
+ * without reboots across a compaction. Power is then cut at each of the
+ * first POWER_LOSS_POINTS programmed bytes or erases of an update, and the
+ * recovered content must be either the old or the new one.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <kernel.h>
+#include <flash.h>
+
+#include <nfc_ndef_journal.h>
+
+#include "test_util.h"
+
+#define PAGE_SIZE         256
+#define PAGE_COUNT        3
+#define FILE_SIZE         100
+#define UPDATES           200
+#define POWER_LOSS_POINTS 400
+
+static u8_t flash[PAGE_SIZE * PAGE_COUNT];
+static struct device *flash_dev = (struct device *)flash;
+
+/* Flash operations left before the power is cut, or -1 for no cut. A byte
+ * being programmed when the power is cut gets random bits cleared, and a
+ * page being erased is left half erased.
+ */
+static long power_budget = -1;
+static u32_t erases;
+
+int flash_read(struct device *dev, off_t offset, void *data, size_t len)
+{
+	memcpy(data, &flash[offset], len);
+
+	return 0;
+}
+
+int flash_write(struct device *dev, off_t offset, const void *data,
+		size_t len)
+{
+	const u8_t *src = data;
+
+	for (size_t i = 0; i < len; i++) {
+		if (power_budget == 0) {
+			flash[offset + i] &= (u8_t)rand();
+			return -EIO;
+		}
+		if (power_budget > 0) {
+			power_budget--;
+		}
+
+		/* Programming can only clear bits. */
+		TEST_CHECK_EQ(flash[offset + i] & src[i], src[i]);
+		flash[offset + i] &= src[i];
+	}
+
+	return 0;
+}
+
+int flash_erase(struct device *dev, off_t offset, size_t size)
+{
+	if (power_budget == 0) {
+		memset(&flash[offset], 0xFF, size / 2);
+		return -EIO;
+	}
+
+	memset(&flash[offset], 0xFF, size);
+	erases++;
+
+	return 0;
+}
+
+int flash_write_protection_set(struct device *dev, bool enable)
+{
+	return 0;
+}
+
+size_t flash_get_write_block_size(struct device *dev)
+{
+	return 4;
+}
+
+static void msg_set(u8_t *file, u32_t seed, u32_t length)
+{
+	for (u32_t i = 0; i < length; i++) {
+		file[2 + i] = (u8_t)(seed * 31 + i);
+	}
+	file[0] = (u8_t)(length >> 8);
+	file[1] = (u8_t)length;
+}
+
+static u32_t nlen(const u8_t *file)
+{
+	return (file[0] << 8) | file[1];
+}
+
+static int reboot(u8_t *file, u8_t *shadow)
+{
+	memset(file, 0, FILE_SIZE);
+
+	return nfc_ndef_journal_init(flash_dev, 0, PAGE_SIZE, PAGE_COUNT,
+				     file, shadow, FILE_SIZE);
+}
+
+static void test_updates(u8_t *file, u8_t *shadow)
+{
+	static u8_t recovered[FILE_SIZE];
+	static u8_t recovered_shadow[FILE_SIZE];
+	struct nfc_ndef_journal_stats stats;
+	u32_t syncs = 0;
+	u32_t compactions = 0;
+
+	memset(flash, 0xFF, sizeof(flash));
+	erases = 0;
+
+	TEST_CHECK_EQ(reboot(file, shadow), -ENOENT);
+
+	for (u32_t v = 1; v < UPDATES; v++) {
+		msg_set(file, v, 10 + (v % 7) * 5);
+		nfc_ndef_journal_t4t_event_process(NFC_T4T_EVENT_NDEF_UPDATED);
+
+		/* The statistics start over on every reboot. */
+		nfc_ndef_journal_stats_get(&stats);
+		syncs += stats.syncs;
+		compactions += stats.compactions;
+		TEST_CHECK_EQ(stats.errors, 0);
+
+		TEST_CHECK_EQ(reboot(recovered, recovered_shadow), 0);
+		TEST_CHECK(!memcmp(recovered, file, nlen(file) + 2));
+
+		/* Continue from the recovered content. */
+		TEST_CHECK_EQ(reboot(file, shadow), 0);
+	}
+
+	/* The first update goes to an empty area as a compaction, every other
+	 * one is synced as changes, some of them falling back to a compaction.
+	 */
+	TEST_CHECK_EQ(syncs, UPDATES - 2);
+	TEST_CHECK(compactions > 0);
+	TEST_CHECK_EQ(compactions, erases);
+}
+
+static void test_no_reboot(u8_t *file, u8_t *shadow)
+{
+	static u8_t recovered[FILE_SIZE];
+	static u8_t recovered_shadow[FILE_SIZE];
+	struct nfc_ndef_journal_stats stats;
+	u32_t compactions;
+
+	memset(flash, 0xFF, sizeof(flash));
+
+	TEST_CHECK_EQ(reboot(file, shadow), -ENOENT);
+	msg_set(file, 1, 90);
+	TEST_CHECK_EQ(nfc_ndef_journal_sync(), 0);
+
+	/* Shorter messages leave the end of the long one in the file, past
+	 * NLEN, until a snapshot leaves it out.
+	 */
+	nfc_ndef_journal_stats_get(&stats);
+	compactions = stats.compactions;
+	for (u32_t v = 2; stats.compactions == compactions && v < 100; v++) {
+		msg_set(file, v, 3);
+		TEST_CHECK_EQ(nfc_ndef_journal_sync(), 0);
+		nfc_ndef_journal_stats_get(&stats);
+	}
+	TEST_CHECK(stats.compactions > compactions);
+
+	/* The long message comes back with the same end. */
+	msg_set(file, 1, 90);
+	TEST_CHECK_EQ(nfc_ndef_journal_sync(), 0);
+
+	TEST_CHECK_EQ(reboot(recovered, recovered_shadow), 0);
+	TEST_CHECK(!memcmp(recovered, file, nlen(file) + 2));
+}
+
+static void test_power_loss(u8_t *file, u8_t *shadow)
+{
+	static u8_t old[FILE_SIZE];
+	static u8_t recovered[FILE_SIZE];
+	static u8_t recovered_shadow[FILE_SIZE];
+	u32_t old_count = 0;
+	u32_t new_count = 0;
+	int err;
+
+	for (long budget = 0; budget < POWER_LOSS_POINTS; budget++) {
+		TEST_CHECK_EQ(reboot(file, shadow), 0);
+		memcpy(old, file, sizeof(old));
+
+		msg_set(file, 1000 + budget, 10 + (budget % 13) * 6);
+
+		power_budget = budget;
+		nfc_ndef_journal_sync();
+		power_budget = -1;
+
+		err = reboot(recovered, recovered_shadow);
+		TEST_CHECK_EQ(err, 0);
+
+		if (!memcmp(recovered, file, nlen(file) + 2)) {
+			new_count++;
+		} else if (!memcmp(recovered, old, nlen(old) + 2)) {
+			old_count++;
+		} else {
+			fprintf(stderr, "power loss after %ld operations: "
+				"content is neither old nor new\n", budget);
+			test_failures++;
+		}
+
+		/* The journal must keep working after the power loss. */
+		TEST_CHECK_EQ(reboot(file, shadow), 0);
+		msg_set(file, 5000 + budget, 20);
+		TEST_CHECK_EQ(nfc_ndef_journal_sync(), 0);
+
+		TEST_CHECK_EQ(reboot(recovered, recovered_shadow), 0);
+		TEST_CHECK(!memcmp(recovered, file, 22));
+	}
+
+	/* Early cuts keep the old content, late ones commit the new one. */
+	TEST_CHECK(old_count > 0);
+	TEST_CHECK(new_count > 0);
+}
+
+int main(void)
+{
+	static u8_t file[FILE_SIZE];
+	static u8_t shadow[FILE_SIZE];
+
+	srand(1);
+
+	test_updates(file, shadow);
+	test_no_reboot(file, shadow);
+	test_power_loss(file, shadow);
+
+	return TEST_RESULT();
+}
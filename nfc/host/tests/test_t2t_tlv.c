@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Raw T2T data area images laid out by nfc_t2t_tlv, checked byte by byte
+ * and read back by the virtual reader through the reserved areas.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <misc/util.h>
+
+#include <nfc_t2t_lib.h>
+#include <nfc_t2t_tlv.h>
+#include <nfc_vreader.h>
+
+#include "test_util.h"
+
+#define NDEF_LENGTH 300
+
+/* Lock Control: page 6, byte 0 with 4-byte pages, i.e. data area offset 8,
+ * 16 lock bits in 2 bytes.
+ */
+#define LOCK_OFFSET 8
+#define LOCK_SIZE   2
+
+/* Memory Control: page 10, byte 3, i.e. data area offset 27, 4 bytes. */
+#define MEM_OFFSET 27
+#define MEM_SIZE   4
+
+static const u8_t lock_value[] = {0x60, 8 * LOCK_SIZE, 0x42};
+static const u8_t mem_value[] = {0xA3, MEM_SIZE, 0x02};
+static const u8_t prop_value[] = {9, 9, 9, 9, 9};
+static const u8_t ndef_short[] = {1, 2, 3};
+static u8_t ndef[NDEF_LENGTH];
+
+static void t2t_callback(void *context, enum nfc_t2t_event event,
+			 const u8_t *data, size_t data_length)
+{
+}
+
+static void test_layout(void)
+{
+	/* Out of order, to check the grouping. */
+	const struct nfc_t2t_tlv tlvs[] = {
+		{NFC_T2T_TLV_PROPRIETARY, prop_value, sizeof(prop_value)},
+		{NFC_T2T_TLV_NDEF, ndef, sizeof(ndef)},
+		{NFC_T2T_TLV_NDEF, ndef_short, sizeof(ndef_short)},
+		{NFC_T2T_TLV_MEMORY_CONTROL, mem_value, sizeof(mem_value)},
+		{NFC_T2T_TLV_LOCK_CONTROL, lock_value, sizeof(lock_value)},
+	};
+	static const u8_t head[] = {
+		0x01, 0x03, 0x60, 0x10, 0x42,
+		0x02, 0x03, 0xA3,
+		0x00, 0x00,
+		0x04, 0x02,
+		0x03, 0xFF, 0x01, 0x2C,
+	};
+	static const u8_t tail[] = {
+		0x03, 0x03, 1, 2, 3,
+		0xFD, 0x05, 9, 9, 9, 9, 9,
+		0xFE,
+	};
+	static u8_t image[NFC_T2T_MAX_PAYLOAD_SIZE_RAW];
+	static u8_t out[NDEF_LENGTH + 1];
+	u32_t dry_length = 0;
+	u32_t length = sizeof(image);
+	u32_t ndef_start = sizeof(head);
+	size_t out_length;
+
+	for (size_t i = 0; i < sizeof(ndef); i++) {
+		ndef[i] = (u8_t)(i + 1);
+	}
+
+	TEST_CHECK_EQ(nfc_t2t_tlv_layout(tlvs, ARRAY_SIZE(tlvs), NULL,
+					 &dry_length), 0);
+	TEST_CHECK_EQ(nfc_t2t_tlv_layout(tlvs, ARRAY_SIZE(tlvs), image,
+					 &length), 0);
+
+	/* Both reserved areas are skipped, and no NULL TLVs are added. */
+	TEST_CHECK_EQ(length, sizeof(head) + sizeof(ndef) + MEM_SIZE +
+		      sizeof(tail));
+	TEST_CHECK_EQ(dry_length, length);
+
+	TEST_CHECK(!memcmp(image, head, sizeof(head)));
+	TEST_CHECK(!memcmp(&image[ndef_start], ndef, MEM_OFFSET - ndef_start));
+	TEST_CHECK(!memcmp(&image[MEM_OFFSET], "\0\0\0\0", MEM_SIZE));
+	TEST_CHECK(!memcmp(&image[MEM_OFFSET + MEM_SIZE],
+			   &ndef[MEM_OFFSET - ndef_start],
+			   sizeof(ndef) - (MEM_OFFSET - ndef_start)));
+	TEST_CHECK(!memcmp(&image[length - sizeof(tail)], tail, sizeof(tail)));
+
+	/* The reader skips the reserved areas and stops at the first NDEF
+	 * TLV.
+	 */
+	TEST_CHECK_EQ(nfc_t2t_setup(t2t_callback, NULL), 0);
+	TEST_CHECK_EQ(nfc_t2t_payload_raw_set(image, length), 0);
+	TEST_CHECK_EQ(nfc_t2t_emulation_start(), 0);
+	nfc_vreader_field_on();
+
+	out_length = sizeof(out);
+	TEST_CHECK_EQ(nfc_vreader_t2t_ndef_read(out, &out_length), 0);
+	TEST_CHECK_EQ(out_length, sizeof(ndef));
+	TEST_CHECK(!memcmp(out, ndef, sizeof(ndef)));
+
+	nfc_vreader_field_off();
+	TEST_CHECK_EQ(nfc_t2t_emulation_stop(), 0);
+	TEST_CHECK_EQ(nfc_t2t_done(), 0);
+
+	length = 100;
+	TEST_CHECK_EQ(nfc_t2t_tlv_layout(tlvs, ARRAY_SIZE(tlvs), image,
+					 &length), -ENOMEM);
+}
+
+static void test_edges(void)
+{
+	static u8_t image[NFC_T2T_MAX_PAYLOAD_SIZE_RAW];
+	static u8_t full[NFC_T2T_MAX_PAYLOAD_SIZE_RAW - 4];
+	static const u8_t lock_header[] = {0x10, 1, 2};
+	const struct nfc_t2t_tlv one = {
+		NFC_T2T_TLV_NDEF, ndef_short, sizeof(ndef_short)
+	};
+	const struct nfc_t2t_tlv whole = {
+		NFC_T2T_TLV_NDEF, full, sizeof(full)
+	};
+	const struct nfc_t2t_tlv bad = {
+		NFC_T2T_TLV_LOCK_CONTROL, lock_header, sizeof(lock_header)
+	};
+	u32_t length;
+
+	length = sizeof(image);
+	TEST_CHECK_EQ(nfc_t2t_tlv_layout(&one, 1, image, &length), 0);
+	TEST_CHECK_EQ(length, 6);
+	TEST_CHECK_EQ(image[0], NFC_T2T_TLV_NDEF);
+	TEST_CHECK_EQ(image[1], sizeof(ndef_short));
+	TEST_CHECK_EQ(image[5], NFC_T2T_TLV_TERMINATOR);
+
+	/* No Terminator TLV after an image that fills the data area. */
+	length = sizeof(image);
+	TEST_CHECK_EQ(nfc_t2t_tlv_layout(&whole, 1, image, &length), 0);
+	TEST_CHECK_EQ(length, NFC_T2T_MAX_PAYLOAD_SIZE_RAW);
+
+	/* A control TLV reserving the tag header. */
+	length = sizeof(image);
+	TEST_CHECK_EQ(nfc_t2t_tlv_layout(&bad, 1, image, &length), -EINVAL);
+}
+
+int main(void)
+{
+	test_layout();
+	test_edges();
+
+	return TEST_RESULT();
+}
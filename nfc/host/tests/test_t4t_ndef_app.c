@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* NDEF files served by nfc_t4t_ndef_app in PICC mode, next to another
+ * application, read and written by the virtual reader.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <misc/util.h>
+
+#include <nfc_t4t_lib.h>
+#include <nfc_t4t_apdu.h>
+#include <nfc_t4t_ndef_app.h>
+#include <nfc_vreader.h>
+
+#include "test_util.h"
+
+#define FILE_SIZE 1000
+#define MSG_SIZE  600
+
+static struct nfc_t4t_apdu_reasm reasm;
+static u8_t reasm_buf[300];
+static struct nfc_t4t_apdu_router router;
+static u8_t router_buf[300];
+
+static u32_t last_nlen;
+static u32_t updates;
+
+static u16_t other_handler(void *context, const struct nfc_t4t_apdu *apdu,
+			   struct nfc_t4t_apdu_rsp *rsp)
+{
+	rsp->data[0] = 0x42;
+	rsp->length = 1;
+
+	return NFC_T4T_APDU_SW_OK;
+}
+
+static const u8_t other_aid[] = {0xF0, 0x01, 0x02};
+
+static const struct nfc_t4t_apdu_route other_routes[] = {
+	NFC_T4T_APDU_ROUTE_INS(0x10, other_handler, NULL),
+};
+
+NFC_T4T_NDEF_APP_DEFINE(ndef_app);
+
+static const struct nfc_t4t_apdu_app apps[] = {
+	NFC_T4T_NDEF_APP(ndef_app, nfc_t4t_ndef_app_aid,
+			 sizeof(nfc_t4t_ndef_app_aid)),
+	{
+		.aid = other_aid,
+		.aid_length = sizeof(other_aid),
+		.routes = other_routes,
+		.route_count = ARRAY_SIZE(other_routes),
+	},
+};
+
+static void nlen_updated(void *context, u32_t nlen)
+{
+	last_nlen = nlen;
+	updates++;
+}
+
+static void picc_callback(void *context, enum nfc_t4t_event event,
+			  const u8_t *data, size_t data_length, u32_t flags)
+{
+	const u8_t *apdu;
+	size_t apdu_length;
+
+	switch (event) {
+	case NFC_T4T_EVENT_DATA_IND:
+		if (!nfc_t4t_apdu_reasm_put(&reasm, data, data_length, flags,
+					    &apdu, &apdu_length)) {
+			nfc_t4t_apdu_router_process(&router, apdu,
+						    apdu_length);
+		}
+		break;
+
+	case NFC_T4T_EVENT_FIELD_OFF:
+		nfc_t4t_apdu_router_reset(&router);
+		nfc_t4t_apdu_reasm_reset(&reasm);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void start(u8_t *file, bool writable)
+{
+	TEST_CHECK_EQ(nfc_t4t_ndef_app_init(&ndef_app, file, FILE_SIZE,
+					    writable, nlen_updated, NULL), 0);
+	TEST_CHECK_EQ(nfc_t4t_apdu_router_init(&router, apps, ARRAY_SIZE(apps),
+					       router_buf,
+					       sizeof(router_buf)), 0);
+	TEST_CHECK_EQ(nfc_t4t_apdu_reasm_init(&reasm, reasm_buf,
+					      sizeof(reasm_buf)), 0);
+	TEST_CHECK_EQ(nfc_t4t_setup(picc_callback, NULL), 0);
+	TEST_CHECK_EQ(nfc_t4t_emulation_start(), 0);
+	nfc_vreader_field_on();
+}
+
+static void stop(void)
+{
+	nfc_vreader_field_off();
+	TEST_CHECK_EQ(nfc_t4t_done(), 0);
+}
+
+static size_t transceive(const u8_t *cmd, size_t cmd_length, u8_t *rsp,
+			 size_t rsp_size)
+{
+	size_t rsp_length = rsp_size;
+
+	TEST_CHECK_EQ(nfc_vreader_t4t_transceive(cmd, cmd_length, rsp,
+						 &rsp_length), 0);
+
+	return rsp_length;
+}
+
+static void test_cc(void)
+{
+	static u8_t file[FILE_SIZE];
+	static const u8_t select_app[] = {
+		0x00, 0xA4, 0x04, 0x00, 0x07,
+		0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01, 0x00,
+	};
+	static const u8_t select_cc[] = {
+		0x00, 0xA4, 0x00, 0x0C, 0x02, 0xE1, 0x03,
+	};
+	static const u8_t read_cc[] = {0x00, 0xB0, 0x00, 0x00, 0x0F};
+	static const u8_t expected[] = {
+		0x00, 0x0F, 0x20, 0x00, 0xFF, 0x00, 0xFF,
+		0x04, 0x06, 0xE1, 0x04, 0x03, 0xE8, 0x00, 0xFF,
+		0x90, 0x00,
+	};
+	u8_t rsp[32];
+	size_t length;
+
+	/* Read-only, so the write access byte is 0xFF. */
+	start(file, false);
+
+	transceive(select_app, sizeof(select_app), rsp, sizeof(rsp));
+	transceive(select_cc, sizeof(select_cc), rsp, sizeof(rsp));
+	length = transceive(read_cc, sizeof(read_cc), rsp, sizeof(rsp));
+
+	TEST_CHECK_EQ(length, sizeof(expected));
+	TEST_CHECK(!memcmp(rsp, expected, sizeof(expected)));
+
+	stop();
+}
+
+static void test_write_read(void)
+{
+	static u8_t file[FILE_SIZE];
+	static u8_t msg[MSG_SIZE];
+	static u8_t out[FILE_SIZE];
+	size_t length;
+
+	for (size_t i = 0; i < sizeof(msg); i++) {
+		msg[i] = (u8_t)(i * 7);
+	}
+
+	updates = 0;
+	start(file, true);
+
+	TEST_CHECK_EQ(nfc_vreader_t4t_ndef_write(msg, sizeof(msg)), 0);
+	TEST_CHECK_EQ(last_nlen, sizeof(msg));
+	TEST_CHECK(updates >= 1);
+
+	length = sizeof(out);
+	TEST_CHECK_EQ(nfc_vreader_t4t_ndef_read(out, &length), 0);
+	TEST_CHECK_EQ(length, sizeof(msg));
+	TEST_CHECK(!memcmp(out, msg, sizeof(msg)));
+
+	stop();
+
+	/* A read-only file rejects the write and keeps its content. */
+	start(file, false);
+
+	TEST_CHECK_EQ(nfc_vreader_t4t_ndef_write(msg, 10), -EIO);
+
+	length = sizeof(out);
+	TEST_CHECK_EQ(nfc_vreader_t4t_ndef_read(out, &length), 0);
+	TEST_CHECK_EQ(length, sizeof(msg));
+	TEST_CHECK(!memcmp(out, msg, sizeof(msg)));
+
+	stop();
+}
+
+static void test_other_app(void)
+{
+	static u8_t file[FILE_SIZE];
+	static const u8_t select_other[] = {
+		0x00, 0xA4, 0x04, 0x00, 0x03, 0xF0, 0x01, 0x02, 0x00,
+	};
+	static const u8_t other_cmd[] = {0x00, 0x10, 0x00, 0x00};
+	static const u8_t read_binary[] = {0x00, 0xB0, 0x00, 0x00, 0x02};
+	u8_t rsp[32];
+	size_t length;
+
+	start(file, true);
+
+	length = transceive(select_other, sizeof(select_other), rsp,
+			    sizeof(rsp));
+	TEST_CHECK_EQ(length, 2);
+	TEST_CHECK_EQ(rsp[0], 0x90);
+
+	length = transceive(other_cmd, sizeof(other_cmd), rsp, sizeof(rsp));
+	TEST_CHECK_EQ(length, 3);
+	TEST_CHECK_EQ(rsp[0], 0x42);
+	TEST_CHECK_EQ(rsp[1], 0x90);
+
+	/* READ BINARY belongs to the NDEF application only. */
+	length = transceive(read_binary, sizeof(read_binary), rsp,
+			    sizeof(rsp));
+	TEST_CHECK_EQ(length, 2);
+	TEST_CHECK_EQ((rsp[0] << 8) | rsp[1],
+		      NFC_T4T_APDU_SW_INS_NOT_SUPPORTED);
+
+	stop();
+}
+
+int main(void)
+{
+	test_cc();
+	test_write_read();
+	test_other_app();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Minimal checks for the host test programs. A failed check is reported
+ * and counted, and the program exits with a non-zero status.
+ */
+
+#ifndef TEST_UTIL_H__
+#define TEST_UTIL_H__
+
+#include <stdio.h>
+
+static int test_failures;
+
+#define TEST_CHECK(cond)                                                  \
+	do {                                                              \
+		if (!(cond)) {                                            \
+			fprintf(stderr, "%s:%d: check failed: %s\n",      \
+				__FILE__, __LINE__, #cond);               \
+			test_failures++;                                  \
+		}                                                         \
+	} while (0)
+
+#define TEST_CHECK_EQ(a, b)                                               \
+	do {                                                              \
+		long long test_a_ = (long long)(a);                       \
+		long long test_b_ = (long long)(b);                       \
+		if (test_a_ != test_b_) {                                 \
+			fprintf(stderr, "%s:%d: %s == %s: %lld != %lld\n", \
+				__FILE__, __LINE__, #a, #b, test_a_,      \
+				test_b_);                                 \
+			test_failures++;                                  \
+		}                                                         \
+	} while (0)
+
+#define TEST_RESULT()                                                     \
+	(test_failures ? (fprintf(stderr, "%d check(s) failed\n",          \
+				  test_failures), 1) : 0)
+
+#endif /* TEST_UTIL_H__ */
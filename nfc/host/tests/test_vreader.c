@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Tap sequences against the host T2T and T4T libraries through the
+ * virtual reader.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <misc/util.h>
+
+#include <nfc_t2t_lib.h>
+#include <nfc_t4t_lib.h>
+#include <nfc_t4t_apdu.h>
+#include <nfc_vreader.h>
+
+#include "test_util.h"
+
+#define TAPS 2000
+
+static u32_t t2t_events[NFC_T2T_EVENT_STOPPED + 1];
+static u32_t t4t_events[NFC_T4T_EVENT_DATA_IND + 1];
+
+static void t2t_callback(void *context, enum nfc_t2t_event event,
+			 const u8_t *data, size_t data_length)
+{
+	t2t_events[event]++;
+}
+
+static void t4t_callback(void *context, enum nfc_t4t_event event,
+			 const u8_t *data, size_t data_length, u32_t flags)
+{
+	t4t_events[event]++;
+}
+
+static void msg_fill(u8_t *msg, size_t length, u32_t seed)
+{
+	for (size_t i = 0; i < length; i++) {
+		msg[i] = (u8_t)(seed * 31 + i * 7);
+	}
+}
+
+static double elapsed_s(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) +
+	       (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void test_t2t_taps(void)
+{
+	static u8_t msg[300];
+	static u8_t out[NFC_T2T_MAX_PAYLOAD_SIZE];
+	struct timespec start;
+	size_t length;
+
+	memset(t2t_events, 0, sizeof(t2t_events));
+	msg_fill(msg, sizeof(msg), 1);
+
+	TEST_CHECK_EQ(nfc_t2t_setup(t2t_callback, NULL), 0);
+	TEST_CHECK_EQ(nfc_t2t_payload_set(msg, sizeof(msg)), 0);
+
+	length = sizeof(out);
+	TEST_CHECK_EQ(nfc_vreader_t2t_ndef_read(out, &length), -ENOTCONN);
+
+	TEST_CHECK_EQ(nfc_t2t_emulation_start(), 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (u32_t tap = 0; tap < TAPS; tap++) {
+		nfc_vreader_field_on();
+
+		length = sizeof(out);
+		TEST_CHECK_EQ(nfc_vreader_t2t_ndef_read(out, &length), 0);
+		TEST_CHECK_EQ(length, sizeof(msg));
+		TEST_CHECK(!memcmp(out, msg, sizeof(msg)));
+
+		/* A second read in the same tap raises no new event. */
+		length = sizeof(out);
+		TEST_CHECK_EQ(nfc_vreader_t2t_ndef_read(out, &length), 0);
+
+		nfc_vreader_field_off();
+	}
+	printf("t2t: %u taps, %.0f taps/s\n", TAPS, TAPS / elapsed_s(&start));
+
+	TEST_CHECK_EQ(t2t_events[NFC_T2T_EVENT_FIELD_ON], TAPS);
+	TEST_CHECK_EQ(t2t_events[NFC_T2T_EVENT_FIELD_OFF], TAPS);
+	TEST_CHECK_EQ(t2t_events[NFC_T2T_EVENT_DATA_READ], TAPS);
+
+	TEST_CHECK_EQ(nfc_t2t_emulation_stop(), 0);
+	TEST_CHECK_EQ(nfc_t2t_done(), 0);
+}
+
+static void test_t4t_ndef_taps(void)
+{
+	static u8_t file[1024];
+	static u8_t msg[600];
+	static u8_t out[sizeof(file)];
+	struct timespec start;
+	size_t length;
+
+	memset(t4t_events, 0, sizeof(t4t_events));
+
+	TEST_CHECK_EQ(nfc_t4t_setup(t4t_callback, NULL), 0);
+	TEST_CHECK_EQ(nfc_t4t_ndef_rwpayload_set(file, sizeof(file)), 0);
+	TEST_CHECK_EQ(nfc_t4t_emulation_start(), 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (u32_t tap = 0; tap < TAPS; tap++) {
+		size_t msg_length = 1 + tap % sizeof(msg);
+
+		msg_fill(msg, msg_length, tap);
+
+		nfc_vreader_field_on();
+
+		TEST_CHECK_EQ(nfc_vreader_t4t_ndef_write(msg, msg_length), 0);
+		TEST_CHECK_EQ((file[0] << 8) | file[1], msg_length);
+
+		length = sizeof(out);
+		TEST_CHECK_EQ(nfc_vreader_t4t_ndef_read(out, &length), 0);
+		TEST_CHECK_EQ(length, msg_length);
+		TEST_CHECK(!memcmp(out, msg, msg_length));
+
+		nfc_vreader_field_off();
+	}
+	printf("t4t ndef: %u taps, %.0f taps/s\n", TAPS,
+	       TAPS / elapsed_s(&start));
+
+	TEST_CHECK_EQ(t4t_events[NFC_T4T_EVENT_FIELD_ON], TAPS);
+	TEST_CHECK_EQ(t4t_events[NFC_T4T_EVENT_FIELD_OFF], TAPS);
+	TEST_CHECK(t4t_events[NFC_T4T_EVENT_NDEF_UPDATED] >= TAPS);
+	TEST_CHECK_EQ(t4t_events[NFC_T4T_EVENT_NDEF_READ], TAPS);
+
+	/* A message larger than the file is refused. */
+	nfc_vreader_field_on();
+	TEST_CHECK_EQ(nfc_vreader_t4t_ndef_write(file, sizeof(file)), -ENOMEM);
+	nfc_vreader_field_off();
+
+	TEST_CHECK_EQ(nfc_t4t_emulation_stop(), 0);
+	TEST_CHECK_EQ(nfc_t4t_done(), 0);
+}
+
+/* PICC mode: the application echoes the sum of the command data. */
+static const u8_t picc_aid[] = {0xF0, 0x01, 0x02, 0x03};
+static struct nfc_t4t_apdu_router router;
+static u8_t router_buf[64];
+static struct nfc_t4t_apdu_reasm reasm;
+static u8_t reasm_buf[300];
+
+static u16_t sum_handler(void *context, const struct nfc_t4t_apdu *apdu,
+			 struct nfc_t4t_apdu_rsp *rsp)
+{
+	u32_t sum = 0;
+
+	for (u32_t i = 0; i < apdu->lc; i++) {
+		sum += apdu->data[i];
+	}
+
+	rsp->data[0] = (u8_t)(sum >> 8);
+	rsp->data[1] = (u8_t)sum;
+	rsp->length = 2;
+
+	return NFC_T4T_APDU_SW_OK;
+}
+
+static const struct nfc_t4t_apdu_route picc_routes[] = {
+	NFC_T4T_APDU_ROUTE_INS(0x10, sum_handler, NULL),
+};
+
+static const struct nfc_t4t_apdu_app picc_app = {
+	.aid = picc_aid,
+	.aid_length = sizeof(picc_aid),
+	.routes = picc_routes,
+	.route_count = ARRAY_SIZE(picc_routes),
+};
+
+static void picc_callback(void *context, enum nfc_t4t_event event,
+			  const u8_t *data, size_t data_length, u32_t flags)
+{
+	const u8_t *apdu;
+	size_t apdu_length;
+
+	t4t_events[event]++;
+
+	switch (event) {
+	case NFC_T4T_EVENT_DATA_IND:
+		if (!nfc_t4t_apdu_reasm_put(&reasm, data, data_length, flags,
+					    &apdu, &apdu_length)) {
+			nfc_t4t_apdu_router_process(&router, apdu,
+						    apdu_length);
+		}
+		break;
+
+	case NFC_T4T_EVENT_FIELD_OFF:
+		nfc_t4t_apdu_router_reset(&router);
+		nfc_t4t_apdu_reasm_reset(&reasm);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void test_t4t_picc(void)
+{
+	static const u8_t select[] = {
+		0x00, 0xA4, 0x04, 0x00, sizeof(picc_aid),
+		0xF0, 0x01, 0x02, 0x03, 0x00
+	};
+	u8_t cmd[5 + 200] = {0x00, 0x10, 0x00, 0x00, 200};
+	u8_t rsp[64];
+	size_t length;
+	u32_t sum = 0;
+
+	memset(t4t_events, 0, sizeof(t4t_events));
+
+	for (u32_t i = 0; i < 200; i++) {
+		cmd[5 + i] = (u8_t)i;
+		sum += (u8_t)i;
+	}
+
+	/* No room for streamed data. */
+	TEST_CHECK_EQ(nfc_t4t_apdu_router_init(&router, &picc_app, 1,
+					       router_buf,
+					       NFC_T4T_APDU_SW_SIZE),
+		      -EINVAL);
+	TEST_CHECK_EQ(nfc_t4t_apdu_router_init(&router, &picc_app, 1,
+					       router_buf, sizeof(router_buf)),
+		      0);
+	TEST_CHECK_EQ(nfc_t4t_apdu_reasm_init(&reasm, reasm_buf,
+					      sizeof(reasm_buf)), 0);
+	TEST_CHECK_EQ(nfc_t4t_setup(picc_callback, NULL), 0);
+	TEST_CHECK_EQ(nfc_t4t_emulation_start(), 0);
+
+	/* Chain the command over several frames. */
+	TEST_CHECK_EQ(nfc_vreader_frame_size_set(60), 0);
+
+	for (u32_t tap = 0; tap < TAPS; tap++) {
+		nfc_vreader_field_on();
+
+		/* Not selected yet. */
+		length = sizeof(rsp);
+		TEST_CHECK_EQ(nfc_vreader_t4t_transceive(cmd, sizeof(cmd), rsp,
+							 &length), 0);
+		TEST_CHECK_EQ(length, 2);
+		TEST_CHECK(rsp[0] != 0x90);
+
+		length = sizeof(rsp);
+		TEST_CHECK_EQ(nfc_vreader_t4t_transceive(select,
+							 sizeof(select), rsp,
+							 &length), 0);
+		TEST_CHECK_EQ(length, 2);
+		TEST_CHECK_EQ((rsp[0] << 8) | rsp[1], NFC_T4T_APDU_SW_OK);
+
+		length = sizeof(rsp);
+		TEST_CHECK_EQ(nfc_vreader_t4t_transceive(cmd, sizeof(cmd), rsp,
+							 &length), 0);
+		TEST_CHECK_EQ(length, 4);
+		TEST_CHECK_EQ((rsp[0] << 8) | rsp[1], sum);
+		TEST_CHECK_EQ((rsp[2] << 8) | rsp[3], NFC_T4T_APDU_SW_OK);
+
+		nfc_vreader_field_off();
+	}
+
+	TEST_CHECK_EQ(t4t_events[NFC_T4T_EVENT_FIELD_ON], TAPS);
+	TEST_CHECK_EQ(t4t_events[NFC_T4T_EVENT_DATA_TRANSMITTED], 3 * TAPS);
+
+	TEST_CHECK_EQ(nfc_vreader_frame_size_set(NFC_VREADER_FRAME_SIZE_DEFAULT),
+		      0);
+	TEST_CHECK_EQ(nfc_t4t_emulation_stop(), 0);
+	TEST_CHECK_EQ(nfc_t4t_done(), 0);
+}
+
+int main(void)
+{
+	test_t2t_taps();
+	test_t4t_ndef_taps();
+	test_t4t_picc();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_BLE_OOB_H__
+#define NFC_BLE_OOB_H__
+
+/** @file
+ *
+ * @defgroup nfc_ble_oob BLE pairing handover message
+ * @{
+ * @ingroup nfc_ndef
+ * @brief Handover Select message with LE Secure Connections OOB data.
+ *
+ * The message holds a Handover Select record, with one active alternative
+ * carrier, and an LE OOB record (application/vnd.bluetooth.le.oob) with
+ * the LE device address, the LE role, and the LE Secure Connections
+ * confirmation and random values.
+ *
+ * The confirmation value is f4(PKx, PKx, r, 0) from the Bluetooth Core
+ * Specification, an AES-CMAC keyed with the random value. Computing the
+ * public key takes tens of milliseconds, so the values and the encoded
+ * message are cached: a tap only copies the message with
+ * @ref nfc_ble_oob_msg_get, which can be called from the tag library
+ * callback or from an @ref nfc_ndef_dyn generator.
+ *
+ * The values stay the same until @ref nfc_ble_oob_refresh is called,
+ * typically after a pairing used them. The new values are computed in
+ * the system work queue and replace the previous ones when ready, so the
+ * tag never serves an incomplete message.
+ *
+ * The BLE stack must pair with the key pair and random value returned by
+ * @ref nfc_ble_oob_sc_get for the values the peer read from the tag.
+ */
+
+#include <zephyr/types.h>
+
+#include "nfc_ndef_msg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Largest encoded message, NLEN field included. */
+#define NFC_BLE_OOB_MSG_MAX_SIZE 128
+
+/** @brief LE Role AD values. */
+enum nfc_ble_oob_role {
+	NFC_BLE_OOB_ROLE_PERIPH,       /**< Peripheral only. */
+	NFC_BLE_OOB_ROLE_CENTRAL,      /**< Central only. */
+	NFC_BLE_OOB_ROLE_PERIPH_PREF,  /**< Both, peripheral preferred. */
+	NFC_BLE_OOB_ROLE_CENTRAL_PREF, /**< Both, central preferred. */
+};
+
+/** @brief Random number source.
+ *
+ * @param buf Buffer to fill with random bytes.
+ * @param length Number of bytes.
+ *
+ * @retval 0 Success.
+ * @return Negative error code on failure.
+ */
+typedef int (*nfc_ble_oob_rand_t)(u8_t *buf, size_t length);
+
+/** @brief Handover parameters. */
+struct nfc_ble_oob_config {
+	/** LE device address, little-endian as in bt_addr_t. */
+	u8_t addr[6];
+	/** Address type, 0 for public and 1 for random. */
+	u8_t addr_type;
+	/** LE role. */
+	enum nfc_ble_oob_role role;
+	/** Random source for the private key and the random value. */
+	nfc_ble_oob_rand_t rand;
+};
+
+/** @brief LE Secure Connections OOB values. */
+struct nfc_ble_oob_sc {
+	/** P-256 private key, big-endian. */
+	u8_t sk[32];
+	/** P-256 public key, X and Y big-endian. */
+	u8_t pk[64];
+	/** Random value, little-endian as in the LE OOB record. */
+	u8_t r[16];
+	/** Confirmation value, little-endian as in the LE OOB record. */
+	u8_t c[16];
+};
+
+/** @brief Compute the first OOB values and encode the message.
+ *
+ * Must be called from thread context. Blocks while the values are
+ * computed.
+ *
+ * @param config Handover parameters. Copied.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer).
+ * @retval -EIO Key generation failed.
+ * @return Error code returned by the random source or by
+ *	   @ref nfc_ndef_msg_encode.
+ */
+int nfc_ble_oob_init(const struct nfc_ble_oob_config *config);
+
+/** @brief Compute new OOB values in the background.
+ *
+ * The current message is served until the new one is encoded. Can be
+ * called from any context.
+ */
+void nfc_ble_oob_refresh(void);
+
+/** @brief Copy the current message.
+ *
+ * Can be called from any context.
+ *
+ * @param format Layout of the message.
+ * @param buff Output buffer.
+ * @param len Size of @p buff on input. Receives the message size.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument, or not initialized.
+ * @retval -ENOMEM @p buff is too small.
+ */
+int nfc_ble_oob_msg_get(enum nfc_ndef_msg_format format, u8_t *buff,
+			u32_t *len);
+
+/** @brief Get the OOB values of the current message.
+ *
+ * Can be called from any context.
+ *
+ * @param sc OOB values output.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Not initialized.
+ */
+int nfc_ble_oob_sc_get(struct nfc_ble_oob_sc *sc);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_BLE_OOB_H__ */
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_EVQ_H__
+#define NFC_EVQ_H__
+
+/** @file
+ *
+ * @defgroup nfc_evq NFC library event queue
+ * @{
+ * @ingroup nfc_api
+ * @brief Delivery of T2T and T4T library events from a worker thread.
+ *
+ * The T2T and T4T libraries call the application callback from the NFCT
+ * interrupt, so a slow callback delays the handling of the next frame.
+ * When the callback is registered with @ref nfc_evq_t2t_setup or
+ * @ref nfc_evq_t4t_setup instead, the interrupt only appends the event to
+ * a single-producer, single-consumer ring, and a dedicated thread calls
+ * the application callback with the same arguments.
+ *
+ * Event data is passed by reference where the library keeps it valid:
+ * the last @ref NFC_T4T_EVENT_DATA_IND fragment of a command stays in the
+ * library buffer until the response is sent. Chained fragments, flagged
+ * with @ref NFC_T4T_DI_FLAG_MORE, are acknowledged by the library and
+ * overwritten by the next fragment, so they are copied into a byte pool.
+ * In both cases, the data is only valid during the callback.
+ *
+ * @ref nfc_t4t_response_pdu_send is called from the worker callback as
+ * usual. The time from the interrupt to the callback adds to the response
+ * time seen by the reader. It is bounded by the thread priority,
+ * CONFIG_NFC_EVQ_THREAD_PRIO, and by the events queued before the command.
+ * Cooperative threads, such as the system work queue, delay the worker
+ * until they yield. The largest delay is reported in @ref nfc_evq_stats.
+ *
+ * Other events are never dropped. Command fragments leave two slots of the
+ * ring free for them, and when the ring is full they are coalesced until
+ * the thread has caught up: each event is then delivered once with its
+ * latest data, e.g. the last NLEN of @ref NFC_T4T_EVENT_NDEF_UPDATED, and
+ * taps in between are reduced to the first and the last field event, so
+ * that FIELD_ON and FIELD_OFF still alternate. Coalesced events are
+ * delivered within the tap in which they last came. Those of reduced taps
+ * are delivered within the last tap if the field is still on.
+ *
+ * A fragment that does not fit in the ring or in the pool is dropped and
+ * counted. After a dropped fragment, the rest of its command is dropped
+ * too, so the reader gets no response for it, and the next fragment
+ * delivered carries @ref NFC_EVQ_DI_FLAG_DROPPED.
+ */
+
+#include <zephyr/types.h>
+
+#include "nfc_t2t_lib.h"
+#include "nfc_t4t_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Flag added to the first @ref NFC_T4T_EVENT_DATA_IND fragment
+ *  delivered after a dropped one. Fragments already delivered for the
+ *  dropped command must be discarded, e.g. with
+ *  @ref nfc_t4t_apdu_reasm_reset.
+ */
+#define NFC_EVQ_DI_FLAG_DROPPED 0x80
+
+/** @brief Queue statistics. */
+struct nfc_evq_stats {
+	u32_t events;       /**< Events queued. */
+	u32_t dropped;      /**< Command fragments dropped. */
+	u32_t coalesced;    /**< Events merged into another one. */
+	u32_t copied;       /**< Chained fragments copied into the pool. */
+	u32_t max_depth;    /**< Most events waiting at once. */
+	u32_t max_delay_us; /**< Longest time from interrupt to callback. */
+};
+
+/** @brief Register a T2T callback that runs in the worker thread.
+ *
+ * Replaces the call to @ref nfc_t2t_setup.
+ *
+ * @param callback Application callback.
+ * @param context Context passed to @p callback.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer).
+ * @retval -ENOTSUP The T2T library is not enabled.
+ * @return Error code returned by @ref nfc_t2t_setup.
+ */
+int nfc_evq_t2t_setup(nfc_t2t_callback_t callback, void *context);
+
+/** @brief Register a T4T callback that runs in the worker thread.
+ *
+ * Replaces the call to @ref nfc_t4t_setup.
+ *
+ * @param callback Application callback.
+ * @param context Context passed to @p callback.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer).
+ * @retval -ENOTSUP The T4T library is not enabled.
+ * @return Error code returned by @ref nfc_t4t_setup.
+ */
+int nfc_evq_t4t_setup(nfc_t4t_callback_t callback, void *context);
+
+/** @brief Get the queue statistics.
+ *
+ * @param stats Statistics output.
+ */
+void nfc_evq_stats_get(struct nfc_evq_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_EVQ_H__ */
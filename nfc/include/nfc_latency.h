@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_LATENCY_H__
+#define NFC_LATENCY_H__
+
+/** @file
+ *
+ * @defgroup nfc_latency NFC latency instrumentation
+ * @{
+ * @ingroup nfc_api
+ * @brief Timestamps of the tag lifecycle, collected into histograms.
+ *
+ * A tap is split into segments, each collected into its own histogram:
+ *
+ *   - @ref NFC_LATENCY_CLOCK_START: from field detection to activation of
+ *     NFCT, which waits for the high-frequency clock.
+ *   - @ref NFC_LATENCY_ACTIVATION: from activation to the first command
+ *     or response, which covers anticollision and protocol setup.
+ *   - @ref NFC_LATENCY_RESPONSE: from a command, or from the previous
+ *     mark, to the response. This is the time spent by the library and
+ *     the application.
+ *   - @ref NFC_LATENCY_TAP: from field detection to the last response of
+ *     the tap.
+ *
+ * The platform marks field detection, activation and field loss. The
+ * application marks commands and responses from the library callback, for
+ * example on @ref NFC_T4T_EVENT_DATA_IND and
+ * @ref NFC_T4T_EVENT_DATA_TRANSMITTED, or on @ref NFC_T2T_EVENT_DATA_READ.
+ *
+ * Besides the histograms over all taps, each tap has its own set of
+ * histograms, so that the responses of one slow tap can be told apart. The
+ * set of the last complete tap is returned by @ref nfc_latency_tap_get.
+ * The set of the next tap is cleared from the system work queue. A tap that
+ * starts while it is being cleared only counts in the histograms over all
+ * taps.
+ *
+ * Timestamps are taken with k_cycle_get_32(), which counts the 32768 Hz RTC
+ * on nRF52. Every duration is therefore rounded to a multiple of about
+ * 30.5 us, and the lowest buckets stay empty.
+ *
+ * When CONFIG_NFC_LATENCY is disabled, marks compile to nothing.
+ */
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Number of histogram buckets. Bucket n counts durations of
+ *  2^n to 2^(n+1) - 1 microseconds; bucket 0 also counts 0.
+ */
+#define NFC_LATENCY_HIST_BUCKETS 24
+
+/** @brief Lifecycle events. */
+enum nfc_latency_mark {
+	NFC_LATENCY_MARK_FIELD_DETECTED, /**< Field detected. */
+	NFC_LATENCY_MARK_ACTIVATED,      /**< NFCT forced to activated. */
+	NFC_LATENCY_MARK_COMMAND,        /**< Command received. */
+	NFC_LATENCY_MARK_RESPONSE,       /**< Response sent or data read. */
+	NFC_LATENCY_MARK_FIELD_LOST,     /**< Field lost. */
+};
+
+/** @brief Measured segments. */
+enum nfc_latency_segment {
+	NFC_LATENCY_CLOCK_START, /**< Field detected to activated. */
+	NFC_LATENCY_ACTIVATION,  /**< Activated to first command. */
+	NFC_LATENCY_RESPONSE,    /**< Command to response. */
+	NFC_LATENCY_TAP,         /**< Field detected to last response. */
+	NFC_LATENCY_SEGMENT_COUNT,
+};
+
+/** @brief Histogram of a segment. */
+struct nfc_latency_hist {
+	u32_t count;  /**< Number of samples. */
+	u32_t min_us; /**< Shortest sample, in microseconds. */
+	u32_t max_us; /**< Longest sample, in microseconds. */
+	u64_t sum_us; /**< Sum of the samples, in microseconds. */
+	/** Sample counts per power-of-two bucket. */
+	u32_t buckets[NFC_LATENCY_HIST_BUCKETS];
+};
+
+/** @brief Segments of the last complete tap, in microseconds. A segment
+ *  that was not reached during the tap is 0.
+ */
+struct nfc_latency_tap {
+	u32_t us[NFC_LATENCY_SEGMENT_COUNT]; /**< Last sample per segment. */
+	u32_t responses;                     /**< Responses in the tap. */
+	/** Histograms of the samples taken during the tap. */
+	struct nfc_latency_hist hists[NFC_LATENCY_SEGMENT_COUNT];
+};
+
+#if defined(CONFIG_NFC_LATENCY)
+
+/** @brief Record a lifecycle event.
+ *
+ * Can be called from interrupt context.
+ *
+ * @param mark Event.
+ */
+void nfc_latency_mark(enum nfc_latency_mark mark);
+
+#else
+
+static inline void nfc_latency_mark(enum nfc_latency_mark mark)
+{
+	(void)mark;
+}
+
+#endif
+
+/** @brief Get the histogram of a segment.
+ *
+ * @param segment Segment.
+ * @param hist Receives the histogram.
+ */
+void nfc_latency_hist_get(enum nfc_latency_segment segment,
+			  struct nfc_latency_hist *hist);
+
+/** @brief Get the segments and histograms of the last complete tap.
+ *
+ * @param tap Receives the segments.
+ */
+void nfc_latency_tap_get(struct nfc_latency_tap *tap);
+
+/** @brief Clear all histograms. */
+void nfc_latency_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_LATENCY_H__ */
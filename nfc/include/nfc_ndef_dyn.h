@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_NDEF_DYN_H__
+#define NFC_NDEF_DYN_H__
+
+/** @file
+ *
+ * @defgroup nfc_ndef_dyn Per-tap dynamic NDEF content
+ * @{
+ * @ingroup nfc_ndef
+ * @brief Tag content regenerated for every tap.
+ *
+ * The application registers a generator that writes the tag content, for
+ * example a message with a tap counter or a one-time token built with
+ * @ref nfc_ndef_msg_encode. The module calls it so that every tap is
+ * served freshly generated content without the application stopping and
+ * restarting the emulation.
+ *
+ * Two modes are available:
+ *
+ *   - @ref NFC_NDEF_DYN_ON_FIELD_ON: the content is generated into the T4T
+ *     NDEF file from the @ref NFC_T4T_EVENT_FIELD_ON callback, before the
+ *     reader can select the file. The generator runs in the library
+ *     callback context and must be fast.
+ *   - @ref NFC_NDEF_DYN_PRECOMPUTE: the content for the next tap is
+ *     generated from the system work queue after the field is lost, so no
+ *     generation happens while a reader waits. For T4T, the result is
+ *     generated into a shadow buffer and copied into the NDEF file from
+ *     the work queue, with interrupts locked and only while no field is
+ *     present. @ref NFC_T4T_EVENT_FIELD_ON then only marks it as served.
+ *     For T2T, it is committed through @ref nfc_t2t_dbuf and swapped in
+ *     before the next tap.
+ *
+ * If the next tap starts before the precomputed content is ready, T4T
+ * falls back to generating it on field on, while T2T serves the previous
+ * content. Both cases are counted in the statistics.
+ */
+
+#include <zephyr/types.h>
+
+#include "nfc_t2t_lib.h"
+#include "nfc_t4t_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Generation modes. */
+enum nfc_ndef_dyn_mode {
+	/** Generate the content when the field is detected. T4T only. */
+	NFC_NDEF_DYN_ON_FIELD_ON,
+	/** Generate the content for the next tap after the field is lost. */
+	NFC_NDEF_DYN_PRECOMPUTE,
+};
+
+/** @brief Content generator.
+ *
+ * @param context Generator context.
+ * @param buf Buffer receiving the content: the T4T NDEF file, NLEN field
+ *	      included, or the T2T payload.
+ * @param size Size of @p buf.
+ * @param length Receives the length of the content.
+ *
+ * @retval 0 Success.
+ * @return Negative error code to keep the previous content.
+ */
+typedef int (*nfc_ndef_dyn_generator_t)(void *context, u8_t *buf,
+					size_t size, size_t *length);
+
+/** @brief Statistics. */
+struct nfc_ndef_dyn_stats {
+	u32_t taps;        /**< Taps seen. */
+	u32_t precomputed; /**< Taps served precomputed content. */
+	u32_t inline_gen;  /**< Taps served content generated on field on. */
+	u32_t stale;       /**< Taps served the previous content. */
+	u32_t errors;      /**< Generator errors. */
+};
+
+/** @brief Initialize dynamic content for the T4T NDEF emulation.
+ *
+ * Generates the initial content and registers @p file with
+ * @ref nfc_t4t_ndef_rwpayload_set. Call after @ref nfc_t4t_setup and
+ * before @ref nfc_t4t_emulation_start.
+ *
+ * @param mode Generation mode.
+ * @param file NDEF file buffer.
+ * @param shadow Buffer for precomputed content, of the same size as
+ *		 @p file. Only used with @ref NFC_NDEF_DYN_PRECOMPUTE.
+ * @param size Size of @p file.
+ * @param generator Content generator.
+ * @param context Generator context.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer).
+ * @return Error code returned by the generator or by
+ *	   @ref nfc_t4t_ndef_rwpayload_set.
+ */
+int nfc_ndef_dyn_t4t_init(enum nfc_ndef_dyn_mode mode, u8_t *file,
+			  u8_t *shadow, size_t size,
+			  nfc_ndef_dyn_generator_t generator, void *context);
+
+/** @brief Process a T4T library event.
+ *
+ * Must be called from the application @ref nfc_t4t_callback_t for every
+ * event.
+ *
+ * @param event The event.
+ */
+void nfc_ndef_dyn_t4t_event_process(enum nfc_t4t_event event);
+
+/** @brief Initialize dynamic content for the T2T emulation.
+ *
+ * Only @ref NFC_NDEF_DYN_PRECOMPUTE is supported, because the T2T payload
+ * can only be replaced when no reader is present. Generates and commits
+ * the initial content. Call after @ref nfc_t2t_dbuf_init and before
+ * @ref nfc_t2t_dbuf_emulation_start.
+ *
+ * @param generator Content generator.
+ * @param context Generator context.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer).
+ * @return Error code returned by the generator or by
+ *	   @ref nfc_t2t_dbuf_commit.
+ */
+int nfc_ndef_dyn_t2t_init(nfc_ndef_dyn_generator_t generator, void *context);
+
+/** @brief Process a T2T library event.
+ *
+ * Must be called from the application @ref nfc_t2t_callback_t for every
+ * event, instead of @ref nfc_t2t_dbuf_event_process.
+ *
+ * @param event The event.
+ */
+void nfc_ndef_dyn_t2t_event_process(enum nfc_t2t_event event);
+
+/** @brief Get the statistics.
+ *
+ * @param stats Receives the statistics.
+ */
+void nfc_ndef_dyn_stats_get(struct nfc_ndef_dyn_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_NDEF_DYN_H__ */
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_NDEF_JOURNAL_H__
+#define NFC_NDEF_JOURNAL_H__
+
+/** @file
+ *
+ * @defgroup nfc_ndef_journal NFC NDEF file journal
+ * @{
+ * @ingroup nfc_t4t_lib
+ * @brief Tearing-safe flash persistence of a writable T4T NDEF file.
+ *
+ * The NDEF file registered with @ref nfc_t4t_ndef_rwpayload_set is
+ * persisted as an append-only log in a flash area of two or more pages.
+ * On every update, only the byte ranges that differ from the last
+ * persisted content are appended, each as a record protected by a CRC.
+ * The last record of an update carries a commit flag, and an update is
+ * applied on recovery only if its commit record is intact, so a power
+ * loss during a write leaves the previous content.
+ *
+ * When the active page is full, the current content is written to the
+ * next page, which is the only time a page is erased. Pages are used in
+ * turn, which spreads the erases over the area.
+ *
+ * Usage:
+ * @code
+ * err = nfc_ndef_journal_init(flash_dev, offset, 4096, 2, file, shadow,
+ *			       sizeof(file));
+ * if (err == -ENOENT) {
+ *	... encode the default message into file ...
+ * }
+ * nfc_t4t_ndef_rwpayload_set(file, sizeof(file));
+ *
+ * In the T4T callback:
+ * nfc_ndef_journal_t4t_event_process(event);
+ * @endcode
+ */
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <zephyr/types.h>
+#include <device.h>
+
+#include "nfc_t4t_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Journal statistics. */
+struct nfc_ndef_journal_stats {
+	/** Updates that changed the persisted content. */
+	u32_t syncs;
+	/** Records appended, snapshots included. */
+	u32_t records;
+	/** Bytes programmed, headers and padding included. */
+	u32_t bytes;
+	/** Snapshots written to a freshly erased page. */
+	u32_t compactions;
+	/** Failed flash operations. */
+	u32_t errors;
+};
+
+/** @brief Initialize the journal and recover the NDEF file.
+ *
+ * The newest committed content is read from flash into @p file and
+ * copied to @p shadow, which then holds the persisted content. Bytes past
+ * the message that were not persisted are set to zero.
+ *
+ * Must be called from thread context, before the emulation is started.
+ *
+ * @param dev Flash device.
+ * @param offset Offset of the journal area, aligned to a page.
+ * @param page_size Size of an erasable flash page.
+ * @param page_count Number of pages in the area, at least 2.
+ * @param file NDEF file registered with the T4T library.
+ * @param shadow Buffer of @p size bytes holding the persisted content.
+ * @param size Size of the NDEF file.
+ *
+ * @retval 0 Content recovered.
+ * @retval -ENOENT No committed content was found, @p file is left
+ *		   unchanged and is persisted on the first update.
+ * @retval -EINVAL Invalid argument.
+ * @retval -ENOMEM The file does not fit in a page.
+ * @retval -ENOTSUP The flash write block size is not supported.
+ * @return Other negative errno values from the flash driver.
+ */
+int nfc_ndef_journal_init(struct device *dev, off_t offset, size_t page_size,
+			  u32_t page_count, u8_t *file, u8_t *shadow,
+			  size_t size);
+
+/** @brief Persist the changes made to the NDEF file.
+ *
+ * Appends the changed ranges as one committed update, or writes a
+ * snapshot to the next page if the active page is full.
+ *
+ * Must be called from thread context.
+ *
+ * @retval 0 Success, also if nothing changed.
+ * @return Negative errno value from the flash driver. The next call
+ *	   writes a snapshot.
+ */
+int nfc_ndef_journal_sync(void);
+
+/** @brief Process a T4T library event.
+ *
+ * Schedules @ref nfc_ndef_journal_sync in the system work queue on
+ * @ref NFC_T4T_EVENT_NDEF_UPDATED. Can be called from the T4T callback.
+ *
+ * @param event T4T library event.
+ */
+void nfc_ndef_journal_t4t_event_process(enum nfc_t4t_event event);
+
+/** @brief Get the journal statistics.
+ *
+ * @param stats Statistics output.
+ */
+void nfc_ndef_journal_stats_get(struct nfc_ndef_journal_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_NDEF_JOURNAL_H__ */
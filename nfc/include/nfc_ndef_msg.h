@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_NDEF_MSG_H__
+#define NFC_NDEF_MSG_H__
+
+/** @file
+ *
+ * @defgroup nfc_ndef NFC Data Exchange Format
+ * @ingroup nfc_api
+ * @brief NDEF message encoding and parsing.
+ *
+ * @defgroup nfc_ndef_msg NDEF message encoder
+ * @{
+ * @ingroup nfc_ndef
+ * @brief Zero-copy NDEF message encoder.
+ *
+ * A message is described by an array of record descriptors. The encoder
+ * first computes the exact encoded size in a dry run, then serializes the
+ * message in place into the buffer that is later registered with the tag
+ * library. No intermediate copy of the message is made, which matters for
+ * T4T payloads of up to @ref NFC_T4T_MAX_PAYLOAD_SIZE bytes.
+ *
+ * The encoder selects short or long records from the payload length and
+ * supports chunked records. Record payloads are either given as a buffer or
+ * produced by a constructor that writes them directly into the output.
+ */
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Size of the T4T NLEN field preceding the NDEF message. */
+#define NFC_NDEF_MSG_NLEN_SIZE 2
+
+/** @brief Message Begin record header flag. */
+#define NFC_NDEF_FLAG_MB 0x80
+/** @brief Message End record header flag. */
+#define NFC_NDEF_FLAG_ME 0x40
+/** @brief Chunk Flag record header flag. */
+#define NFC_NDEF_FLAG_CF 0x20
+/** @brief Short Record record header flag. */
+#define NFC_NDEF_FLAG_SR 0x10
+/** @brief ID Length present record header flag. */
+#define NFC_NDEF_FLAG_IL 0x08
+/** @brief Mask of the Type Name Format in the record header. */
+#define NFC_NDEF_TNF_MASK 0x07
+
+/** @brief Type Name Format values. */
+enum nfc_ndef_tnf {
+	NFC_NDEF_TNF_EMPTY,        /**< The record is empty. */
+	NFC_NDEF_TNF_WELL_KNOWN,   /**< NFC Forum well-known type. */
+	NFC_NDEF_TNF_MEDIA_TYPE,   /**< Media type (RFC 2046). */
+	NFC_NDEF_TNF_ABSOLUTE_URI, /**< Absolute URI (RFC 3986). */
+	NFC_NDEF_TNF_EXTERNAL,     /**< NFC Forum external type. */
+	NFC_NDEF_TNF_UNKNOWN,      /**< Unknown type. */
+	NFC_NDEF_TNF_UNCHANGED,    /**< Middle and terminating chunks. */
+};
+
+/** @brief Layout of the encoded message. */
+enum nfc_ndef_msg_format {
+	/** Plain NDEF message, for example for @ref nfc_t2t_payload_set. */
+	NFC_NDEF_MSG_FORMAT_RAW,
+	/** NDEF message preceded by the 2-byte NLEN field, as expected in the
+	 *  buffer given to @ref nfc_t4t_ndef_rwpayload_set or
+	 *  @ref nfc_t4t_ndef_staticpayload_set.
+	 */
+	NFC_NDEF_MSG_FORMAT_T4T,
+};
+
+/** @brief Record payload constructor.
+ *
+ * The constructor is called once with a NULL buffer during sizing and once
+ * more to write the payload, and must report the same length both times.
+ *
+ * @param context Constructor context from the record descriptor.
+ * @param buff Buffer receiving the payload, or NULL to only compute the
+ *	       payload length.
+ * @param len Size of @p buff on input. Receives the payload length.
+ *
+ * @retval 0 Success.
+ * @retval -ENOMEM @p buff is too small.
+ * @return Other negative error codes are passed through to the caller of
+ *	   @ref nfc_ndef_msg_encode.
+ */
+typedef int (*nfc_ndef_payload_constructor_t)(void *context, u8_t *buff,
+					      u32_t *len);
+
+/** @brief NDEF record descriptor. */
+struct nfc_ndef_record_desc {
+	/** Type Name Format. */
+	enum nfc_ndef_tnf tnf;
+	/** Record type. */
+	const u8_t *type;
+	/** Length of the record type. */
+	u8_t type_length;
+	/** Record ID, can be NULL. */
+	const u8_t *id;
+	/** Length of the record ID. */
+	u8_t id_length;
+	/** Payload buffer. Ignored if a constructor is given. */
+	const u8_t *payload;
+	/** Length of the payload buffer. */
+	u32_t payload_length;
+	/** Payload constructor, can be NULL. */
+	nfc_ndef_payload_constructor_t payload_constructor;
+	/** Context passed to the payload constructor. */
+	void *payload_context;
+	/** Maximum payload size of a chunk, 0 to never chunk the record. */
+	u32_t chunk_size;
+};
+
+/** @brief NDEF message descriptor. */
+struct nfc_ndef_msg_desc {
+	/** Records of the message. */
+	const struct nfc_ndef_record_desc *const *records;
+	/** Number of records. */
+	u32_t record_count;
+};
+
+/** @brief Encode an NDEF message.
+ *
+ * @param msg Message descriptor.
+ * @param format Layout of the encoded message.
+ * @param buff Output buffer, or NULL for a dry run that only computes the
+ *	       encoded size.
+ * @param len Size of @p buff on input. Receives the encoded size, NLEN
+ *	      field included.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer).
+ * @retval -ENOMEM @p buff is too small, or the message is too long for the
+ *	   NLEN field.
+ * @return Error code returned by a payload constructor.
+ */
+int nfc_ndef_msg_encode(const struct nfc_ndef_msg_desc *msg,
+			enum nfc_ndef_msg_format format,
+			u8_t *buff, u32_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_NDEF_MSG_H__ */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_NDEF_PARSER_H__
+#define NFC_NDEF_PARSER_H__
+
+/** @file
+ *
+ * @defgroup nfc_ndef_parser NDEF message parser
+ * @{
+ * @ingroup nfc_ndef
+ * @brief Streaming, allocation-free NDEF message parser.
+ *
+ * The parser walks the records of a message in place, one record per call
+ * to @ref nfc_ndef_parser_next, and returns views that point into the
+ * message buffer. Only the record header is validated when a record is
+ * returned; the payload is never read by the parser.
+ *
+ * When a reader updates the T4T NDEF file, signaled with
+ * @ref NFC_T4T_EVENT_NDEF_UPDATED, @ref nfc_ndef_parser_resume restarts
+ * parsing at the record that contains the first changed byte. Records
+ * before it are not parsed again. To find that record, the parser stores
+ * the offsets of the parsed records in an optional caller-provided table.
+ */
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+
+#include "nfc_ndef_msg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief View of a record, pointing into the message buffer. */
+struct nfc_ndef_record_view {
+	/** Record header flags, see NFC_NDEF_FLAG_*. */
+	u8_t flags;
+	/** Type Name Format. */
+	enum nfc_ndef_tnf tnf;
+	/** Record type. */
+	const u8_t *type;
+	/** Length of the record type. */
+	u8_t type_length;
+	/** Record ID, NULL if the record has none. */
+	const u8_t *id;
+	/** Length of the record ID. */
+	u8_t id_length;
+	/** Record payload. */
+	const u8_t *payload;
+	/** Length of the record payload. */
+	u32_t payload_length;
+	/** Offset of the record in the message. */
+	u32_t offset;
+	/** Index of the record in the message. */
+	u32_t index;
+};
+
+/** @brief Parser state.
+ *
+ * @note The members are internal and must not be accessed directly.
+ */
+struct nfc_ndef_parser {
+	const u8_t *msg;
+	u32_t length;
+	u32_t offset;
+	u32_t index;
+	u32_t *marks;
+	u32_t mark_count;
+	bool end;
+};
+
+/** @brief Initialize a parser over a plain NDEF message.
+ *
+ * @param parser Parser.
+ * @param msg NDEF message.
+ * @param length Length of the message.
+ * @param marks Table receiving the offset of each parsed record, used by
+ *	        @ref nfc_ndef_parser_resume. Can be NULL.
+ * @param mark_count Number of entries in @p marks.
+ */
+void nfc_ndef_parser_init(struct nfc_ndef_parser *parser, const u8_t *msg,
+			  u32_t length, u32_t *marks, u32_t mark_count);
+
+/** @brief Initialize a parser over a T4T NDEF file.
+ *
+ * The message length is taken from the NLEN field at the start of the
+ * buffer.
+ *
+ * @param parser Parser.
+ * @param file Buffer registered with @ref nfc_t4t_ndef_rwpayload_set.
+ * @param file_size Size of the buffer.
+ * @param marks See @ref nfc_ndef_parser_init.
+ * @param mark_count See @ref nfc_ndef_parser_init.
+ *
+ * @retval 0 Success.
+ * @retval -EBADMSG NLEN exceeds the size of the buffer.
+ */
+int nfc_ndef_parser_init_t4t(struct nfc_ndef_parser *parser, const u8_t *file,
+			     u32_t file_size, u32_t *marks, u32_t mark_count);
+
+/** @brief Get the next record.
+ *
+ * @param parser Parser.
+ * @param record Receives the record view.
+ *
+ * @retval 0 Success.
+ * @retval -ENOENT No more records.
+ * @retval -EBADMSG The record header is malformed or does not fit in the
+ *	   message. Parsing cannot continue.
+ */
+int nfc_ndef_parser_next(struct nfc_ndef_parser *parser,
+			 struct nfc_ndef_record_view *record);
+
+/** @brief Resume parsing after part of the message changed.
+ *
+ * Positions the parser at the last parsed record that starts at or before
+ * @p changed_offset, or at the start of the message if no record boundary is
+ * known. The message buffer is expected to be the same as before; only its
+ * content and length may have changed.
+ *
+ * @param parser Parser.
+ * @param length New length of the message.
+ * @param changed_offset Offset of the first changed byte in the message.
+ */
+void nfc_ndef_parser_resume(struct nfc_ndef_parser *parser, u32_t length,
+			    u32_t changed_offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_NDEF_PARSER_H__ */
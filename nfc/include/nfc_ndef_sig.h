@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_NDEF_SIG_H__
+#define NFC_NDEF_SIG_H__
+
+/** @file
+ *
+ * @defgroup nfc_ndef_sig Signed NDEF messages
+ * @{
+ * @ingroup nfc_ndef
+ * @brief NDEF messages closed by a Signature record (Signature RTD 2.0).
+ *
+ * @ref nfc_ndef_sig_msg_encode encodes a message with
+ * @ref nfc_ndef_msg_encode and appends a Signature record that covers the
+ * type, ID and payload of every record of the message. The signed data is
+ * read in place from the encoded message. ECDSA P-256 hashes it
+ * incrementally, so no copy is made. Ed25519 needs the signed data in one
+ * piece and assembles it in a scratch buffer.
+ *
+ * Signing takes tens of milliseconds, which is longer than a reader waits.
+ * Sign from the generator of @ref nfc_ndef_dyn in
+ * @ref NFC_NDEF_DYN_PRECOMPUTE mode, so the message for the next tap is
+ * signed in the background after the field is lost. Include a counter or
+ * nonce record, updated by the generator, to make each signed message
+ * unique.
+ */
+
+#include <zephyr/types.h>
+
+#include "nfc_ndef_msg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Size of a signature. */
+#define NFC_NDEF_SIG_SIZE 64
+
+/** @brief Signature algorithms. */
+enum nfc_ndef_sig_alg {
+	NFC_NDEF_SIG_ECDSA_P256, /**< ECDSA over P-256 with SHA-256. */
+	NFC_NDEF_SIG_ED25519,    /**< Ed25519. */
+};
+
+/** @brief Random number source for ECDSA session keys.
+ *
+ * @param buf Buffer to fill with random bytes.
+ * @param length Number of bytes.
+ *
+ * @retval 0 Success.
+ * @return Negative error code on failure.
+ */
+typedef int (*nfc_ndef_sig_rand_t)(u8_t *buf, size_t length);
+
+/** @brief Signing key and Signature record parameters. */
+struct nfc_ndef_sig_key {
+	/** Algorithm. */
+	enum nfc_ndef_sig_alg alg;
+	/** Signature type written to the Signature record. */
+	u8_t sig_type;
+	/** Hash type written to the Signature record. */
+	u8_t hash_type;
+	/** Secret key, 32 bytes. */
+	const u8_t *sk;
+	/** Public key, 32 bytes. Used by Ed25519 only. */
+	const u8_t *pk;
+	/** Random source for session keys. Used by ECDSA only. */
+	nfc_ndef_sig_rand_t rand;
+	/** Encoded certificate chain field, including the certificate format
+	 *  and number of certificates byte. If NULL, a field with no
+	 *  certificate and no URI is written.
+	 */
+	const u8_t *cert_chain;
+	/** Length of the certificate chain field. */
+	size_t cert_chain_length;
+	/** Buffer in which the signed data is assembled. Used by Ed25519
+	 *  only. Must hold the type, ID and payload of all records.
+	 */
+	u8_t *scratch;
+	/** Size of the scratch buffer. */
+	size_t scratch_size;
+};
+
+/** @brief Encode a message followed by its Signature record.
+ *
+ * @param key Signing key.
+ * @param msg Message descriptor. Can have no records.
+ * @param format Layout of the encoded message.
+ * @param buff Output buffer, or NULL for a dry run that only computes the
+ *	       encoded size.
+ * @param len Size of @p buff on input. Receives the encoded size.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer).
+ * @retval -ENOMEM @p buff or the scratch buffer is too small.
+ * @retval -EIO Signing failed.
+ * @return Error code returned by @ref nfc_ndef_msg_encode or by the random
+ *	   source.
+ */
+int nfc_ndef_sig_msg_encode(const struct nfc_ndef_sig_key *key,
+			    const struct nfc_ndef_msg_desc *msg,
+			    enum nfc_ndef_msg_format format,
+			    u8_t *buff, u32_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_NDEF_SIG_H__ */
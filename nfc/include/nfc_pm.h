@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_PM_H__
+#define NFC_PM_H__
+
+/** @file
+ *
+ * @defgroup nfc_pm NFC field sensing power manager
+ * @{
+ * @ingroup nfc_api
+ * @brief Duty-cycled NFCT field sensing while no reader is present.
+ *
+ * Once the emulation is started, NFCT senses the field continuously. With
+ * the power manager started, NFCT senses only during a window at the
+ * start of each period, and is disabled for the rest of it. The first
+ * field detected switches to continuous sensing, which is kept while the
+ * reader is present and for a hold time after the field is lost, so that
+ * repeated taps are not delayed. Duty cycling resumes afterwards.
+ *
+ * A reader is detected at most one period late, if its field lasts
+ * longer than the off time. The NFC platform reports field detection
+ * and loss with @ref nfc_pm_field_detected and @ref nfc_pm_field_lost.
+ *
+ * Every period costs two wakeups of the CPU, which can outweigh the
+ * current saved by not sensing. @ref nfc_pm_current_estimate gives the
+ * average idle current of each policy for given figures, to choose the
+ * policy and period for a board.
+ */
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Rough idle current figures for nRF52832 at 3 V with the DC/DC
+ *  converter. Measure the board for accurate numbers.
+ */
+#define NFC_PM_CURRENT_DEFAULT     \
+	{                          \
+		.base_na = 1900,   \
+		.sense_na = 100,   \
+		.disabled_na = 0,  \
+		.wakeup_nc = 60,   \
+	}
+
+/** @brief Sensing policies. */
+enum nfc_pm_policy {
+	NFC_PM_POLICY_CONTINUOUS,  /**< Sense all the time. */
+	NFC_PM_POLICY_DUTY_CYCLED, /**< Sense during a window per period. */
+};
+
+/** @brief Duty cycle parameters. */
+struct nfc_pm_config {
+	/** Period of the sense windows, in milliseconds. */
+	u32_t period_ms;
+	/** Sense window at the start of each period, in milliseconds. */
+	u32_t window_ms;
+	/** Continuous sensing kept after the field is lost, in
+	 *  milliseconds.
+	 */
+	u32_t hold_ms;
+};
+
+/** @brief Idle current figures. */
+struct nfc_pm_current {
+	/** System idle current apart from NFCT, in nA. Includes HFXO
+	 *  with the always-on clock policy.
+	 */
+	u32_t base_na;
+	/** NFCT current while sensing, in nA. */
+	u32_t sense_na;
+	/** NFCT current while disabled, in nA. */
+	u32_t disabled_na;
+	/** Charge of one CPU wakeup to switch sensing, in nC. */
+	u32_t wakeup_nc;
+};
+
+/** @brief Power manager statistics. */
+struct nfc_pm_stats {
+	u32_t windows;     /**< Sense windows opened while idle. */
+	u32_t detections;  /**< Fields detected. */
+	u32_t sense_ms;    /**< Time spent sensing or activated. */
+	u32_t disabled_ms; /**< Time spent with sensing disabled. */
+};
+
+/** @brief Start duty cycling.
+ *
+ * Call after the emulation has been started. Sensing is continuous until
+ * the end of the first window. If a reader is present, it is continuous
+ * until the hold time after the field is lost.
+ *
+ * @param config Duty cycle parameters. Copied.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. a window not shorter than the
+ *	   period).
+ */
+int nfc_pm_start(const struct nfc_pm_config *config);
+
+/** @brief Stop duty cycling and sense continuously.
+ *
+ * Call before the emulation is stopped.
+ */
+void nfc_pm_stop(void);
+
+#if defined(CONFIG_NFC_PM)
+
+/** @brief Report a detected field.
+ *
+ * Called by the NFC platform from interrupt context.
+ */
+void nfc_pm_field_detected(void);
+
+/** @brief Report a lost field.
+ *
+ * Called by the NFC platform from interrupt context.
+ */
+void nfc_pm_field_lost(void);
+
+#else
+
+static inline void nfc_pm_field_detected(void)
+{
+}
+
+static inline void nfc_pm_field_lost(void)
+{
+}
+
+#endif
+
+/** @brief Get the power manager statistics.
+ *
+ * @param stats Statistics output.
+ */
+void nfc_pm_stats_get(struct nfc_pm_stats *stats);
+
+/** @brief Estimate the average current while no reader is present.
+ *
+ * @param policy Sensing policy.
+ * @param config Duty cycle parameters. Only used by
+ *		 @ref NFC_PM_POLICY_DUTY_CYCLED.
+ * @param current Idle current figures.
+ *
+ * @return Average current in nA, or 0 for invalid parameters.
+ */
+u32_t nfc_pm_current_estimate(enum nfc_pm_policy policy,
+			      const struct nfc_pm_config *config,
+			      const struct nfc_pm_current *current);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_PM_H__ */
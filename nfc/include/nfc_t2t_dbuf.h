@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_T2T_DBUF_H__
+#define NFC_T2T_DBUF_H__
+
+/** @file
+ *
+ * @defgroup nfc_t2t_dbuf NFC tag 2 type double-buffered payload
+ * @{
+ * @ingroup nfc_t2t
+ * @brief Double-buffered payload updates for the T2T emulation library.
+ *
+ * @ref nfc_t2t_payload_set must not be used while the emulation is running,
+ * so replacing the tag content requires stopping and restarting the
+ * emulation. This module keeps two application-provided payload buffers: one
+ * is served to the reader, the other one is staged by the application.
+ *
+ * A committed payload is swapped in only when no reader is present: right
+ * away if there is no field, otherwise after @ref NFC_T2T_EVENT_FIELD_OFF.
+ * The stop, set and start sequence runs from the system work queue, so a
+ * reader never sees the emulation disappear during a session.
+ *
+ * Usage:
+ *   - @ref nfc_t2t_setup with an application callback that forwards every
+ *     event to @ref nfc_t2t_dbuf_event_process.
+ *   - @ref nfc_t2t_dbuf_init.
+ *   - Write the first payload into @ref nfc_t2t_dbuf_staging_get and
+ *     @ref nfc_t2t_dbuf_commit it.
+ *   - @ref nfc_t2t_dbuf_emulation_start.
+ *   - Stage and commit new payloads at any time.
+ */
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+#include <kernel.h>
+
+#include "nfc_t2t_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Initialize the double-buffered payload.
+ *
+ * @param buf0 First payload buffer. Must be in RAM.
+ * @param buf1 Second payload buffer. Must be in RAM.
+ * @param size Size of each buffer.
+ * @param raw If true, payloads are registered with
+ *	      @ref nfc_t2t_payload_raw_set, otherwise with
+ *	      @ref nfc_t2t_payload_set.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer).
+ * @retval -EBUSY Emulation is running.
+ */
+int nfc_t2t_dbuf_init(u8_t *buf0, u8_t *buf1, size_t size, bool raw);
+
+/** @brief Get the buffer in which to prepare the next payload.
+ *
+ * If a committed payload has not been swapped in yet, it is withdrawn and
+ * its buffer is returned, so that the application can replace it with
+ * newer content. It stays pending, but is not swapped in, until the next
+ * @ref nfc_t2t_dbuf_commit.
+ *
+ * @param size Receives the size of the buffer.
+ *
+ * @return Staging buffer, or NULL if a swap is in progress. The work set with
+ *	   @ref nfc_t2t_dbuf_staging_work_set is submitted when it finishes.
+ */
+u8_t *nfc_t2t_dbuf_staging_get(size_t *size);
+
+/** @brief Set the work to submit when the staging buffer is available again.
+ *
+ * @param work Work submitted after a swap during which
+ *	       @ref nfc_t2t_dbuf_staging_get returned NULL or
+ *	       @ref nfc_t2t_dbuf_commit returned -EBUSY, or NULL for none.
+ */
+void nfc_t2t_dbuf_staging_work_set(struct k_work *work);
+
+/** @brief Commit the staging buffer.
+ *
+ * @param length Length of the payload in the staging buffer.
+ *
+ * @retval 0 Success. The payload will be swapped in when no reader is
+ *	   present.
+ * @retval -EINVAL Payload too long.
+ * @retval -EBUSY A swap is in progress. The work set with
+ *	   @ref nfc_t2t_dbuf_staging_work_set is submitted when it finishes.
+ */
+int nfc_t2t_dbuf_commit(size_t length);
+
+/** @brief Check whether a committed payload waits to be swapped in.
+ *
+ * @retval true A payload is pending, or was withdrawn by
+ *	   @ref nfc_t2t_dbuf_staging_get and not committed again.
+ * @retval false The last committed payload is being served.
+ */
+bool nfc_t2t_dbuf_pending(void);
+
+/** @brief Start the emulation through the double-buffered payload.
+ *
+ * Use instead of @ref nfc_t2t_emulation_start.
+ *
+ * @retval 0 Success.
+ * @retval -EBUSY Already started.
+ * @return Error code returned by @ref nfc_t2t_emulation_start.
+ */
+int nfc_t2t_dbuf_emulation_start(void);
+
+/** @brief Stop the emulation through the double-buffered payload.
+ *
+ * Use instead of @ref nfc_t2t_emulation_stop.
+ *
+ * @retval 0 Success.
+ * @return Error code returned by @ref nfc_t2t_emulation_stop.
+ */
+int nfc_t2t_dbuf_emulation_stop(void);
+
+/** @brief Process a T2T library event.
+ *
+ * Must be called from the application @ref nfc_t2t_callback_t for every
+ * event.
+ *
+ * @param event The event.
+ */
+void nfc_t2t_dbuf_event_process(enum nfc_t2t_event event);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_T2T_DBUF_H__ */
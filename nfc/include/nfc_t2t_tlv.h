@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_T2T_TLV_H__
+#define NFC_T2T_TLV_H__
+
+/** @file
+ *
+ * @defgroup nfc_t2t_tlv NFC tag 2 type TLV layout
+ * @{
+ * @ingroup nfc_t2t_lib
+ * @brief Layout of the T2T data area for @ref nfc_t2t_payload_raw_set.
+ *
+ * @ref nfc_t2t_payload_set places a single NDEF TLV in the data area. This
+ * module lays out several NDEF, Lock Control, Memory Control and
+ * proprietary TLVs in a raw image instead:
+ * - Control TLVs come first, then NDEF TLVs, then proprietary TLVs, as
+ *   readers stop at the first NDEF TLV. The order within each group is
+ *   kept.
+ * - Lengths below 255 use the 1-byte format.
+ * - The areas reserved by the control TLVs are skipped and filled with
+ *   zeros, and no NULL TLVs are added.
+ * - A Terminator TLV follows the last TLV, unless the image ends at
+ *   the end of the data area.
+ *
+ * The image is as short as the TLVs allow, so a reader reaches the NDEF
+ * message with as few READ commands as possible.
+ *
+ * The capability container is set by the library and announces
+ * @ref NFC_T2T_MAX_PAYLOAD_SIZE_RAW bytes of read-only data area, so the
+ * internal bytes do not need to change with the layout.
+ */
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief TLV types. */
+enum nfc_t2t_tlv_type {
+	NFC_T2T_TLV_NULL = 0x00,           /**< Padding, not accepted. */
+	NFC_T2T_TLV_LOCK_CONTROL = 0x01,   /**< Dynamic lock bits. */
+	NFC_T2T_TLV_MEMORY_CONTROL = 0x02, /**< Reserved memory. */
+	NFC_T2T_TLV_NDEF = 0x03,           /**< NDEF message. */
+	NFC_T2T_TLV_PROPRIETARY = 0xFD,    /**< Proprietary data. */
+	NFC_T2T_TLV_TERMINATOR = 0xFE,     /**< Terminator, not accepted. */
+};
+
+/** @brief Value length of Lock Control and Memory Control TLVs. */
+#define NFC_T2T_TLV_CONTROL_SIZE 3
+
+/** @brief TLV descriptor. */
+struct nfc_t2t_tlv {
+	/** TLV type. */
+	enum nfc_t2t_tlv_type type;
+	/** Value, can be NULL if @p length is 0. */
+	const u8_t *value;
+	/** Value length. Control TLVs have @ref NFC_T2T_TLV_CONTROL_SIZE
+	 *  bytes: position, size and page control, which locate the reserved
+	 *  area in the tag memory.
+	 */
+	u16_t length;
+};
+
+/** @brief Lay out TLVs in a raw T2T data area image.
+ *
+ * @param tlvs TLV descriptors.
+ * @param count Number of TLV descriptors.
+ * @param buff Output buffer, or NULL for a dry run that only computes the
+ *	       image size.
+ * @param len Size of @p buff on input. Receives the image size.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer, unsupported type,
+ *	   control TLV of wrong length or reserving the tag header).
+ * @retval -ENOMEM @p buff is too small, or the image does not fit in
+ *	   @ref NFC_T2T_MAX_PAYLOAD_SIZE_RAW bytes.
+ */
+int nfc_t2t_tlv_layout(const struct nfc_t2t_tlv *tlvs, u32_t count,
+		       u8_t *buff, u32_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_T2T_TLV_H__ */
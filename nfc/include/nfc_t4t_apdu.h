@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_T4T_APDU_H__
+#define NFC_T4T_APDU_H__
+
+/** @file
+ *
+ * @defgroup nfc_t4t_apdu NFC tag 4 type APDU router
+ * @{
+ * @ingroup nfc_t4t
+ * @brief Table-driven APDU dispatch for the T4T library in PICC mode.
+ *
+ * In @ref NFC_T4T_EMUMODE_PICC, the application receives every command
+ * APDU through @ref NFC_T4T_EVENT_DATA_IND and must answer it with
+ * @ref nfc_t4t_response_pdu_send. The router decodes the command header and
+ * dispatches it through constant tables:
+ *
+ *   - SELECT by DF name selects one of the registered applications by AID.
+ *   - The routes of the selected application are matched on CLA, INS, P1
+ *     and P2, each with a mask.
+ *   - A route either calls a handler, which writes the response data and
+ *     returns the status word, or returns a pre-encoded response stored
+ *     in constant memory, without running any application code.
+ *
+ * Responses are always complete R-APDUs, status word included.
+ *
+ * Command APDUs longer than the frame size of the reader arrive as several
+ * @ref NFC_T4T_EVENT_DATA_IND events chained with @ref NFC_T4T_DI_FLAG_MORE.
+ * The reassembler passes single-frame commands through without a copy and
+ * appends chained fragments directly into a caller-registered buffer.
+ *
+ * Both short and extended length commands are decoded. Handlers can answer
+ * with a response producer instead of a buffer. The router then returns the
+ * response in chunks of at most the size of the response buffer, produced
+ * on demand, and the reader fetches the remaining chunks with GET RESPONSE
+ * as announced by status word 61xx (ISO/IEC 7816-4). The whole response is
+ * never held in RAM.
+ */
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+
+#include "nfc_t4t_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Size of a status word. */
+#define NFC_T4T_APDU_SW_SIZE 2
+
+/** @brief Status word: Command completed. */
+#define NFC_T4T_APDU_SW_OK                   0x9000
+/** @brief Status word: Response bytes still available, the low byte gives
+ *  the number of bytes (0 for 256 or more).
+ */
+#define NFC_T4T_APDU_SW_BYTES_REMAINING      0x6100
+/** @brief Status word: Wrong length. */
+#define NFC_T4T_APDU_SW_WRONG_LENGTH         0x6700
+/** @brief Status word: Security status not satisfied. */
+#define NFC_T4T_APDU_SW_SECURITY_NOT_SAT     0x6982
+/** @brief Status word: Conditions of use not satisfied. */
+#define NFC_T4T_APDU_SW_CONDITIONS_NOT_SAT   0x6985
+/** @brief Status word: Command not allowed, no current file. */
+#define NFC_T4T_APDU_SW_NO_CURRENT_FILE      0x6986
+/** @brief Status word: File or application not found. */
+#define NFC_T4T_APDU_SW_NOT_FOUND            0x6A82
+/** @brief Status word: Incorrect parameters P1-P2. */
+#define NFC_T4T_APDU_SW_WRONG_P1P2           0x6A86
+/** @brief Status word: Wrong parameters P1-P2, e.g. offset outside the
+ *  file.
+ */
+#define NFC_T4T_APDU_SW_WRONG_PARAMS         0x6B00
+/** @brief Status word: Instruction code not supported. */
+#define NFC_T4T_APDU_SW_INS_NOT_SUPPORTED    0x6D00
+/** @brief Status word: Class not supported. */
+#define NFC_T4T_APDU_SW_CLA_NOT_SUPPORTED    0x6E00
+/** @brief Status word: No precise diagnosis. */
+#define NFC_T4T_APDU_SW_UNKNOWN              0x6F00
+
+/** @brief Decoded command APDU. */
+struct nfc_t4t_apdu {
+	u8_t cla;         /**< Class byte. */
+	u8_t ins;         /**< Instruction byte. */
+	u8_t p1;          /**< Parameter 1. */
+	u8_t p2;          /**< Parameter 2. */
+	const u8_t *data; /**< Command data, NULL if Lc is absent. */
+	u32_t lc;         /**< Length of the command data. */
+	u32_t le;         /**< Expected response length, 0 if Le is absent. */
+	bool le_present;  /**< True if the command carries Le. */
+	bool extended;    /**< True if Lc and Le are in extended format. */
+};
+
+/** @brief Response producer.
+ *
+ * Called by the router each time a chunk of a streamed response is sent.
+ * Chunks are requested in order, without gaps.
+ *
+ * @param context Producer context set by the handler.
+ * @param offset Offset of the chunk in the response.
+ * @param buf Buffer receiving the chunk.
+ * @param length Number of bytes to write to @p buf.
+ *
+ * @retval 0 Success.
+ * @return Negative error code to abort the response.
+ */
+typedef int (*nfc_t4t_apdu_producer_t)(void *context, u32_t offset,
+				       u8_t *buf, size_t length);
+
+/** @brief Response buffer passed to a handler. */
+struct nfc_t4t_apdu_rsp {
+	u8_t *data;    /**< Buffer for the response data. */
+	size_t size;   /**< Size of the buffer, status word excluded. */
+	size_t length; /**< Length of the response data written. */
+	/** Producer of a streamed response. If set by the handler, the
+	 *  response data is produced on demand and @ref length is ignored.
+	 */
+	nfc_t4t_apdu_producer_t producer;
+	/** Producer context. */
+	void *producer_context;
+	/** Total length of the streamed response. */
+	u32_t producer_length;
+};
+
+/** @brief APDU handler.
+ *
+ * @param context Handler context from the route.
+ * @param apdu Decoded command.
+ * @param rsp Response buffer. The handler sets @p rsp->length.
+ *
+ * @return Status word appended to the response.
+ */
+typedef u16_t (*nfc_t4t_apdu_handler_t)(void *context,
+					const struct nfc_t4t_apdu *apdu,
+					struct nfc_t4t_apdu_rsp *rsp);
+
+/** @brief Route of an application. */
+struct nfc_t4t_apdu_route {
+	u8_t cla;      /**< Class byte to match. */
+	u8_t cla_mask; /**< Bits of the class byte to compare. */
+	u8_t ins;      /**< Instruction byte to match. */
+	u8_t p1;       /**< Parameter 1 to match. */
+	u8_t p1_mask;  /**< Bits of parameter 1 to compare. */
+	u8_t p2;       /**< Parameter 2 to match. */
+	u8_t p2_mask;  /**< Bits of parameter 2 to compare. */
+	/** Handler. If NULL, @ref response is sent. */
+	nfc_t4t_apdu_handler_t handler;
+	/** Handler context. */
+	void *context;
+	/** Pre-encoded response, status word included. */
+	const u8_t *response;
+	/** Length of the pre-encoded response. */
+	size_t response_length;
+};
+
+/** @brief Route matching any CLA, P1 and P2 for an instruction. */
+#define NFC_T4T_APDU_ROUTE_INS(_ins, _handler, _context) \
+	{ .ins = (_ins), .handler = (_handler), .context = (_context) }
+
+/** @brief Route returning a pre-encoded response for an instruction. */
+#define NFC_T4T_APDU_ROUTE_STATIC(_ins, _response)                    \
+	{ .ins = (_ins), .response = (_response),                      \
+	  .response_length = sizeof(_response) }
+
+/** @brief Application selectable by AID. */
+struct nfc_t4t_apdu_app {
+	/** Application identifier. */
+	const u8_t *aid;
+	/** Length of the application identifier. */
+	u8_t aid_length;
+	/** Routes, matched in order. */
+	const struct nfc_t4t_apdu_route *routes;
+	/** Number of routes. */
+	size_t route_count;
+	/** Pre-encoded response to SELECT, status word included. If NULL,
+	 *  SELECT is answered with @ref NFC_T4T_APDU_SW_OK only.
+	 */
+	const u8_t *select_response;
+	/** Length of the pre-encoded response to SELECT. */
+	size_t select_response_length;
+	/** Called when the application is selected, can be NULL. */
+	void (*on_select)(void *context);
+	/** Context passed to @ref on_select. */
+	void *select_context;
+};
+
+/** @brief Router.
+ *
+ * @note The members are internal and must not be accessed directly.
+ */
+struct nfc_t4t_apdu_router {
+	const struct nfc_t4t_apdu_app *apps;
+	size_t app_count;
+	const struct nfc_t4t_apdu_app *selected;
+	u8_t *rsp_buf;
+	size_t rsp_size;
+	nfc_t4t_apdu_producer_t producer;
+	void *producer_context;
+	u32_t stream_offset;
+	u32_t stream_left;
+	u16_t stream_sw;
+};
+
+/** @brief Reassembler of chained command APDUs.
+ *
+ * @note The members are internal and must not be accessed directly.
+ */
+struct nfc_t4t_apdu_reasm {
+	u8_t *buf;
+	size_t size;
+	size_t length;
+	bool overflow;
+};
+
+/** @brief Decode a command APDU.
+ *
+ * @param buf Command APDU.
+ * @param length Length of the command APDU.
+ * @param apdu Receives the decoded command. Data points into @p buf.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Malformed APDU.
+ */
+int nfc_t4t_apdu_parse(const u8_t *buf, size_t length,
+		       struct nfc_t4t_apdu *apdu);
+
+/** @brief Initialize a router.
+ *
+ * @param router Router.
+ * @param apps Applications. Must stay valid while the router is used.
+ * @param app_count Number of applications.
+ * @param rsp_buf Buffer for responses produced by handlers. Must stay valid
+ *		  until the response has been sent.
+ * @param rsp_size Size of @p rsp_buf, status word included. Bounds the size
+ *		   of each chunk of a streamed response, so it must leave
+ *		   room for at least one data byte.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer, or @p rsp_size not
+ *	   larger than the status word).
+ */
+int nfc_t4t_apdu_router_init(struct nfc_t4t_apdu_router *router,
+			     const struct nfc_t4t_apdu_app *apps,
+			     size_t app_count, u8_t *rsp_buf, size_t rsp_size);
+
+/** @brief Dispatch a command APDU.
+ *
+ * @param router Router.
+ * @param buf Command APDU.
+ * @param length Length of the command APDU.
+ * @param rsp Receives a pointer to the response APDU.
+ * @param rsp_length Receives the length of the response APDU.
+ */
+void nfc_t4t_apdu_router_dispatch(struct nfc_t4t_apdu_router *router,
+				  const u8_t *buf, size_t length,
+				  const u8_t **rsp, size_t *rsp_length);
+
+/** @brief Dispatch a command APDU and send the response.
+ *
+ * Call on the last @ref NFC_T4T_EVENT_DATA_IND fragment of a command.
+ *
+ * @param router Router.
+ * @param buf Command APDU.
+ * @param length Length of the command APDU.
+ *
+ * @return Error code returned by @ref nfc_t4t_response_pdu_send.
+ */
+int nfc_t4t_apdu_router_process(struct nfc_t4t_apdu_router *router,
+				const u8_t *buf, size_t length);
+
+/** @brief Deselect the current application.
+ *
+ * Call on @ref NFC_T4T_EVENT_FIELD_OFF.
+ *
+ * @param router Router.
+ */
+void nfc_t4t_apdu_router_reset(struct nfc_t4t_apdu_router *router);
+
+/** @brief Initialize a reassembler.
+ *
+ * @param reasm Reassembler.
+ * @param buf Buffer receiving chained fragments. Must stay valid while the
+ *	      reassembler is used.
+ * @param size Size of @p buf, which bounds the length of chained commands.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer).
+ */
+int nfc_t4t_apdu_reasm_init(struct nfc_t4t_apdu_reasm *reasm, u8_t *buf,
+			    size_t size);
+
+/** @brief Feed a fragment to the reassembler.
+ *
+ * Call on every @ref NFC_T4T_EVENT_DATA_IND with the data, length and flags
+ * of the event. A command received in a single frame is returned as is,
+ * pointing into the library buffer, and is valid only until the callback
+ * returns. A chained command is returned from the registered buffer, and is
+ * valid until the next call.
+ *
+ * @param reasm Reassembler.
+ * @param data Fragment data.
+ * @param length Length of the fragment.
+ * @param flags Flags of the event, see @ref nfc_t4t_data_ind_flags.
+ * @param apdu Receives a pointer to the complete command.
+ * @param apdu_length Receives the length of the complete command.
+ *
+ * @retval 0 The command is complete.
+ * @retval -EAGAIN More fragments are expected.
+ * @retval -ENOMEM The command did not fit in the registered buffer. It is
+ *	   discarded and should be answered with
+ *	   @ref NFC_T4T_APDU_SW_WRONG_LENGTH.
+ */
+int nfc_t4t_apdu_reasm_put(struct nfc_t4t_apdu_reasm *reasm, const u8_t *data,
+			   size_t length, u32_t flags,
+			   const u8_t **apdu, size_t *apdu_length);
+
+/** @brief Discard a partially received command.
+ *
+ * Call on @ref NFC_T4T_EVENT_FIELD_OFF.
+ *
+ * @param reasm Reassembler.
+ */
+void nfc_t4t_apdu_reasm_reset(struct nfc_t4t_apdu_reasm *reasm);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_T4T_APDU_H__ */
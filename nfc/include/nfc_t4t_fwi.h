@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_T4T_FWI_H__
+#define NFC_T4T_FWI_H__
+
+/** @file
+ *
+ * @defgroup nfc_t4t_fwi NFC tag 4 type frame waiting time tuner
+ * @{
+ * @ingroup nfc_t4t
+ * @brief Adaptive selection of the Frame Waiting time Integer (FWI).
+ *
+ * The reader waits at most the Frame Waiting Time (FWT) for the response to
+ * a command, with FWT = 256 * 16 / fc * 2^FWI. A large FWI gives slow
+ * handlers, such as ECDSA signing, time to answer. It also delays error
+ * recovery on every transaction.
+ *
+ * The tuner measures the time between the last @ref NFC_T4T_EVENT_DATA_IND
+ * fragment of a command and the call to @ref nfc_t4t_response_pdu_send. It
+ * then selects the smallest FWI that covers the slowest recent response
+ * plus a margin. The FWI is announced in the ATS at activation, so a new
+ * value is applied with @ref NFC_T4T_PARAM_FWI on
+ * @ref NFC_T4T_EVENT_FIELD_OFF and takes effect on the next tap. The
+ * recorded peak decays from tap to tap, so FWI is lowered again once slow
+ * commands stop.
+ *
+ * Times are taken with k_cycle_get_32(), which counts the 32768 Hz RTC on
+ * nRF52. Response times are therefore measured to about 30.5 us, which is
+ * well below the smallest FWT of about 302 us.
+ */
+
+#include <zephyr/types.h>
+
+#include "nfc_t4t_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Largest FWI allowed by ISO/IEC 14443-4. */
+#define NFC_T4T_FWI_MAX 14
+
+/** @brief Tuner statistics. */
+struct nfc_t4t_fwi_stats {
+	u32_t samples;    /**< Number of measured responses. */
+	u32_t overruns;   /**< Responses slower than the FWT in use. */
+	u32_t max_us;     /**< Slowest response measured, in microseconds. */
+	u32_t last_us;    /**< Last response measured, in microseconds. */
+	u32_t peak_us;    /**< Decayed peak used to select FWI. */
+	u8_t fwi;         /**< FWI in use. */
+};
+
+/** @brief Frame Waiting Time for an FWI.
+ *
+ * @param fwi Frame Waiting time Integer.
+ *
+ * @return Frame Waiting Time in microseconds.
+ */
+u32_t nfc_t4t_fwi_to_us(u8_t fwi);
+
+/** @brief Initialize the tuner and apply the initial FWI.
+ *
+ * Call after @ref nfc_t4t_setup and before @ref nfc_t4t_emulation_start.
+ *
+ * @param fwi_min Smallest FWI the tuner selects, also used initially.
+ * @param fwi_max Largest FWI the tuner selects.
+ * @param margin_pct Margin added to the measured peak, in percent.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid FWI range.
+ * @return Error code returned by @ref nfc_t4t_parameter_set.
+ */
+int nfc_t4t_fwi_init(u8_t fwi_min, u8_t fwi_max, u32_t margin_pct);
+
+/** @brief Mark the reception of a complete command.
+ *
+ * Call on the last @ref NFC_T4T_EVENT_DATA_IND fragment of a command.
+ */
+void nfc_t4t_fwi_command_received(void);
+
+/** @brief Mark the response to the current command.
+ *
+ * Call right after @ref nfc_t4t_response_pdu_send.
+ */
+void nfc_t4t_fwi_response_sent(void);
+
+/** @brief Select and apply the FWI for the next tap.
+ *
+ * Call on @ref NFC_T4T_EVENT_FIELD_OFF.
+ *
+ * @retval 0 Success.
+ * @return Error code returned by @ref nfc_t4t_parameter_set.
+ */
+int nfc_t4t_fwi_field_off(void);
+
+/** @brief Get the tuner statistics.
+ *
+ * @param stats Receives the statistics.
+ */
+void nfc_t4t_fwi_stats_get(struct nfc_t4t_fwi_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_T4T_FWI_H__ */
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NFC_T4T_NDEF_APP_H__
+#define NFC_T4T_NDEF_APP_H__
+
+/** @file
+ *
+ * @defgroup nfc_t4t_ndef_app NFC tag 4 type NDEF application for the router
+ * @{
+ * @ingroup nfc_t4t_apdu
+ * @brief NFC Forum NDEF application served by the APDU router.
+ *
+ * The T4T library emulates either the NDEF application alone
+ * (@ref NFC_T4T_EMUMODE_NDEF) or passes every APDU to the application
+ * (@ref NFC_T4T_EMUMODE_PICC), not both. This module lets a PICC mode
+ * application keep standard NDEF reading and writing next to its own AIDs:
+ * it is an @ref nfc_t4t_apdu_app whose route table serves the capability
+ * container and an NDEF file with SELECT, READ BINARY and UPDATE BINARY,
+ * as the library does in NDEF mode.
+ *
+ * Each instance has its own NDEF file and can use its own AID, so several
+ * NDEF files can be exposed under different applications.
+ *
+ * Usage:
+ * @code
+ * NFC_T4T_NDEF_APP_DEFINE(ndef);
+ *
+ * static const struct nfc_t4t_apdu_app apps[] = {
+ *	NFC_T4T_NDEF_APP(ndef, nfc_t4t_ndef_app_aid,
+ *			 sizeof(nfc_t4t_ndef_app_aid)),
+ *	{ .aid = my_aid, ... },
+ * };
+ *
+ * nfc_t4t_ndef_app_init(&ndef, file, sizeof(file), true, NULL, NULL);
+ * nfc_t4t_apdu_router_init(&router, apps, ARRAY_SIZE(apps), ...);
+ * @endcode
+ *
+ * The router response buffer must hold @ref NFC_T4T_NDEF_APP_MLE bytes and
+ * the status word. UPDATE BINARY commands of up to @ref NFC_T4T_NDEF_APP_MLC
+ * bytes are usually chained by the reader, so feed the router through
+ * @ref nfc_t4t_apdu_reasm_put.
+ */
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+#include <misc/util.h>
+
+#include "nfc_t4t_apdu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Largest READ BINARY response, announced in the capability
+ *  container.
+ */
+#define NFC_T4T_NDEF_APP_MLE 0xFF
+
+/** @brief Largest UPDATE BINARY command data, announced in the capability
+ *  container.
+ */
+#define NFC_T4T_NDEF_APP_MLC 0xFF
+
+/** @brief Size of the capability container file. */
+#define NFC_T4T_NDEF_APP_CC_SIZE 15
+
+/** @brief NFC Forum NDEF application identifier. */
+extern const u8_t nfc_t4t_ndef_app_aid[7];
+
+/** @brief Called when a reader writes to the NLEN field.
+ *
+ * @param context Context given to @ref nfc_t4t_ndef_app_init.
+ * @param nlen Current value of NLEN.
+ */
+typedef void (*nfc_t4t_ndef_app_updated_t)(void *context, u32_t nlen);
+
+/** @brief NDEF application state.
+ *
+ * @note The members are internal and must not be accessed directly.
+ */
+struct nfc_t4t_ndef_app {
+	u8_t *file;
+	size_t size;
+	bool writable;
+	u16_t selected;
+	u8_t cc[NFC_T4T_NDEF_APP_CC_SIZE];
+	nfc_t4t_ndef_app_updated_t updated;
+	void *context;
+};
+
+/** @cond Internal route handlers, used by the macros below. */
+u16_t nfc_t4t_ndef_app_select(void *context, const struct nfc_t4t_apdu *apdu,
+			      struct nfc_t4t_apdu_rsp *rsp);
+u16_t nfc_t4t_ndef_app_read(void *context, const struct nfc_t4t_apdu *apdu,
+			    struct nfc_t4t_apdu_rsp *rsp);
+u16_t nfc_t4t_ndef_app_update(void *context, const struct nfc_t4t_apdu *apdu,
+			      struct nfc_t4t_apdu_rsp *rsp);
+void nfc_t4t_ndef_app_selected(void *context);
+/** @endcond */
+
+/** @brief Define an NDEF application instance and its route table.
+ *
+ * @param _name Name of the instance.
+ */
+#define NFC_T4T_NDEF_APP_DEFINE(_name)                                       \
+	static struct nfc_t4t_ndef_app _name;                                \
+	static const struct nfc_t4t_apdu_route _name##_routes[] = {          \
+		{ .ins = 0xA4, .p1 = 0x00, .p1_mask = 0xFF,                  \
+		  .handler = nfc_t4t_ndef_app_select, .context = &_name },    \
+		NFC_T4T_APDU_ROUTE_INS(0xB0, nfc_t4t_ndef_app_read, &_name),  \
+		NFC_T4T_APDU_ROUTE_INS(0xD6, nfc_t4t_ndef_app_update, &_name),\
+	}
+
+/** @brief Router application entry of an NDEF application instance.
+ *
+ * @param _name Name of the instance.
+ * @param _aid Application identifier, usually
+ *	       @ref nfc_t4t_ndef_app_aid.
+ * @param _aid_length Length of the application identifier.
+ */
+#define NFC_T4T_NDEF_APP(_name, _aid, _aid_length)                            \
+	{ .aid = (_aid), .aid_length = (_aid_length),                         \
+	  .routes = _name##_routes, .route_count = ARRAY_SIZE(_name##_routes),\
+	  .on_select = nfc_t4t_ndef_app_selected, .select_context = &_name }
+
+/** @brief Initialize an NDEF application instance.
+ *
+ * @param app Instance defined with @ref NFC_T4T_NDEF_APP_DEFINE.
+ * @param file NDEF file, NLEN field included.
+ * @param size Size of the NDEF file.
+ * @param writable True to accept UPDATE BINARY.
+ * @param updated Called when a reader writes to NLEN, can be NULL.
+ * @param context Context passed to @p updated.
+ *
+ * @retval 0 Success.
+ * @retval -EINVAL Invalid argument (e.g. NULL pointer or size).
+ */
+int nfc_t4t_ndef_app_init(struct nfc_t4t_ndef_app *app, u8_t *file,
+			  size_t size, bool writable,
+			  nfc_t4t_ndef_app_updated_t updated, void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+#endif /* NFC_T4T_NDEF_APP_H__ */
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <kernel.h>
+
+#include <ocrypto_aes_ctr.h>
+#include <ocrypto_ecdh_p256.h>
+
+#include <nfc_ble_oob.h>
+
+#define AES_BLOCK_SIZE 16
+#define CMAC_RB        0x87
+
+/* Private keys outside the curve order are rejected, retry a few times. */
+#define KEY_ATTEMPTS   4
+
+/* Connection Handover 1.3. */
+#define HS_VERSION     0x13
+
+/* AD types of the LE OOB record. */
+#define AD_LE_ADDR       0x1B
+#define AD_LE_ROLE       0x1C
+#define AD_LE_SC_CONFIRM 0x22
+#define AD_LE_SC_RANDOM  0x23
+
+/* Length and type bytes of each AD structure, then the address and its
+ * type, the role, the confirmation value and the random value.
+ */
+#define LE_OOB_PAYLOAD_SIZE (4 * 2 + 7 + 1 + 16 + 16)
+
+static const u8_t hs_type[] = {'H', 's'};
+static const u8_t le_oob_type[] = {
+	'a', 'p', 'p', 'l', 'i', 'c', 'a', 't', 'i', 'o', 'n', '/',
+	'v', 'n', 'd', '.', 'b', 'l', 'u', 'e', 't', 'o', 'o', 't', 'h', '.',
+	'l', 'e', '.', 'o', 'o', 'b'
+};
+static const u8_t carrier_id[] = {'0'};
+
+/* Version, then a message of one Alternative Carrier record: carrier
+ * active, carrier data reference "0", no auxiliary data.
+ */
+static const u8_t hs_payload[] = {
+	HS_VERSION,
+	0xD1, 0x02, 0x04, 'a', 'c',
+	0x01, 0x01, '0', 0x00,
+};
+
+struct oob_slot {
+	struct nfc_ble_oob_sc sc;
+	u8_t msg[NFC_BLE_OOB_MSG_MAX_SIZE - NFC_NDEF_MSG_NLEN_SIZE];
+	u32_t msg_length;
+};
+
+static struct nfc_ble_oob_config oob_config;
+static struct oob_slot slots[2];
+static struct oob_slot *current;
+
+static void refresh_work_handler(struct k_work *work);
+static K_WORK_DEFINE(refresh_work, refresh_work_handler);
+
+/* nrf_oberon has no raw block cipher. The first CTR key stream block is
+ * the encrypted initial counter.
+ */
+static void aes_encrypt(const u8_t *key, const u8_t *in, u8_t *out)
+{
+	static const u8_t zero[AES_BLOCK_SIZE];
+	ocrypto_aes_ctr_ctx ctx;
+
+	ocrypto_aes_ctr_init(&ctx, key, AES_BLOCK_SIZE, in);
+	ocrypto_aes_ctr_encrypt(&ctx, out, zero, AES_BLOCK_SIZE);
+}
+
+static void cmac_subkey_next(u8_t *k)
+{
+	u8_t msb = k[0] & 0x80;
+
+	for (size_t i = 0; i < AES_BLOCK_SIZE - 1; i++) {
+		k[i] = (k[i] << 1) | (k[i + 1] >> 7);
+	}
+	k[AES_BLOCK_SIZE - 1] <<= 1;
+
+	if (msb) {
+		k[AES_BLOCK_SIZE - 1] ^= CMAC_RB;
+	}
+}
+
+/* AES-CMAC (RFC 4493) of a message of at least one byte. */
+static void aes_cmac(const u8_t *key, const u8_t *msg, size_t length,
+		     u8_t *mac)
+{
+	static const u8_t zero[AES_BLOCK_SIZE];
+	size_t blocks = (length + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+	size_t last = length - (blocks - 1) * AES_BLOCK_SIZE;
+	u8_t subkey[AES_BLOCK_SIZE];
+	u8_t block[AES_BLOCK_SIZE];
+
+	aes_encrypt(key, zero, subkey);
+	cmac_subkey_next(subkey);
+	if (last < AES_BLOCK_SIZE) {
+		cmac_subkey_next(subkey);
+	}
+
+	memset(mac, 0, AES_BLOCK_SIZE);
+	for (size_t i = 0; i < blocks - 1; i++) {
+		for (size_t j = 0; j < AES_BLOCK_SIZE; j++) {
+			block[j] = mac[j] ^ msg[i * AES_BLOCK_SIZE + j];
+		}
+		aes_encrypt(key, block, mac);
+	}
+
+	memset(block, 0, sizeof(block));
+	memcpy(block, &msg[(blocks - 1) * AES_BLOCK_SIZE], last);
+	if (last < AES_BLOCK_SIZE) {
+		block[last] = 0x80;
+	}
+	for (size_t j = 0; j < AES_BLOCK_SIZE; j++) {
+		block[j] ^= mac[j] ^ subkey[j];
+	}
+	aes_encrypt(key, block, mac);
+}
+
+/* f4(U, V, X, Z) = AES-CMAC_X(U || V || Z), with big-endian values. */
+static void f4(const u8_t *u, const u8_t *v, const u8_t *x, u8_t z,
+	       u8_t *out)
+{
+	u8_t m[32 + 32 + 1];
+
+	memcpy(m, u, 32);
+	memcpy(&m[32], v, 32);
+	m[64] = z;
+
+	aes_cmac(x, m, sizeof(m), out);
+}
+
+static void swap_copy(u8_t *dst, const u8_t *src, size_t length)
+{
+	for (size_t i = 0; i < length; i++) {
+		dst[i] = src[length - 1 - i];
+	}
+}
+
+static int sc_compute(struct nfc_ble_oob_sc *sc)
+{
+	u8_t r[AES_BLOCK_SIZE];
+	u8_t c[AES_BLOCK_SIZE];
+	int attempt;
+	int err;
+
+	for (attempt = 0; attempt < KEY_ATTEMPTS; attempt++) {
+		err = oob_config.rand(sc->sk, sizeof(sc->sk));
+		if (err) {
+			return err;
+		}
+
+		if (!ocrypto_ecdh_p256_public_key(sc->pk, sc->sk)) {
+			break;
+		}
+	}
+	if (attempt == KEY_ATTEMPTS) {
+		return -EIO;
+	}
+
+	err = oob_config.rand(r, sizeof(r));
+	if (err) {
+		return err;
+	}
+
+	f4(sc->pk, sc->pk, r, 0, c);
+
+	swap_copy(sc->r, r, sizeof(r));
+	swap_copy(sc->c, c, sizeof(c));
+
+	return 0;
+}
+
+static int msg_encode(struct oob_slot *slot)
+{
+	u8_t payload[LE_OOB_PAYLOAD_SIZE];
+	u8_t *p = payload;
+	const struct nfc_ndef_record_desc hs_record = {
+		.tnf = NFC_NDEF_TNF_WELL_KNOWN,
+		.type = hs_type,
+		.type_length = sizeof(hs_type),
+		.payload = hs_payload,
+		.payload_length = sizeof(hs_payload),
+	};
+	const struct nfc_ndef_record_desc le_oob_record = {
+		.tnf = NFC_NDEF_TNF_MEDIA_TYPE,
+		.type = le_oob_type,
+		.type_length = sizeof(le_oob_type),
+		.id = carrier_id,
+		.id_length = sizeof(carrier_id),
+		.payload = payload,
+		.payload_length = sizeof(payload),
+	};
+	const struct nfc_ndef_record_desc *const records[] = {
+		&hs_record,
+		&le_oob_record,
+	};
+	const struct nfc_ndef_msg_desc msg = {
+		.records = records,
+		.record_count = ARRAY_SIZE(records),
+	};
+
+	*p++ = 1 + sizeof(oob_config.addr) + 1;
+	*p++ = AD_LE_ADDR;
+	memcpy(p, oob_config.addr, sizeof(oob_config.addr));
+	p += sizeof(oob_config.addr);
+	*p++ = oob_config.addr_type;
+
+	*p++ = 1 + 1;
+	*p++ = AD_LE_ROLE;
+	*p++ = oob_config.role;
+
+	*p++ = 1 + sizeof(slot->sc.c);
+	*p++ = AD_LE_SC_CONFIRM;
+	memcpy(p, slot->sc.c, sizeof(slot->sc.c));
+	p += sizeof(slot->sc.c);
+
+	*p++ = 1 + sizeof(slot->sc.r);
+	*p++ = AD_LE_SC_RANDOM;
+	memcpy(p, slot->sc.r, sizeof(slot->sc.r));
+
+	slot->msg_length = sizeof(slot->msg);
+
+	return nfc_ndef_msg_encode(&msg, NFC_NDEF_MSG_FORMAT_RAW, slot->msg,
+				   &slot->msg_length);
+}
+
+static int slot_compute(struct oob_slot *slot)
+{
+	int err;
+
+	err = sc_compute(&slot->sc);
+	if (err) {
+		return err;
+	}
+
+	return msg_encode(slot);
+}
+
+static void refresh_work_handler(struct k_work *work)
+{
+	struct oob_slot *next;
+	unsigned int key;
+
+	ARG_UNUSED(work);
+
+	key = irq_lock();
+	next = (current == &slots[0]) ? &slots[1] : &slots[0];
+	irq_unlock(key);
+
+	/* On failure, the current values stay in use. */
+	if (slot_compute(next)) {
+		return;
+	}
+
+	key = irq_lock();
+	current = next;
+	irq_unlock(key);
+}
+
+int nfc_ble_oob_init(const struct nfc_ble_oob_config *config)
+{
+	int err;
+
+	if (!config || !config->rand) {
+		return -EINVAL;
+	}
+
+	oob_config = *config;
+	current = NULL;
+
+	err = slot_compute(&slots[0]);
+	if (err) {
+		return err;
+	}
+
+	current = &slots[0];
+
+	return 0;
+}
+
+void nfc_ble_oob_refresh(void)
+{
+	k_work_submit(&refresh_work);
+}
+
+int nfc_ble_oob_msg_get(enum nfc_ndef_msg_format format, u8_t *buff,
+			u32_t *len)
+{
+	u32_t header = (format == NFC_NDEF_MSG_FORMAT_T4T) ?
+		       NFC_NDEF_MSG_NLEN_SIZE : 0;
+	unsigned int key;
+	int err = 0;
+
+	if (!buff || !len) {
+		return -EINVAL;
+	}
+
+	key = irq_lock();
+
+	if (!current) {
+		err = -EINVAL;
+	} else if (*len < header + current->msg_length) {
+		err = -ENOMEM;
+	} else {
+		if (header) {
+			buff[0] = (u8_t)(current->msg_length >> 8);
+			buff[1] = (u8_t)current->msg_length;
+		}
+		memcpy(&buff[header], current->msg, current->msg_length);
+		*len = header + current->msg_length;
+	}
+
+	irq_unlock(key);
+
+	return err;
+}
+
+int nfc_ble_oob_sc_get(struct nfc_ble_oob_sc *sc)
+{
+	unsigned int key;
+	int err = 0;
+
+	key = irq_lock();
+
+	if (current) {
+		*sc = current->sc;
+	} else {
+		err = -EINVAL;
+	}
+
+	irq_unlock(key);
+
+	return err;
+}
@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <kernel.h>
+
+#include <nfc_evq.h>
+
+#define EVQ_SIZE  CONFIG_NFC_EVQ_SIZE
+#define POOL_SIZE CONFIG_NFC_EVQ_DATA_SIZE
+
+BUILD_ASSERT_MSG((EVQ_SIZE & (EVQ_SIZE - 1)) == 0,
+		 "Event queue size must be a power of two");
+BUILD_ASSERT_MSG((POOL_SIZE & (POOL_SIZE - 1)) == 0,
+		 "Event data pool size must be a power of two");
+
+/* Slots that T4T command fragments leave free, so that the FIELD_OFF and
+ * FIELD_ON of the next tap still fit in the ring after a burst of data.
+ */
+#define STATE_RESERVED 2
+
+BUILD_ASSERT_MSG(EVQ_SIZE > STATE_RESERVED,
+		 "Event queue size must leave room for command fragments");
+
+/* Events of either library, command fragments excluded. */
+#define STATE_EVENT_COUNT NFC_T4T_EVENT_DATA_IND
+
+enum evq_lib {
+	EVQ_LIB_T2T,
+	EVQ_LIB_T4T,
+	EVQ_LIB_COUNT,
+};
+
+struct evq_entry {
+	const u8_t *data;
+	size_t data_length;
+	u32_t flags;
+	u32_t cycles;
+	/* Pool position after the copied data, if any. */
+	u32_t pool_end;
+	/* Order of the last coalesced event, for entries of the overflow. */
+	u32_t seq;
+	bool copied;
+	u8_t lib;
+	u8_t event;
+};
+
+static struct evq_entry entries[EVQ_SIZE];
+static u32_t evq_head;
+static u32_t evq_tail;
+
+/* Copied chained fragments. Positions count bytes from the start and wrap
+ * with the u32_t counters. A fragment never wraps around the pool end.
+ */
+static u8_t pool[POOL_SIZE];
+static u32_t pool_head;
+static u32_t pool_tail;
+
+/* State events that found the ring full. They are coalesced until the
+ * worker has drained the ring, and delivered after the ring entries: the
+ * first field event of each library and the last one if it differs from
+ * the first, and every other event once with its latest data. The other
+ * events are delivered in the tap in which they last came: before the
+ * first field event, after the last one if it is FIELD_ON, or else after
+ * the first one. Entries with event 0, which is NONE for both libraries,
+ * are unused.
+ */
+struct evq_overflow {
+	struct evq_entry field_first[EVQ_LIB_COUNT];
+	struct evq_entry field_last[EVQ_LIB_COUNT];
+	struct evq_entry other[EVQ_LIB_COUNT][STATE_EVENT_COUNT];
+	bool pending;
+};
+
+static struct evq_overflow overflow;
+static u32_t overflow_seq;
+
+static bool chain_dropped;
+static bool fragment_dropped;
+static struct nfc_evq_stats stats;
+
+static nfc_t2t_callback_t t2t_callback;
+static void *t2t_context;
+static nfc_t4t_callback_t t4t_callback;
+static void *t4t_context;
+
+static K_SEM_DEFINE(evq_sem, 0, 1);
+
+static void dispatch(const struct evq_entry *entry)
+{
+	switch (entry->lib) {
+	case EVQ_LIB_T2T:
+		if (t2t_callback) {
+			t2t_callback(t2t_context, entry->event, entry->data,
+				     entry->data_length);
+		}
+		break;
+
+	case EVQ_LIB_T4T:
+		if (t4t_callback) {
+			t4t_callback(t4t_context, entry->event, entry->data,
+				     entry->data_length, entry->flags);
+		}
+		break;
+	}
+}
+
+static void delay_update(const struct evq_entry *entry)
+{
+	u32_t delay_us =
+		(u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(k_cycle_get_32() -
+						    entry->cycles) /
+			NSEC_PER_USEC);
+
+	if (delay_us > stats.max_delay_us) {
+		stats.max_delay_us = delay_us;
+	}
+}
+
+static void overflow_dispatch(const struct evq_entry *entry)
+{
+	if (entry->event) {
+		delay_update(entry);
+		dispatch(entry);
+	}
+}
+
+static bool seq_before(u32_t a, u32_t b)
+{
+	return (s32_t)(a - b) < 0;
+}
+
+static void overflow_lib_deliver(const struct evq_overflow *taken,
+				 size_t lib)
+{
+	const struct evq_entry *first = &taken->field_first[lib];
+	const struct evq_entry *last = &taken->field_last[lib];
+	const struct evq_entry *others[STATE_EVENT_COUNT];
+	size_t count = 0;
+	size_t i = 0;
+
+	if (last->event == first->event) {
+		last = NULL;
+	}
+
+	/* Sort the other events by the order in which they last came. */
+	for (size_t event = 0; event < STATE_EVENT_COUNT; event++) {
+		const struct evq_entry *entry = &taken->other[lib][event];
+		size_t j;
+
+		if (!entry->event) {
+			continue;
+		}
+
+		for (j = count; j && seq_before(entry->seq, others[j - 1]->seq);
+		     j--) {
+			others[j] = others[j - 1];
+		}
+		others[j] = entry;
+		count++;
+	}
+
+	/* Events of the tap that the first field event ended. */
+	while (first->event && i < count &&
+	       seq_before(others[i]->seq, first->seq)) {
+		overflow_dispatch(others[i++]);
+	}
+
+	overflow_dispatch(first);
+
+	/* The taps in between are gone, so their events go to the tap that
+	 * is still going on, if any.
+	 */
+	if (last && last->event == NFC_T4T_EVENT_FIELD_ON) {
+		overflow_dispatch(last);
+		last = NULL;
+	}
+
+	while (i < count) {
+		overflow_dispatch(others[i++]);
+	}
+
+	if (last) {
+		overflow_dispatch(last);
+	}
+}
+
+/* Delivers the coalesced events once the ring is empty. Returns false if
+ * there were none.
+ */
+static bool overflow_deliver(void)
+{
+	static struct evq_overflow taken;
+	unsigned int key = irq_lock();
+
+	if (!overflow.pending || evq_tail != evq_head) {
+		irq_unlock(key);
+		return overflow.pending;
+	}
+
+	/* Events that come from now on go to the ring again, after the
+	 * ones taken here.
+	 */
+	taken = overflow;
+	memset(&overflow, 0, sizeof(overflow));
+
+	for (size_t lib = 0; lib < EVQ_LIB_COUNT; lib++) {
+		/* A field event back to the first one cancels out. */
+		if (taken.field_last[lib].event &&
+		    taken.field_last[lib].event ==
+		    taken.field_first[lib].event) {
+			stats.coalesced++;
+		}
+	}
+	irq_unlock(key);
+
+	for (size_t lib = 0; lib < EVQ_LIB_COUNT; lib++) {
+		overflow_lib_deliver(&taken, lib);
+	}
+
+	return true;
+}
+
+static void evq_thread(void)
+{
+	for (;;) {
+		k_sem_take(&evq_sem, K_FOREVER);
+
+		do {
+			while (evq_tail != evq_head) {
+				const struct evq_entry *entry =
+					&entries[evq_tail & (EVQ_SIZE - 1)];
+
+				delay_update(entry);
+				dispatch(entry);
+
+				compiler_barrier();
+				if (entry->copied) {
+					pool_tail = entry->pool_end;
+				}
+				evq_tail++;
+			}
+		} while (overflow_deliver());
+	}
+}
+
+K_THREAD_DEFINE(nfc_evq_thread, CONFIG_NFC_EVQ_STACK_SIZE, evq_thread,
+		NULL, NULL, NULL, CONFIG_NFC_EVQ_THREAD_PRIO, 0, K_NO_WAIT);
+
+/* Reserves a contiguous pool area. Called from the NFCT interrupt only. */
+static u8_t *pool_alloc(size_t length, u32_t *end)
+{
+	u32_t pos = pool_head;
+	u32_t offset = pos & (POOL_SIZE - 1);
+
+	if (offset + length > POOL_SIZE) {
+		pos += POOL_SIZE - offset;
+		offset = 0;
+	}
+
+	if (pos + length - pool_tail > POOL_SIZE) {
+		return NULL;
+	}
+
+	*end = pos + length;
+
+	return &pool[offset];
+}
+
+static bool field_event(u8_t event)
+{
+	BUILD_ASSERT_MSG((u8_t)NFC_T2T_EVENT_FIELD_ON ==
+			 (u8_t)NFC_T4T_EVENT_FIELD_ON &&
+			 (u8_t)NFC_T2T_EVENT_FIELD_OFF ==
+			 (u8_t)NFC_T4T_EVENT_FIELD_OFF,
+			 "Field events must have the same values in both libraries");
+
+	return (event == NFC_T4T_EVENT_FIELD_ON) ||
+	       (event == NFC_T4T_EVENT_FIELD_OFF);
+}
+
+/* Coalesces a state event that does not fit in the ring. Called from the
+ * NFCT interrupt only.
+ */
+static void overflow_put(enum evq_lib lib, u8_t event, const u8_t *data,
+			 size_t data_length, u32_t flags)
+{
+	struct evq_entry *entry;
+
+	if (!field_event(event)) {
+		entry = &overflow.other[lib][event];
+	} else if (!overflow.field_first[lib].event) {
+		entry = &overflow.field_first[lib];
+	} else {
+		entry = &overflow.field_last[lib];
+	}
+
+	if (entry->event) {
+		stats.coalesced++;
+	}
+
+	/* The delay is measured from the first coalesced event. */
+	if (!entry->event) {
+		entry->cycles = k_cycle_get_32();
+	}
+	entry->data = data;
+	entry->data_length = data_length;
+	entry->flags = flags;
+	entry->copied = false;
+	entry->lib = lib;
+	entry->event = event;
+	entry->seq = overflow_seq++;
+
+	overflow.pending = true;
+
+	k_sem_give(&evq_sem);
+}
+
+/* Called from the NFCT interrupt only. */
+static void evq_put(enum evq_lib lib, u8_t event, const u8_t *data,
+		    size_t data_length, u32_t flags)
+{
+	bool fragment = (lib == EVQ_LIB_T4T) &&
+			(event == NFC_T4T_EVENT_DATA_IND);
+	bool more = fragment && (flags & NFC_T4T_DI_FLAG_MORE);
+	struct evq_entry *entry;
+	u32_t depth = evq_head - evq_tail;
+	u8_t *copy = NULL;
+	u32_t pool_end = 0;
+
+	if (fragment && chain_dropped) {
+		chain_dropped = more;
+		stats.dropped++;
+		return;
+	}
+
+	if (fragment && fragment_dropped) {
+		flags |= NFC_EVQ_DI_FLAG_DROPPED;
+	}
+
+	if (more && data_length) {
+		copy = pool_alloc(data_length, &pool_end);
+	}
+
+	/* Events coming while coalesced ones are pending go after them. */
+	if (!fragment && (overflow.pending || depth >= EVQ_SIZE)) {
+		overflow_put(lib, event, data, data_length, flags);
+		return;
+	}
+
+	if (fragment && (overflow.pending ||
+			 depth >= EVQ_SIZE - STATE_RESERVED ||
+			 (more && data_length && !copy))) {
+		chain_dropped = more;
+		fragment_dropped = true;
+		stats.dropped++;
+		return;
+	}
+
+	if (fragment) {
+		fragment_dropped = false;
+	}
+
+	if (copy) {
+		memcpy(copy, data, data_length);
+		data = copy;
+		pool_head = pool_end;
+		stats.copied++;
+	}
+
+	entry = &entries[evq_head & (EVQ_SIZE - 1)];
+	entry->data = data;
+	entry->data_length = data_length;
+	entry->flags = flags;
+	entry->cycles = k_cycle_get_32();
+	entry->pool_end = pool_end;
+	entry->copied = (copy != NULL);
+	entry->lib = lib;
+	entry->event = event;
+	compiler_barrier();
+	evq_head++;
+
+	stats.events++;
+	if (depth + 1 > stats.max_depth) {
+		stats.max_depth = depth + 1;
+	}
+
+	k_sem_give(&evq_sem);
+}
+
+#if defined(CONFIG_NFC_T2T_LIB_ENABLED)
+static void t2t_handler(void *context, enum nfc_t2t_event event,
+			const u8_t *data, size_t data_length)
+{
+	ARG_UNUSED(context);
+
+	evq_put(EVQ_LIB_T2T, event, data, data_length, 0);
+}
+#endif
+
+#if defined(CONFIG_NFC_T4T_LIB_ENABLED)
+static void t4t_handler(void *context, enum nfc_t4t_event event,
+			const u8_t *data, size_t data_length, u32_t flags)
+{
+	ARG_UNUSED(context);
+
+	if (event == NFC_T4T_EVENT_FIELD_OFF) {
+		chain_dropped = false;
+	}
+
+	evq_put(EVQ_LIB_T4T, event, data, data_length, flags);
+}
+#endif
+
+int nfc_evq_t2t_setup(nfc_t2t_callback_t callback, void *context)
+{
+#if defined(CONFIG_NFC_T2T_LIB_ENABLED)
+	if (!callback) {
+		return -EINVAL;
+	}
+
+	t2t_callback = callback;
+	t2t_context = context;
+
+	return nfc_t2t_setup(t2t_handler, NULL);
+#else
+	ARG_UNUSED(callback);
+	ARG_UNUSED(context);
+
+	return -ENOTSUP;
+#endif
+}
+
+int nfc_evq_t4t_setup(nfc_t4t_callback_t callback, void *context)
+{
+#if defined(CONFIG_NFC_T4T_LIB_ENABLED)
+	if (!callback) {
+		return -EINVAL;
+	}
+
+	t4t_callback = callback;
+	t4t_context = context;
+
+	return nfc_t4t_setup(t4t_handler, NULL);
+#else
+	ARG_UNUSED(callback);
+	ARG_UNUSED(context);
+
+	return -ENOTSUP;
+#endif
+}
+
+void nfc_evq_stats_get(struct nfc_evq_stats *out)
+{
+	unsigned int key = irq_lock();
+
+	*out = stats;
+	irq_unlock(key);
+}
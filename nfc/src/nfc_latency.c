@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <kernel.h>
+
+#include <nfc_latency.h>
+
+static struct nfc_latency_hist hists[NFC_LATENCY_SEGMENT_COUNT];
+
+/* taps[cur] records the current or next tap, the other one holds the last
+ * complete tap. They swap roles at FIELD_LOST, and the buffer of the next
+ * tap is cleared from the work queue.
+ */
+static struct nfc_latency_tap taps[2];
+static u8_t cur;
+static bool cur_clean = true;
+static bool clearing;
+static bool tap_recorded;
+
+static bool in_tap;
+static bool first_seen;
+static u32_t responses;
+static u32_t field_cycles;
+static u32_t ref_cycles;
+static u32_t last_rsp_cycles;
+
+static void clear_work_handler(struct k_work *work);
+static K_WORK_DEFINE(clear_work, clear_work_handler);
+
+static u32_t elapsed_us(u32_t from, u32_t to)
+{
+	return (u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(to - from) /
+		       NSEC_PER_USEC);
+}
+
+static u32_t bucket_get(u32_t us)
+{
+	u32_t bucket = 0;
+
+	while (us > 1 && bucket < NFC_LATENCY_HIST_BUCKETS - 1) {
+		us >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+static void hist_add(struct nfc_latency_hist *hist, u32_t us)
+{
+	if (hist->count == 0 || us < hist->min_us) {
+		hist->min_us = us;
+	}
+	if (us > hist->max_us) {
+		hist->max_us = us;
+	}
+
+	hist->count++;
+	hist->sum_us += us;
+	hist->buckets[bucket_get(us)]++;
+}
+
+static void sample_add(enum nfc_latency_segment segment, u32_t us)
+{
+	hist_add(&hists[segment], us);
+
+	if (tap_recorded) {
+		hist_add(&taps[cur].hists[segment], us);
+		taps[cur].us[segment] = us;
+	}
+}
+
+static void first_seen_check(u32_t now)
+{
+	if (!first_seen) {
+		first_seen = true;
+		sample_add(NFC_LATENCY_ACTIVATION, elapsed_us(ref_cycles, now));
+	}
+}
+
+void nfc_latency_mark(enum nfc_latency_mark mark)
+{
+	u32_t now = k_cycle_get_32();
+	unsigned int key = irq_lock();
+
+	switch (mark) {
+	case NFC_LATENCY_MARK_FIELD_DETECTED:
+		/* The work queue did not get to clear the buffer since the
+		 * last tap. If it is clearing it right now, the tap is only
+		 * collected into the histograms over all taps.
+		 */
+		if (!cur_clean && !clearing) {
+			memset(&taps[cur], 0, sizeof(taps[cur]));
+			cur_clean = true;
+		}
+		tap_recorded = cur_clean;
+		if (tap_recorded) {
+			cur_clean = false;
+		}
+		in_tap = true;
+		first_seen = false;
+		responses = 0;
+		field_cycles = now;
+		ref_cycles = now;
+		break;
+
+	case NFC_LATENCY_MARK_ACTIVATED:
+		if (in_tap) {
+			sample_add(NFC_LATENCY_CLOCK_START,
+				   elapsed_us(field_cycles, now));
+			ref_cycles = now;
+		}
+		break;
+
+	case NFC_LATENCY_MARK_COMMAND:
+		if (in_tap) {
+			first_seen_check(now);
+			ref_cycles = now;
+		}
+		break;
+
+	case NFC_LATENCY_MARK_RESPONSE:
+		if (in_tap) {
+			first_seen_check(now);
+			sample_add(NFC_LATENCY_RESPONSE,
+				   elapsed_us(ref_cycles, now));
+			responses++;
+			ref_cycles = now;
+			last_rsp_cycles = now;
+		}
+		break;
+
+	case NFC_LATENCY_MARK_FIELD_LOST:
+		if (in_tap) {
+			if (responses) {
+				sample_add(NFC_LATENCY_TAP,
+					   elapsed_us(field_cycles,
+						      last_rsp_cycles));
+			}
+			if (tap_recorded) {
+				taps[cur].responses = responses;
+				cur ^= 1;
+				k_work_submit(&clear_work);
+			}
+			in_tap = false;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	irq_unlock(key);
+}
+
+static void clear_work_handler(struct k_work *work)
+{
+	unsigned int key;
+	u8_t idx;
+
+	ARG_UNUSED(work);
+
+	key = irq_lock();
+	if (cur_clean || in_tap) {
+		irq_unlock(key);
+		return;
+	}
+	clearing = true;
+	idx = cur;
+	irq_unlock(key);
+
+	/* Not locked: the interrupt does not write to the buffer while
+	 * clearing is set.
+	 */
+	memset(&taps[idx], 0, sizeof(taps[idx]));
+
+	key = irq_lock();
+	clearing = false;
+	cur_clean = true;
+	irq_unlock(key);
+}
+
+void nfc_latency_hist_get(enum nfc_latency_segment segment,
+			  struct nfc_latency_hist *hist)
+{
+	unsigned int key;
+
+	if (segment >= NFC_LATENCY_SEGMENT_COUNT) {
+		memset(hist, 0, sizeof(*hist));
+		return;
+	}
+
+	key = irq_lock();
+	*hist = hists[segment];
+	irq_unlock(key);
+}
+
+void nfc_latency_tap_get(struct nfc_latency_tap *tap)
+{
+	unsigned int key = irq_lock();
+
+	*tap = taps[cur ^ 1];
+	irq_unlock(key);
+}
+
+void nfc_latency_reset(void)
+{
+	unsigned int key = irq_lock();
+
+	memset(hists, 0, sizeof(hists));
+	memset(&taps[cur ^ 1], 0, sizeof(taps[cur ^ 1]));
+	irq_unlock(key);
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <kernel.h>
+
+#include <nfc_ndef_dyn.h>
+#if defined(CONFIG_NFC_T2T_DBUF)
+#include <nfc_t2t_dbuf.h>
+#endif
+
+enum shadow_state {
+	SHADOW_EMPTY,
+	SHADOW_GENERATING,
+	/* Generated, waiting for the field to be lost to be installed. */
+	SHADOW_READY,
+	/* Copied into the T4T file, not served yet. */
+	SHADOW_INSTALLED,
+};
+
+static enum nfc_ndef_dyn_mode dyn_mode;
+static nfc_ndef_dyn_generator_t generator;
+static void *generator_context;
+static struct nfc_ndef_dyn_stats stats;
+
+static u8_t *t4t_file;
+static u8_t *t4t_shadow;
+static size_t t4t_size;
+static size_t shadow_length;
+static enum shadow_state shadow_state;
+static bool field_on;
+
+static void precompute_work_handler(struct k_work *work);
+static K_WORK_DEFINE(precompute_work, precompute_work_handler);
+
+static int generate(u8_t *buf, size_t size, size_t *length)
+{
+	int err;
+
+	err = generator(generator_context, buf, size, length);
+	if (!err && *length > size) {
+		err = -ENOMEM;
+	}
+	if (err) {
+		stats.errors++;
+	}
+
+	return err;
+}
+
+#if defined(CONFIG_NFC_T4T_LIB_ENABLED)
+static void t4t_precompute(void)
+{
+	unsigned int key;
+	size_t length;
+	int err;
+
+	key = irq_lock();
+	if (shadow_state == SHADOW_EMPTY) {
+		shadow_state = SHADOW_GENERATING;
+		irq_unlock(key);
+
+		err = generate(t4t_shadow, t4t_size, &length);
+
+		key = irq_lock();
+		if (err) {
+			shadow_state = SHADOW_EMPTY;
+			irq_unlock(key);
+			return;
+		}
+		shadow_length = length;
+		shadow_state = SHADOW_READY;
+	}
+
+	/* Install the content only while no reader can read the file. If a
+	 * field is present, its FIELD_OFF submits the work again.
+	 */
+	if (shadow_state == SHADOW_READY && !field_on) {
+		memcpy(t4t_file, t4t_shadow, shadow_length);
+		shadow_state = SHADOW_INSTALLED;
+	}
+	irq_unlock(key);
+}
+#endif
+
+#if defined(CONFIG_NFC_T2T_DBUF)
+static void t2t_precompute(void)
+{
+	size_t size;
+	size_t length;
+	u8_t *buf;
+	int err;
+
+	/* While a swap is in progress, the double buffer refuses the staging
+	 * buffer and the commit, and submits the work again when it finishes.
+	 */
+	buf = nfc_t2t_dbuf_staging_get(&size);
+	if (!buf) {
+		return;
+	}
+
+	/* If the generator fails, the withdrawn payload stays pending and is
+	 * not swapped in, so the next tap counts as stale. The next FIELD_OFF
+	 * generates again.
+	 */
+	if (generate(buf, size, &length)) {
+		return;
+	}
+
+	err = nfc_t2t_dbuf_commit(length);
+	if (err && err != -EBUSY) {
+		stats.errors++;
+	}
+}
+#endif
+
+static void precompute_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+#if defined(CONFIG_NFC_T4T_LIB_ENABLED)
+	if (t4t_file) {
+		t4t_precompute();
+		return;
+	}
+#endif
+
+#if defined(CONFIG_NFC_T2T_DBUF)
+	t2t_precompute();
+#endif
+}
+
+#if defined(CONFIG_NFC_T4T_LIB_ENABLED)
+int nfc_ndef_dyn_t4t_init(enum nfc_ndef_dyn_mode mode, u8_t *file,
+			  u8_t *shadow, size_t size,
+			  nfc_ndef_dyn_generator_t gen, void *context)
+{
+	size_t length;
+	int err;
+
+	if (!file || !size || !gen ||
+	    (mode == NFC_NDEF_DYN_PRECOMPUTE && !shadow)) {
+		return -EINVAL;
+	}
+
+	dyn_mode = mode;
+	generator = gen;
+	generator_context = context;
+	t4t_file = file;
+	t4t_shadow = shadow;
+	t4t_size = size;
+	shadow_state = SHADOW_EMPTY;
+	field_on = false;
+	memset(&stats, 0, sizeof(stats));
+
+	err = generate(file, size, &length);
+	if (err) {
+		return err;
+	}
+
+	err = nfc_t4t_ndef_rwpayload_set(file, size);
+	if (err) {
+		return err;
+	}
+
+	if (mode == NFC_NDEF_DYN_PRECOMPUTE) {
+		k_work_submit(&precompute_work);
+	}
+
+	return 0;
+}
+
+static void t4t_field_on(void)
+{
+	size_t length;
+
+	stats.taps++;
+	field_on = true;
+
+	if (dyn_mode == NFC_NDEF_DYN_PRECOMPUTE) {
+		/* The work queue already copied the content into the file. */
+		if (shadow_state == SHADOW_INSTALLED) {
+			shadow_state = SHADOW_EMPTY;
+			stats.precomputed++;
+			return;
+		}
+
+		/* The generator is running in the work queue and cannot be
+		 * called again from here.
+		 */
+		if (shadow_state == SHADOW_GENERATING) {
+			stats.stale++;
+			return;
+		}
+	}
+
+	if (!generate(t4t_file, t4t_size, &length)) {
+		stats.inline_gen++;
+	} else {
+		stats.stale++;
+	}
+}
+
+void nfc_ndef_dyn_t4t_event_process(enum nfc_t4t_event event)
+{
+	switch (event) {
+	case NFC_T4T_EVENT_FIELD_ON:
+		t4t_field_on();
+		break;
+
+	case NFC_T4T_EVENT_FIELD_OFF:
+		field_on = false;
+		if (dyn_mode == NFC_NDEF_DYN_PRECOMPUTE) {
+			k_work_submit(&precompute_work);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+#endif
+
+#if defined(CONFIG_NFC_T2T_DBUF)
+int nfc_ndef_dyn_t2t_init(nfc_ndef_dyn_generator_t gen, void *context)
+{
+	size_t size;
+	size_t length;
+	u8_t *buf;
+	int err;
+
+	if (!gen) {
+		return -EINVAL;
+	}
+
+	dyn_mode = NFC_NDEF_DYN_PRECOMPUTE;
+	generator = gen;
+	generator_context = context;
+	t4t_file = NULL;
+	memset(&stats, 0, sizeof(stats));
+	nfc_t2t_dbuf_staging_work_set(&precompute_work);
+
+	buf = nfc_t2t_dbuf_staging_get(&size);
+	if (!buf) {
+		return -EBUSY;
+	}
+
+	err = generate(buf, size, &length);
+	if (err) {
+		return err;
+	}
+
+	return nfc_t2t_dbuf_commit(length);
+}
+
+void nfc_ndef_dyn_t2t_event_process(enum nfc_t2t_event event)
+{
+	switch (event) {
+	case NFC_T2T_EVENT_FIELD_ON:
+		stats.taps++;
+		if (nfc_t2t_dbuf_pending()) {
+			stats.stale++;
+		} else {
+			stats.precomputed++;
+		}
+		break;
+
+	case NFC_T2T_EVENT_FIELD_OFF:
+		k_work_submit(&precompute_work);
+		break;
+
+	default:
+		break;
+	}
+
+	nfc_t2t_dbuf_event_process(event);
+}
+#endif
+
+void nfc_ndef_dyn_stats_get(struct nfc_ndef_dyn_stats *out)
+{
+	unsigned int key = irq_lock();
+
+	*out = stats;
+	irq_unlock(key);
+}
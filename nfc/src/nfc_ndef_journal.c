@@ -0,0 +1,510 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <kernel.h>
+#include <flash.h>
+#include <crc16.h>
+
+#include <nfc_ndef_msg.h>
+#include <nfc_ndef_journal.h>
+
+#define PAGE_MAGIC    0x4A46454EU
+#define WRITE_ALIGN   4
+#define RECORD_COMMIT 0x0001
+#define CRC_SEED      0xFFFF
+#define READ_CHUNK    32
+#define ERASED_HALF   0xFFFF
+
+struct page_hdr {
+	u32_t magic;
+	u32_t seq;
+};
+
+struct record_hdr {
+	u16_t offset;
+	u16_t length;
+	u16_t flags;
+	u16_t crc;
+};
+
+BUILD_ASSERT_MSG(sizeof(struct page_hdr) % WRITE_ALIGN == 0,
+		 "Page header must keep records aligned");
+BUILD_ASSERT_MSG(sizeof(struct record_hdr) % WRITE_ALIGN == 0,
+		 "Record header must keep data aligned");
+
+/* Unchanged bytes shorter than a record header are cheaper to rewrite
+ * than to skip.
+ */
+#define MERGE_GAP (sizeof(struct record_hdr) + WRITE_ALIGN)
+
+static struct device *flash_dev;
+static off_t area_offset;
+static size_t area_page_size;
+static u32_t area_page_count;
+static u8_t *ndef_file;
+static u8_t *ndef_shadow;
+static size_t ndef_size;
+
+static u32_t active_page;
+static u32_t active_seq;
+static size_t write_pos;
+static bool compact_pending;
+static struct nfc_ndef_journal_stats stats;
+
+static K_MUTEX_DEFINE(journal_lock);
+
+static void sync_work_handler(struct k_work *work);
+static K_WORK_DEFINE(sync_work, sync_work_handler);
+
+static size_t align_up(size_t length)
+{
+	return (length + WRITE_ALIGN - 1) & ~(size_t)(WRITE_ALIGN - 1);
+}
+
+static size_t record_size(size_t length)
+{
+	return sizeof(struct record_hdr) + align_up(length);
+}
+
+static off_t page_offset(u32_t page)
+{
+	return area_offset + (off_t)page * area_page_size;
+}
+
+static u16_t record_hdr_crc(const struct record_hdr *hdr)
+{
+	return crc16_ccitt(CRC_SEED, (const u8_t *)hdr,
+			   offsetof(struct record_hdr, crc));
+}
+
+/* Appends a record with data taken from the shadow. */
+static int record_write(u16_t offset, u16_t length, u16_t flags)
+{
+	struct record_hdr hdr = {
+		.offset = offset,
+		.length = length,
+		.flags = flags,
+	};
+	const u8_t *data = &ndef_shadow[offset];
+	off_t pos = page_offset(active_page) + write_pos;
+	size_t body = length & ~(WRITE_ALIGN - 1);
+	u8_t tail[WRITE_ALIGN];
+	int err;
+
+	hdr.crc = crc16_ccitt(record_hdr_crc(&hdr), data, length);
+
+	/* The header goes first, so that a torn record fails its CRC instead
+	 * of looking like erased flash that can be written again.
+	 */
+	err = flash_write(flash_dev, pos, &hdr, sizeof(hdr));
+	if (!err && body) {
+		err = flash_write(flash_dev, pos + sizeof(hdr), data, body);
+	}
+	if (!err && body < length) {
+		memset(tail, 0xFF, sizeof(tail));
+		memcpy(tail, &data[body], length - body);
+		err = flash_write(flash_dev, pos + sizeof(hdr) + body, tail,
+				  sizeof(tail));
+	}
+	if (err) {
+		stats.errors++;
+		return err;
+	}
+
+	write_pos += record_size(length);
+	stats.records++;
+	stats.bytes += record_size(length);
+
+	return 0;
+}
+
+/* Writes the whole message as one record to the next page. */
+static int compact(void)
+{
+	u32_t prev_page = active_page;
+	u32_t prev_seq = active_seq;
+	struct page_hdr hdr = {
+		.magic = PAGE_MAGIC,
+		.seq = active_seq + 1,
+	};
+	size_t length = ndef_size;
+	size_t nlen;
+	int err;
+
+	memcpy(ndef_shadow, ndef_file, ndef_size);
+
+	/* Bytes past the message are never read and are not persisted.
+	 * Recovery reads them as zero, so the shadow must hold the same for
+	 * later changes to be compared against it.
+	 */
+	nlen = (ndef_shadow[0] << 8) | ndef_shadow[1];
+	if (nlen < ndef_size - NFC_NDEF_MSG_NLEN_SIZE) {
+		length = nlen + NFC_NDEF_MSG_NLEN_SIZE;
+		memset(&ndef_shadow[length], 0, ndef_size - length);
+	}
+
+	active_page = (active_page + 1) % area_page_count;
+	active_seq = hdr.seq;
+	write_pos = sizeof(hdr);
+
+	err = flash_erase(flash_dev, page_offset(active_page), area_page_size);
+	if (!err) {
+		err = flash_write(flash_dev, page_offset(active_page), &hdr,
+				  sizeof(hdr));
+	}
+	if (err) {
+		stats.errors++;
+	} else {
+		err = record_write(0, length, RECORD_COMMIT);
+	}
+
+	/* Retry the same page next time, the previous one still holds the
+	 * last committed content.
+	 */
+	if (err) {
+		active_page = prev_page;
+		active_seq = prev_seq;
+		compact_pending = true;
+		return err;
+	}
+
+	compact_pending = false;
+	stats.compactions++;
+
+	return 0;
+}
+
+static int range_write(size_t start, size_t end, u16_t flags)
+{
+	size_t length = end - start;
+	int err;
+
+	if (record_size(length) > area_page_size - write_pos) {
+		return -ENOSPC;
+	}
+
+	memcpy(&ndef_shadow[start], &ndef_file[start], length);
+
+	err = record_write(start, length, flags);
+	if (err) {
+		compact_pending = true;
+	}
+
+	return err;
+}
+
+static int changes_write(void)
+{
+	size_t start = 0;
+	size_t end = 0;
+	bool pending = false;
+	int err;
+
+	/* NLEN is written last by readers, so scanning from the start never
+	 * persists a new length with an old message.
+	 */
+	for (size_t i = 0; i < ndef_size; i++) {
+		if (ndef_file[i] == ndef_shadow[i]) {
+			continue;
+		}
+
+		if (pending && i - end < MERGE_GAP) {
+			end = i + 1;
+			continue;
+		}
+
+		if (pending) {
+			err = range_write(start, end, 0);
+			if (err) {
+				return err;
+			}
+		}
+
+		start = i;
+		end = i + 1;
+		pending = true;
+	}
+
+	if (!pending) {
+		return 0;
+	}
+
+	stats.syncs++;
+
+	return range_write(start, end, RECORD_COMMIT);
+}
+
+int nfc_ndef_journal_sync(void)
+{
+	int err;
+
+	k_mutex_lock(&journal_lock, K_FOREVER);
+	flash_write_protection_set(flash_dev, false);
+
+	if (compact_pending) {
+		err = compact();
+	} else {
+		err = changes_write();
+		if (err == -ENOSPC) {
+			/* Records of the unfinished update are left without
+			 * a commit in the old page.
+			 */
+			err = compact();
+		}
+	}
+
+	flash_write_protection_set(flash_dev, true);
+	k_mutex_unlock(&journal_lock);
+
+	return err;
+}
+
+static void sync_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	nfc_ndef_journal_sync();
+}
+
+void nfc_ndef_journal_t4t_event_process(enum nfc_t4t_event event)
+{
+	if (event == NFC_T4T_EVENT_NDEF_UPDATED) {
+		k_work_submit(&sync_work);
+	}
+}
+
+/* Reads the record at pos and checks it against its CRC.
+ * Returns -ENOENT for erased flash and -EBADMSG for a torn record.
+ */
+static int record_check(off_t page_start, size_t pos, struct record_hdr *hdr)
+{
+	u8_t buf[READ_CHUNK];
+	size_t done;
+	u16_t crc;
+	int err;
+
+	if (area_page_size - pos < sizeof(*hdr)) {
+		return -ENOENT;
+	}
+
+	err = flash_read(flash_dev, page_start + pos, hdr, sizeof(*hdr));
+	if (err) {
+		return err;
+	}
+
+	if (hdr->offset == ERASED_HALF && hdr->length == ERASED_HALF &&
+	    hdr->flags == ERASED_HALF && hdr->crc == ERASED_HALF) {
+		return -ENOENT;
+	}
+
+	if (hdr->offset > ndef_size ||
+	    hdr->length > ndef_size - hdr->offset ||
+	    record_size(hdr->length) > area_page_size - pos) {
+		return -EBADMSG;
+	}
+
+	crc = record_hdr_crc(hdr);
+	for (done = 0; done < hdr->length; done += sizeof(buf)) {
+		size_t chunk = min(sizeof(buf), hdr->length - done);
+
+		err = flash_read(flash_dev,
+				 page_start + pos + sizeof(*hdr) + done, buf,
+				 chunk);
+		if (err) {
+			return err;
+		}
+
+		crc = crc16_ccitt(crc, buf, chunk);
+	}
+
+	return (crc == hdr->crc) ? 0 : -EBADMSG;
+}
+
+/* Finds the end of the last committed update of a page. */
+static int page_scan(u32_t page, size_t *committed)
+{
+	off_t start = page_offset(page);
+	size_t pos = sizeof(struct page_hdr);
+	struct record_hdr hdr;
+	int err;
+
+	*committed = 0;
+
+	while (!(err = record_check(start, pos, &hdr))) {
+		pos += record_size(hdr.length);
+		if (hdr.flags & RECORD_COMMIT) {
+			*committed = pos;
+		}
+	}
+
+	return (err == -ENOENT || err == -EBADMSG) ? 0 : err;
+}
+
+static int page_apply(u32_t page, size_t committed)
+{
+	off_t start = page_offset(page);
+	size_t pos = sizeof(struct page_hdr);
+	struct record_hdr hdr;
+	int err;
+
+	while (pos < committed) {
+		err = flash_read(flash_dev, start + pos, &hdr, sizeof(hdr));
+		if (!err) {
+			err = flash_read(flash_dev, start + pos + sizeof(hdr),
+					 &ndef_file[hdr.offset], hdr.length);
+		}
+		if (err) {
+			return err;
+		}
+
+		pos += record_size(hdr.length);
+	}
+
+	return 0;
+}
+
+static int erased_check(off_t offset, size_t length, bool *erased)
+{
+	u8_t buf[READ_CHUNK];
+	int err;
+
+	*erased = true;
+
+	for (size_t done = 0; done < length; done += sizeof(buf)) {
+		size_t chunk = min(sizeof(buf), length - done);
+
+		err = flash_read(flash_dev, offset + done, buf, chunk);
+		if (err) {
+			return err;
+		}
+
+		for (size_t i = 0; i < chunk; i++) {
+			if (buf[i] != 0xFF) {
+				*erased = false;
+				return 0;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int recover(void)
+{
+	struct page_hdr hdr;
+	size_t committed;
+	bool found = false;
+	bool erased;
+	int err;
+
+	for (u32_t page = 0; page < area_page_count; page++) {
+		err = flash_read(flash_dev, page_offset(page), &hdr,
+				 sizeof(hdr));
+		if (err) {
+			return err;
+		}
+
+		if (hdr.magic != PAGE_MAGIC ||
+		    (found && (s32_t)(hdr.seq - active_seq) <= 0)) {
+			continue;
+		}
+
+		/* A page torn while its snapshot was written has no commit
+		 * and the previous page stays active.
+		 */
+		err = page_scan(page, &committed);
+		if (err) {
+			return err;
+		}
+		if (!committed) {
+			continue;
+		}
+
+		found = true;
+		active_page = page;
+		active_seq = hdr.seq;
+		write_pos = committed;
+	}
+
+	if (!found) {
+		return -ENOENT;
+	}
+
+	/* The snapshot of the page may not cover the whole file. */
+	memset(ndef_file, 0, ndef_size);
+
+	err = page_apply(active_page, write_pos);
+	if (err) {
+		return err;
+	}
+
+	/* Anything left after the last commit cannot be programmed again,
+	 * so the next update starts a new page.
+	 */
+	err = erased_check(page_offset(active_page) + write_pos,
+			   area_page_size - write_pos, &erased);
+	if (err) {
+		return err;
+	}
+
+	compact_pending = !erased;
+
+	return 0;
+}
+
+int nfc_ndef_journal_init(struct device *dev, off_t offset, size_t page_size,
+			  u32_t page_count, u8_t *file, u8_t *shadow,
+			  size_t size)
+{
+	int err;
+
+	if (!dev || !file || !shadow || size < NFC_NDEF_MSG_NLEN_SIZE ||
+	    page_count < 2 || !page_size) {
+		return -EINVAL;
+	}
+
+	if (size > UINT16_MAX ||
+	    sizeof(struct page_hdr) + record_size(size) > page_size) {
+		return -ENOMEM;
+	}
+
+	if (flash_get_write_block_size(dev) > WRITE_ALIGN) {
+		return -ENOTSUP;
+	}
+
+	k_mutex_lock(&journal_lock, K_FOREVER);
+
+	flash_dev = dev;
+	area_offset = offset;
+	area_page_size = page_size;
+	area_page_count = page_count;
+	ndef_file = file;
+	ndef_shadow = shadow;
+	ndef_size = size;
+	memset(&stats, 0, sizeof(stats));
+
+	err = recover();
+	if (err) {
+		/* The first update writes a snapshot to page 0. */
+		active_page = area_page_count - 1;
+		active_seq = 0;
+		compact_pending = true;
+	}
+
+	memcpy(ndef_shadow, ndef_file, ndef_size);
+
+	k_mutex_unlock(&journal_lock);
+
+	return err;
+}
+
+void nfc_ndef_journal_stats_get(struct nfc_ndef_journal_stats *out)
+{
+	k_mutex_lock(&journal_lock, K_FOREVER);
+	*out = stats;
+	k_mutex_unlock(&journal_lock);
+}
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <misc/util.h>
+
+#include <nfc_ndef_msg.h>
+#include <nfc_t4t_lib.h>
+
+#define NDEF_SR_PAYLOAD_MAX 255
+
+static u32_t record_header_size(const struct nfc_ndef_record_desc *record,
+				bool first_chunk, u32_t chunk_length)
+{
+	/* Flags and type length. */
+	u32_t size = 2;
+
+	size += (chunk_length <= NDEF_SR_PAYLOAD_MAX) ? 1 : 4;
+
+	if (first_chunk) {
+		size += record->type_length;
+		if (record->id) {
+			size += 1 + record->id_length;
+		}
+	}
+
+	return size;
+}
+
+static bool record_is_chunked(const struct nfc_ndef_record_desc *record,
+			      u32_t payload_length)
+{
+	return record->chunk_size && payload_length > record->chunk_size;
+}
+
+static int record_payload_length(const struct nfc_ndef_record_desc *record,
+				 u32_t *payload_length)
+{
+	if (!record->payload_constructor) {
+		*payload_length = record->payload_length;
+		return 0;
+	}
+
+	*payload_length = 0;
+	return record->payload_constructor(record->payload_context, NULL,
+					   payload_length);
+}
+
+static u32_t record_size(const struct nfc_ndef_record_desc *record,
+			 u32_t payload_length)
+{
+	u32_t size = payload_length;
+	u32_t offset = 0;
+
+	if (!record_is_chunked(record, payload_length)) {
+		return size + record_header_size(record, true, payload_length);
+	}
+
+	while (offset < payload_length) {
+		u32_t chunk = min(record->chunk_size, payload_length - offset);
+
+		size += record_header_size(record, offset == 0, chunk);
+		offset += chunk;
+	}
+
+	return size;
+}
+
+static u8_t *record_header_write(u8_t *buff,
+				 const struct nfc_ndef_record_desc *record,
+				 u8_t flags, bool first_chunk,
+				 u32_t chunk_length)
+{
+	bool has_id = first_chunk && record->id;
+
+	*buff = flags | (first_chunk ? record->tnf : NFC_NDEF_TNF_UNCHANGED);
+	if (chunk_length <= NDEF_SR_PAYLOAD_MAX) {
+		*buff |= NFC_NDEF_FLAG_SR;
+	}
+	if (has_id) {
+		*buff |= NFC_NDEF_FLAG_IL;
+	}
+	buff++;
+
+	*buff++ = first_chunk ? record->type_length : 0;
+
+	if (chunk_length <= NDEF_SR_PAYLOAD_MAX) {
+		*buff++ = (u8_t)chunk_length;
+	} else {
+		*buff++ = (u8_t)(chunk_length >> 24);
+		*buff++ = (u8_t)(chunk_length >> 16);
+		*buff++ = (u8_t)(chunk_length >> 8);
+		*buff++ = (u8_t)chunk_length;
+	}
+
+	if (has_id) {
+		*buff++ = record->id_length;
+	}
+
+	if (first_chunk) {
+		memcpy(buff, record->type, record->type_length);
+		buff += record->type_length;
+		if (has_id) {
+			memcpy(buff, record->id, record->id_length);
+			buff += record->id_length;
+		}
+	}
+
+	return buff;
+}
+
+static int record_encode(const struct nfc_ndef_record_desc *record,
+			 u8_t flags, u8_t *buff, u32_t size,
+			 u32_t payload_length)
+{
+	const u8_t *payload = record->payload;
+	u32_t offset = 0;
+	u8_t *pos = buff;
+	int err;
+
+	if (record->payload_constructor) {
+		/* Construct the payload at the end of the record. Chunk
+		 * headers are then inserted by moving the payload towards the
+		 * start, so the payload is never stored twice.
+		 */
+		u32_t length = payload_length;
+		u8_t *dst = buff + size - payload_length;
+
+		err = record->payload_constructor(record->payload_context,
+						  dst, &length);
+		if (err) {
+			return err;
+		}
+		if (length != payload_length) {
+			return -EINVAL;
+		}
+		payload = dst;
+	}
+
+	if (!record_is_chunked(record, payload_length)) {
+		pos = record_header_write(pos, record, flags, true,
+					  payload_length);
+		memmove(pos, payload, payload_length);
+		return 0;
+	}
+
+	while (offset < payload_length) {
+		u32_t chunk = min(record->chunk_size, payload_length - offset);
+		bool first = (offset == 0);
+		bool last = (offset + chunk == payload_length);
+		u8_t chunk_flags = last ? (flags & NFC_NDEF_FLAG_ME) :
+				   NFC_NDEF_FLAG_CF;
+
+		if (first) {
+			chunk_flags |= flags & NFC_NDEF_FLAG_MB;
+		}
+
+		pos = record_header_write(pos, record, chunk_flags, first,
+					  chunk);
+		memmove(pos, payload + offset, chunk);
+		pos += chunk;
+		offset += chunk;
+	}
+
+	return 0;
+}
+
+int nfc_ndef_msg_encode(const struct nfc_ndef_msg_desc *msg,
+			enum nfc_ndef_msg_format format,
+			u8_t *buff, u32_t *len)
+{
+	u32_t header = (format == NFC_NDEF_MSG_FORMAT_T4T) ?
+		       NFC_NDEF_MSG_NLEN_SIZE : 0;
+	u32_t offset = header;
+	int err;
+
+	if (!msg || !len || (msg->record_count && !msg->records)) {
+		return -EINVAL;
+	}
+
+	if (buff && *len < header) {
+		return -ENOMEM;
+	}
+
+	for (u32_t i = 0; i < msg->record_count; i++) {
+		const struct nfc_ndef_record_desc *record = msg->records[i];
+		u32_t payload_length;
+		u32_t size;
+		u8_t flags = 0;
+
+		if (!record ||
+		    (record->type_length && !record->type) ||
+		    (!record->payload_constructor &&
+		     record->payload_length && !record->payload)) {
+			return -EINVAL;
+		}
+
+		err = record_payload_length(record, &payload_length);
+		if (err) {
+			return err;
+		}
+
+		size = record_size(record, payload_length);
+
+		if (buff) {
+			if (size > *len - offset) {
+				return -ENOMEM;
+			}
+
+			if (i == 0) {
+				flags |= NFC_NDEF_FLAG_MB;
+			}
+			if (i == msg->record_count - 1) {
+				flags |= NFC_NDEF_FLAG_ME;
+			}
+
+			err = record_encode(record, flags, buff + offset, size,
+					    payload_length);
+			if (err) {
+				return err;
+			}
+		}
+
+		offset += size;
+	}
+
+	if (header) {
+		if (offset > NFC_T4T_MAX_PAYLOAD_SIZE) {
+			return -ENOMEM;
+		}
+
+		if (buff) {
+			buff[0] = (u8_t)((offset - header) >> 8);
+			buff[1] = (u8_t)(offset - header);
+		}
+	}
+
+	*len = offset;
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <misc/util.h>
+
+#include <nfc_ndef_parser.h>
+
+/* Type Name Format value 7 is reserved. */
+#define NDEF_TNF_RESERVED 0x07
+
+void nfc_ndef_parser_init(struct nfc_ndef_parser *parser, const u8_t *msg,
+			  u32_t length, u32_t *marks, u32_t mark_count)
+{
+	memset(parser, 0, sizeof(*parser));
+	parser->msg = msg;
+	parser->length = length;
+	parser->marks = marks;
+	parser->mark_count = marks ? mark_count : 0;
+}
+
+int nfc_ndef_parser_init_t4t(struct nfc_ndef_parser *parser, const u8_t *file,
+			     u32_t file_size, u32_t *marks, u32_t mark_count)
+{
+	u32_t nlen;
+
+	if (file_size < NFC_NDEF_MSG_NLEN_SIZE) {
+		return -EBADMSG;
+	}
+
+	nlen = (file[0] << 8) | file[1];
+	if (nlen > file_size - NFC_NDEF_MSG_NLEN_SIZE) {
+		return -EBADMSG;
+	}
+
+	nfc_ndef_parser_init(parser, file + NFC_NDEF_MSG_NLEN_SIZE, nlen,
+			     marks, mark_count);
+
+	return 0;
+}
+
+int nfc_ndef_parser_next(struct nfc_ndef_parser *parser,
+			 struct nfc_ndef_record_view *record)
+{
+	const u8_t *pos = parser->msg + parser->offset;
+	u32_t left = parser->length - parser->offset;
+	u32_t header;
+	u8_t flags;
+
+	if (parser->end || (parser->length == 0 && parser->index == 0)) {
+		return -ENOENT;
+	}
+
+	/* Flags, type length and at least a short payload length. */
+	if (parser->offset >= parser->length || left < 3) {
+		return -EBADMSG;
+	}
+
+	flags = pos[0];
+	if ((flags & NFC_NDEF_TNF_MASK) == NDEF_TNF_RESERVED ||
+	    !(flags & NFC_NDEF_FLAG_MB) != (parser->index != 0)) {
+		return -EBADMSG;
+	}
+
+	record->flags = flags & ~NFC_NDEF_TNF_MASK;
+	record->tnf = (enum nfc_ndef_tnf)(flags & NFC_NDEF_TNF_MASK);
+	record->type_length = pos[1];
+	record->offset = parser->offset;
+	record->index = parser->index;
+
+	header = 2;
+	if (flags & NFC_NDEF_FLAG_SR) {
+		record->payload_length = pos[header];
+		header += 1;
+	} else {
+		if (left < header + 4) {
+			return -EBADMSG;
+		}
+		record->payload_length = ((u32_t)pos[header] << 24) |
+					 ((u32_t)pos[header + 1] << 16) |
+					 ((u32_t)pos[header + 2] << 8) |
+					 pos[header + 3];
+		header += 4;
+	}
+
+	record->id_length = 0;
+	if (flags & NFC_NDEF_FLAG_IL) {
+		if (left < header + 1) {
+			return -EBADMSG;
+		}
+		record->id_length = pos[header];
+		header += 1;
+	}
+
+	/* Compare against what is left to avoid overflowing the sum. */
+	if (left - header < (u32_t)record->type_length + record->id_length ||
+	    left - header - record->type_length - record->id_length <
+	    record->payload_length) {
+		return -EBADMSG;
+	}
+
+	record->type = pos + header;
+	record->id = (flags & NFC_NDEF_FLAG_IL) ?
+		     record->type + record->type_length : NULL;
+	record->payload = record->type + record->type_length +
+			  record->id_length;
+
+	if (parser->index < parser->mark_count) {
+		parser->marks[parser->index] = parser->offset;
+	}
+
+	parser->offset += header + record->type_length + record->id_length +
+			  record->payload_length;
+	parser->index++;
+	parser->end = (flags & NFC_NDEF_FLAG_ME) != 0;
+
+	return 0;
+}
+
+void nfc_ndef_parser_resume(struct nfc_ndef_parser *parser, u32_t length,
+			    u32_t changed_offset)
+{
+	u32_t known = min(parser->index, parser->mark_count);
+	u32_t lo = 0;
+	u32_t hi = known;
+
+	/* Marks are increasing, find the last one not after the change. */
+	while (lo < hi) {
+		u32_t mid = lo + (hi - lo) / 2;
+
+		if (parser->marks[mid] <= changed_offset) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	parser->length = length;
+	parser->end = false;
+
+	if (lo == 0) {
+		parser->offset = 0;
+		parser->index = 0;
+	} else {
+		parser->offset = parser->marks[lo - 1];
+		parser->index = lo - 1;
+	}
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+
+#include <ocrypto_ecdsa_p256.h>
+#include <ocrypto_ed25519.h>
+#include <ocrypto_sha256.h>
+
+#include <nfc_ndef_parser.h>
+#include <nfc_ndef_sig.h>
+
+#define SIG_VERSION          0x20
+#define SIG_SESSION_KEY_SIZE 32
+
+/* Session keys outside the curve order are rejected, retry a few times. */
+#define SIG_SIGN_ATTEMPTS 4
+
+/* Version, signature type, hash type and signature length. */
+#define SIG_PAYLOAD_HEADER_SIZE 5
+
+/* Flags, type length, short payload length and type. */
+#define SIG_RECORD_HEADER_SIZE  6
+
+static const u8_t sig_record_type[] = {'S', 'i', 'g'};
+
+/* Certificate format X.509, no certificate, no URI. */
+static const u8_t empty_cert_chain[] = {0x00};
+
+static u32_t sig_payload_length(const struct nfc_ndef_sig_key *key)
+{
+	return SIG_PAYLOAD_HEADER_SIZE + NFC_NDEF_SIG_SIZE +
+	       (key->cert_chain ? key->cert_chain_length :
+				  sizeof(empty_cert_chain));
+}
+
+static int ecdsa_sign(const struct nfc_ndef_sig_key *key,
+		      struct nfc_ndef_parser *parser,
+		      struct nfc_ndef_record_view *last, u8_t *sig)
+{
+	struct nfc_ndef_record_view record;
+	u8_t hash[ocrypto_sha256_BYTES];
+	u8_t ek[SIG_SESSION_KEY_SIZE];
+	ocrypto_sha256_ctx ctx;
+	int err;
+
+	ocrypto_sha256_init(&ctx);
+	while (!(err = nfc_ndef_parser_next(parser, &record))) {
+		ocrypto_sha256_update(&ctx, record.type, record.type_length);
+		ocrypto_sha256_update(&ctx, record.id, record.id_length);
+		ocrypto_sha256_update(&ctx, record.payload,
+				      record.payload_length);
+		*last = record;
+	}
+	if (err != -ENOENT) {
+		return err;
+	}
+	ocrypto_sha256_final(&ctx, hash);
+
+	for (int i = 0; i < SIG_SIGN_ATTEMPTS; i++) {
+		err = key->rand(ek, sizeof(ek));
+		if (err) {
+			break;
+		}
+
+		if (!ocrypto_ecdsa_p256_sign_hash(sig, hash, key->sk, ek)) {
+			err = 0;
+			break;
+		}
+		err = -EIO;
+	}
+
+	memset(ek, 0, sizeof(ek));
+
+	return err;
+}
+
+static int ed25519_sign(const struct nfc_ndef_sig_key *key,
+			struct nfc_ndef_parser *parser,
+			struct nfc_ndef_record_view *last, u8_t *sig)
+{
+	struct nfc_ndef_record_view record;
+	size_t length = 0;
+	int err;
+
+	while (!(err = nfc_ndef_parser_next(parser, &record))) {
+		u32_t size = record.type_length + record.id_length +
+			     record.payload_length;
+
+		if (size > key->scratch_size - length) {
+			return -ENOMEM;
+		}
+
+		memcpy(&key->scratch[length], record.type, record.type_length);
+		length += record.type_length;
+		if (record.id_length) {
+			memcpy(&key->scratch[length], record.id,
+			       record.id_length);
+			length += record.id_length;
+		}
+		memcpy(&key->scratch[length], record.payload,
+		       record.payload_length);
+		length += record.payload_length;
+		*last = record;
+	}
+	if (err != -ENOENT) {
+		return err;
+	}
+
+	ocrypto_ed25519_sign(sig, key->scratch, length, key->sk, key->pk);
+
+	return 0;
+}
+
+int nfc_ndef_sig_msg_encode(const struct nfc_ndef_sig_key *key,
+			    const struct nfc_ndef_msg_desc *msg,
+			    enum nfc_ndef_msg_format format,
+			    u8_t *buff, u32_t *len)
+{
+	u32_t nlen_size = (format == NFC_NDEF_MSG_FORMAT_T4T) ?
+			  NFC_NDEF_MSG_NLEN_SIZE : 0;
+	struct nfc_ndef_record_view last;
+	struct nfc_ndef_parser parser;
+	u32_t payload_length;
+	u32_t record_size;
+	u32_t msg_length;
+	u32_t size;
+	u8_t *pos;
+	u8_t flags;
+	int err;
+
+	if (!key || !key->sk || !msg || !len ||
+	    (key->alg == NFC_NDEF_SIG_ECDSA_P256 && !key->rand) ||
+	    (key->alg == NFC_NDEF_SIG_ED25519 && (!key->pk || !key->scratch))) {
+		return -EINVAL;
+	}
+
+	payload_length = sig_payload_length(key);
+	if (payload_length > UINT8_MAX) {
+		return -EINVAL;
+	}
+	record_size = SIG_RECORD_HEADER_SIZE + payload_length;
+
+	size = *len;
+	err = nfc_ndef_msg_encode(msg, format, buff, len);
+	if (err) {
+		return err;
+	}
+
+	if (!buff) {
+		*len += record_size;
+		return 0;
+	}
+
+	if (record_size > size - *len) {
+		return -ENOMEM;
+	}
+
+	msg_length = *len - nlen_size;
+	if (nlen_size && msg_length + record_size > UINT16_MAX) {
+		return -ENOMEM;
+	}
+
+	pos = buff + *len + SIG_RECORD_HEADER_SIZE + SIG_PAYLOAD_HEADER_SIZE;
+
+	/* Sign the records while the message is still well-formed, and find
+	 * the last one on the way.
+	 */
+	last.flags = 0;
+	nfc_ndef_parser_init(&parser, buff + nlen_size, msg_length, NULL, 0);
+	if (key->alg == NFC_NDEF_SIG_ECDSA_P256) {
+		err = ecdsa_sign(key, &parser, &last, pos);
+	} else {
+		err = ed25519_sign(key, &parser, &last, pos);
+	}
+	if (err) {
+		return err;
+	}
+
+	/* The last record no longer ends the message. */
+	flags = NFC_NDEF_FLAG_ME | NFC_NDEF_FLAG_SR | NFC_NDEF_TNF_WELL_KNOWN;
+	if (last.flags & NFC_NDEF_FLAG_ME) {
+		buff[nlen_size + last.offset] &= ~NFC_NDEF_FLAG_ME;
+	} else {
+		flags |= NFC_NDEF_FLAG_MB;
+	}
+
+	pos = buff + *len;
+	*pos++ = flags;
+	*pos++ = sizeof(sig_record_type);
+	*pos++ = (u8_t)payload_length;
+	memcpy(pos, sig_record_type, sizeof(sig_record_type));
+	pos += sizeof(sig_record_type);
+
+	*pos++ = SIG_VERSION;
+	*pos++ = key->sig_type;
+	*pos++ = key->hash_type;
+	*pos++ = (u8_t)(NFC_NDEF_SIG_SIZE >> 8);
+	*pos++ = (u8_t)NFC_NDEF_SIG_SIZE;
+	pos += NFC_NDEF_SIG_SIZE;
+
+	if (key->cert_chain) {
+		memcpy(pos, key->cert_chain, key->cert_chain_length);
+	} else {
+		memcpy(pos, empty_cert_chain, sizeof(empty_cert_chain));
+	}
+
+	*len += record_size;
+
+	if (nlen_size) {
+		buff[0] = (u8_t)((*len - nlen_size) >> 8);
+		buff[1] = (u8_t)(*len - nlen_size);
+	}
+
+	return 0;
+}
@@ -5,9 +5,13 @@
  */
 #include <clock_control.h>
 #include <device.h>
+#include <kernel.h>
 #include <nrfx_nfct.h>
 #include <nrfx_timer.h>
 
+#include <nfc_latency.h>
+#include <nfc_pm.h>
+
 #include <logging/log.h>
 
 #define LOG_MODULE_NAME nfc_platform
@@ -16,15 +20,213 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 
 struct device *clock;
 
-nrfx_err_t nfc_platform_setup(void)
+/* Events of the interrupt path. They are stored as an ID and a timestamp
+ * and logged later from the system work queue, so that debug logging does
+ * not delay NFCT activation.
+ */
+enum platform_evt {
+	PLATFORM_EVT_FIELD_DETECTED,
+	PLATFORM_EVT_FIELD_LOST,
+	PLATFORM_EVT_CLOCK_STARTED,
+};
+
+#if defined(CONFIG_NFC_PLATFORM_LOG_LEVEL_DBG)
+#define EVT_LOG_SIZE CONFIG_NFC_PLATFORM_EVT_LOG_SIZE
+
+BUILD_ASSERT_MSG((EVT_LOG_SIZE & (EVT_LOG_SIZE - 1)) == 0,
+		 "Event log size must be a power of two");
+
+struct evt_log_entry {
+	u32_t cycles;
+	u8_t id;
+};
+
+static const char *const evt_names[] = {
+	[PLATFORM_EVT_FIELD_DETECTED] = "Field detected",
+	[PLATFORM_EVT_FIELD_LOST] = "Field lost",
+	[PLATFORM_EVT_CLOCK_STARTED] = "HFXO started",
+};
+
+static struct evt_log_entry evt_log[EVT_LOG_SIZE];
+static u32_t evt_head;
+static u32_t evt_tail;
+static u32_t evt_dropped;
+
+static void evt_log_flush(struct k_work *work)
+{
+	unsigned int key;
+	u32_t dropped;
+
+	while (evt_tail != evt_head) {
+		const struct evt_log_entry *entry =
+			&evt_log[evt_tail & (EVT_LOG_SIZE - 1)];
+
+		LOG_DBG("%s at %u us", evt_names[entry->id],
+			(u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(entry->cycles) /
+				NSEC_PER_USEC));
+		compiler_barrier();
+		evt_tail++;
+	}
+
+	/* Read and clear together, a drop may be counted in between. */
+	key = irq_lock();
+	dropped = evt_dropped;
+	evt_dropped = 0;
+	irq_unlock(key);
+
+	if (dropped) {
+		LOG_WRN("%u events dropped", dropped);
+	}
+}
+
+static K_WORK_DEFINE(evt_log_work, evt_log_flush);
+#endif
+
+/* Called from the NFCT and POWER_CLOCK interrupts. */
+static void evt_log_put(enum platform_evt id)
+{
+#if defined(CONFIG_NFC_PLATFORM_LOG_LEVEL_DBG)
+	struct evt_log_entry *entry;
+	unsigned int key = irq_lock();
+
+	if (evt_head - evt_tail >= EVT_LOG_SIZE) {
+		evt_dropped++;
+		irq_unlock(key);
+		return;
+	}
+
+	entry = &evt_log[evt_head & (EVT_LOG_SIZE - 1)];
+	entry->cycles = k_cycle_get_32();
+	entry->id = id;
+	compiler_barrier();
+	evt_head++;
+	irq_unlock(key);
+
+	k_work_submit(&evt_log_work);
+#else
+	ARG_UNUSED(id);
+#endif
+}
+
+static void nfct_activate(void)
+{
+	nrfx_nfct_state_force(NRFX_NFCT_STATE_ACTIVATED);
+	nfc_latency_mark(NFC_LATENCY_MARK_ACTIVATED);
+}
+
+#if defined(CONFIG_NFC_PLATFORM_CLOCK_ON_DEMAND)
+static bool clock_running;
+static bool clock_starting;
+static bool field_present;
+
+static void clock_release_handler(struct k_work *work)
+{
+	unsigned int key = irq_lock();
+
+	/* A new field may have been detected after the release was
+	 * scheduled. A clock still starting is released from
+	 * clock_started().
+	 */
+	if (clock_running && !field_present) {
+		clock_running = false;
+		clock_control_off(clock, NULL);
+	}
+
+	irq_unlock(key);
+}
+
+static struct k_delayed_work clock_release_work;
+
+/* Runs in the POWER_CLOCK interrupt once HFXO is stable, or right away
+ * from clock_control_async_on() if it already is.
+ */
+static void clock_started(struct device *dev, void *user_data)
+{
+	unsigned int key = irq_lock();
+
+	ARG_UNUSED(dev);
+	ARG_UNUSED(user_data);
+
+	clock_starting = false;
+	clock_running = true;
+	evt_log_put(PLATFORM_EVT_CLOCK_STARTED);
+
+	if (field_present) {
+		nfct_activate();
+	} else {
+		/* The field was lost while the clock was starting. */
+		k_delayed_work_submit(&clock_release_work,
+			K_MSEC(CONFIG_NFC_PLATFORM_CLOCK_KEEP_WARM_MS));
+	}
+
+	irq_unlock(key);
+}
+
+static struct clock_control_async_data clock_async_data = {
+	.cb = clock_started,
+};
+#endif
+
+/* Returns true if HFXO is running, and NFCT can be activated right away.
+ * Otherwise, NFCT is activated from clock_started().
+ */
+static bool clock_request(void)
 {
+#if defined(CONFIG_NFC_PLATFORM_CLOCK_ON_DEMAND)
+	unsigned int key = irq_lock();
+	bool running = clock_running;
 	int err;
 
+	field_present = true;
+	k_delayed_work_cancel(&clock_release_work);
+
+	if (running || clock_starting) {
+		irq_unlock(key);
+		return running;
+	}
+
+	/* Do not wait in the interrupt for HFXO to be stable. NFCT is not
+	 * activated yet, so the reader only sees the tag once the clock is
+	 * usable.
+	 */
+	clock_starting = true;
+	irq_unlock(key);
+
+	err = clock_control_async_on(clock, NULL, &clock_async_data);
+	__ASSERT_NO_MSG(!err);
+
+	return false;
+#else
+	return true;
+#endif
+}
+
+static void clock_release(void)
+{
+#if defined(CONFIG_NFC_PLATFORM_CLOCK_ON_DEMAND)
+	unsigned int key = irq_lock();
+
+	field_present = false;
+	if (!clock_starting) {
+		k_delayed_work_submit(&clock_release_work,
+			K_MSEC(CONFIG_NFC_PLATFORM_CLOCK_KEEP_WARM_MS));
+	}
+
+	irq_unlock(key);
+#endif
+}
+
+nrfx_err_t nfc_platform_setup(void)
+{
 	clock = device_get_binding(DT_NORDIC_NRF_CLOCK_0_LABEL "_16M");
 	__ASSERT_NO_MSG(clock);
 
-	err = clock_control_on(clock, (void *)1);
+#if defined(CONFIG_NFC_PLATFORM_CLOCK_ON_DEMAND)
+	k_delayed_work_init(&clock_release_work, clock_release_handler);
+#else
+	int err = clock_control_on(clock, (void *)1);
 	__ASSERT_NO_MSG(!err);
+#endif
 
 	IRQ_DIRECT_CONNECT(NFCT_IRQn, CONFIG_NFCT_IRQ_PRIORITY,
 			   nrfx_nfct_irq_handler, 0);
@@ -40,13 +242,20 @@ void nfc_platform_event_handler(nrfx_nfct_evt_t const *event)
 {
 	switch (event->evt_id) {
 	case NRFX_NFCT_EVT_FIELD_DETECTED:
-		LOG_DBG("Field detected");
+		nfc_latency_mark(NFC_LATENCY_MARK_FIELD_DETECTED);
+		evt_log_put(PLATFORM_EVT_FIELD_DETECTED);
+		nfc_pm_field_detected();
 		/* Activate NFCT only when HFXO is running */
-		nrfx_nfct_state_force(NRFX_NFCT_STATE_ACTIVATED);
+		if (clock_request()) {
+			nfct_activate();
+		}
 		break;
 
 	case NRFX_NFCT_EVT_FIELD_LOST:
-		LOG_DBG("Field lost");
+		nfc_latency_mark(NFC_LATENCY_MARK_FIELD_LOST);
+		evt_log_put(PLATFORM_EVT_FIELD_LOST);
+		clock_release();
+		nfc_pm_field_lost();
 		break;
 
 	default:
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <kernel.h>
+#include <nrfx_nfct.h>
+
+#include <nfc_pm.h>
+
+/* Switching sensing on and off once per period. */
+#define WAKEUPS_PER_PERIOD 2
+
+enum pm_state {
+	PM_STOPPED,
+	/* Idle, sense window open. */
+	PM_WINDOW,
+	/* Idle, sensing disabled until the next window. */
+	PM_DISABLED,
+	/* Field present, or lost less than the hold time ago. */
+	PM_ACTIVE,
+};
+
+static struct nfc_pm_config pm_config;
+static enum pm_state state = PM_STOPPED;
+static u32_t state_since;
+static struct nfc_pm_stats stats;
+/* Tracked while stopped too, so that starting during a tap does not
+ * disable sensing under the reader.
+ */
+static bool field_present;
+
+static void pm_timer_handler(struct k_timer *timer);
+static K_TIMER_DEFINE(pm_timer, pm_timer_handler, NULL);
+
+/* Called with interrupts locked. */
+static void state_set(enum pm_state next)
+{
+	u32_t now = k_uptime_get_32();
+
+	if (state == PM_DISABLED) {
+		stats.disabled_ms += now - state_since;
+	} else if (state != PM_STOPPED) {
+		stats.sense_ms += now - state_since;
+	}
+
+	state = next;
+	state_since = now;
+}
+
+/* Runs in the system clock interrupt. */
+static void pm_timer_handler(struct k_timer *timer)
+{
+	unsigned int key = irq_lock();
+
+	ARG_UNUSED(timer);
+
+	switch (state) {
+	case PM_WINDOW:
+	case PM_ACTIVE:
+		/* No field during the window, or the hold time expired. */
+		nrfx_nfct_state_force(NRFX_NFCT_STATE_DISABLED);
+		state_set(PM_DISABLED);
+		k_timer_start(&pm_timer,
+			      K_MSEC(pm_config.period_ms - pm_config.window_ms),
+			      0);
+		break;
+
+	case PM_DISABLED:
+		nrfx_nfct_state_force(NRFX_NFCT_STATE_SENSING);
+		state_set(PM_WINDOW);
+		stats.windows++;
+		k_timer_start(&pm_timer, K_MSEC(pm_config.window_ms), 0);
+		break;
+
+	default:
+		break;
+	}
+
+	irq_unlock(key);
+}
+
+int nfc_pm_start(const struct nfc_pm_config *config)
+{
+	unsigned int key;
+
+	if (!config || !config->window_ms ||
+	    config->window_ms >= config->period_ms) {
+		return -EINVAL;
+	}
+
+	key = irq_lock();
+
+	pm_config = *config;
+	if (state == PM_STOPPED) {
+		if (field_present) {
+			/* The hold time starts when the field is lost. */
+			state_set(PM_ACTIVE);
+		} else {
+			state_set(PM_WINDOW);
+			k_timer_start(&pm_timer, K_MSEC(pm_config.window_ms),
+				      0);
+		}
+	}
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+void nfc_pm_stop(void)
+{
+	unsigned int key = irq_lock();
+
+	k_timer_stop(&pm_timer);
+
+	if (state == PM_DISABLED) {
+		nrfx_nfct_state_force(NRFX_NFCT_STATE_SENSING);
+	}
+	state_set(PM_STOPPED);
+
+	irq_unlock(key);
+}
+
+void nfc_pm_field_detected(void)
+{
+	unsigned int key = irq_lock();
+
+	stats.detections++;
+	field_present = true;
+
+	if (state != PM_STOPPED) {
+		k_timer_stop(&pm_timer);
+		state_set(PM_ACTIVE);
+	}
+
+	irq_unlock(key);
+}
+
+void nfc_pm_field_lost(void)
+{
+	unsigned int key = irq_lock();
+
+	field_present = false;
+
+	/* The driver senses again after the field is lost. */
+	if (state == PM_ACTIVE) {
+		k_timer_start(&pm_timer, K_MSEC(pm_config.hold_ms), 0);
+	}
+
+	irq_unlock(key);
+}
+
+void nfc_pm_stats_get(struct nfc_pm_stats *out)
+{
+	unsigned int key = irq_lock();
+
+	/* Account for the time spent in the current state. */
+	state_set(state);
+	*out = stats;
+
+	irq_unlock(key);
+}
+
+u32_t nfc_pm_current_estimate(enum nfc_pm_policy policy,
+			      const struct nfc_pm_config *config,
+			      const struct nfc_pm_current *current)
+{
+	u64_t sense;
+	u64_t wakeups;
+
+	if (!current) {
+		return 0;
+	}
+
+	switch (policy) {
+	case NFC_PM_POLICY_CONTINUOUS:
+		return current->base_na + current->sense_na;
+
+	case NFC_PM_POLICY_DUTY_CYCLED:
+		if (!config || !config->window_ms ||
+		    config->window_ms >= config->period_ms) {
+			return 0;
+		}
+
+		sense = (u64_t)current->sense_na * config->window_ms +
+			(u64_t)current->disabled_na *
+			(config->period_ms - config->window_ms);
+
+		/* nC per period over a period in ms gives uA, scaled to
+		 * nA.
+		 */
+		wakeups = (u64_t)WAKEUPS_PER_PERIOD * current->wakeup_nc *
+			  MSEC_PER_SEC;
+
+		return current->base_na +
+		       (u32_t)((sense + wakeups) / config->period_ms);
+
+	default:
+		return 0;
+	}
+}
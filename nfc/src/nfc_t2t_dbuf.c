@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <kernel.h>
+
+#include <nfc_t2t_dbuf.h>
+
+enum stage_state {
+	STAGE_IDLE,
+	/* Withdrawn by nfc_t2t_dbuf_staging_get(), not committed again. */
+	STAGE_WITHDRAWN,
+	STAGE_PENDING,
+	STAGE_SWAPPING,
+};
+
+static u8_t *bufs[2];
+static size_t buf_size;
+static bool raw_payload;
+static u8_t active;
+static size_t staged_length;
+static enum stage_state state;
+static bool field_on;
+static bool running;
+static struct k_work *staging_work;
+static bool staging_refused;
+
+/* Serializes the stop, set and start sequence with the application. */
+static K_MUTEX_DEFINE(emulation_lock);
+
+static void swap_work_handler(struct k_work *work);
+static K_WORK_DEFINE(swap_work, swap_work_handler);
+
+static int payload_register(const u8_t *payload, size_t length)
+{
+	if (raw_payload) {
+		return nfc_t2t_payload_raw_set(payload, length);
+	}
+
+	return nfc_t2t_payload_set(payload, length);
+}
+
+static int payload_swap(const u8_t *payload, size_t length)
+{
+	unsigned int key;
+	int err;
+
+	if (!running) {
+		return payload_register(payload, length);
+	}
+
+	/* A reader may have come since swap_try() checked for the field.
+	 * Check again and stop in the same critical section, so that no
+	 * FIELD_ON can come in between. Once stopped, there are no field
+	 * events until the emulation is started again.
+	 */
+	key = irq_lock();
+	if (field_on) {
+		irq_unlock(key);
+		return -EAGAIN;
+	}
+	err = nfc_t2t_emulation_stop();
+	irq_unlock(key);
+
+	if (err) {
+		return err;
+	}
+
+	err = payload_register(payload, length);
+
+	/* Restart even if the payload was rejected, the previous one is
+	 * still registered.
+	 */
+	if (nfc_t2t_emulation_start() && !err) {
+		running = false;
+		err = -EIO;
+	}
+
+	return err;
+}
+
+static void swap_try(void)
+{
+	unsigned int key;
+	u8_t staged;
+	bool retry;
+	bool notify;
+	int err;
+
+	key = irq_lock();
+	if (state != STAGE_PENDING || field_on) {
+		irq_unlock(key);
+		return;
+	}
+	state = STAGE_SWAPPING;
+	staged = active ^ 1;
+	irq_unlock(key);
+
+	err = payload_swap(bufs[staged], staged_length);
+
+	key = irq_lock();
+	if (!err) {
+		active = staged;
+		state = STAGE_IDLE;
+		retry = false;
+	} else {
+		/* Keep the payload pending, it is retried on the next
+		 * field off or commit. -EAGAIN means a reader came. If it
+		 * already left, its FIELD_OFF saw STAGE_SWAPPING and did not
+		 * submit the swap, so submit it here.
+		 */
+		state = STAGE_PENDING;
+		retry = (err == -EAGAIN) && !field_on;
+	}
+	notify = staging_refused;
+	staging_refused = false;
+	irq_unlock(key);
+
+	if (retry) {
+		k_work_submit(&swap_work);
+	}
+	if (notify && staging_work) {
+		k_work_submit(staging_work);
+	}
+}
+
+static void swap_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	k_mutex_lock(&emulation_lock, K_FOREVER);
+	swap_try();
+	k_mutex_unlock(&emulation_lock);
+}
+
+int nfc_t2t_dbuf_init(u8_t *buf0, u8_t *buf1, size_t size, bool raw)
+{
+	if (!buf0 || !buf1 || !size) {
+		return -EINVAL;
+	}
+
+	if (running) {
+		return -EBUSY;
+	}
+
+	bufs[0] = buf0;
+	bufs[1] = buf1;
+	buf_size = size;
+	raw_payload = raw;
+	active = 0;
+	staged_length = 0;
+	state = STAGE_IDLE;
+	field_on = false;
+	staging_refused = false;
+
+	return 0;
+}
+
+u8_t *nfc_t2t_dbuf_staging_get(size_t *size)
+{
+	unsigned int key;
+	u8_t *buf = NULL;
+
+	key = irq_lock();
+	if (state == STAGE_SWAPPING) {
+		staging_refused = true;
+	} else {
+		if (state == STAGE_PENDING) {
+			state = STAGE_WITHDRAWN;
+		}
+		buf = bufs[active ^ 1];
+	}
+	irq_unlock(key);
+
+	if (buf && size) {
+		*size = buf_size;
+	}
+
+	return buf;
+}
+
+void nfc_t2t_dbuf_staging_work_set(struct k_work *work)
+{
+	staging_work = work;
+}
+
+int nfc_t2t_dbuf_commit(size_t length)
+{
+	size_t max = raw_payload ? NFC_T2T_MAX_PAYLOAD_SIZE_RAW :
+				   NFC_T2T_MAX_PAYLOAD_SIZE;
+	unsigned int key;
+	bool submit;
+
+	if (length > buf_size || length > max) {
+		return -EINVAL;
+	}
+
+	key = irq_lock();
+	if (state == STAGE_SWAPPING) {
+		staging_refused = true;
+		irq_unlock(key);
+		return -EBUSY;
+	}
+	staged_length = length;
+	state = STAGE_PENDING;
+	submit = !field_on;
+	irq_unlock(key);
+
+	if (submit) {
+		k_work_submit(&swap_work);
+	}
+
+	return 0;
+}
+
+bool nfc_t2t_dbuf_pending(void)
+{
+	return state != STAGE_IDLE;
+}
+
+int nfc_t2t_dbuf_emulation_start(void)
+{
+	int err;
+
+	k_mutex_lock(&emulation_lock, K_FOREVER);
+
+	if (running) {
+		k_mutex_unlock(&emulation_lock);
+		return -EBUSY;
+	}
+
+	/* Register a payload committed just before starting right away. */
+	swap_try();
+
+	err = nfc_t2t_emulation_start();
+	if (!err) {
+		running = true;
+	}
+
+	k_mutex_unlock(&emulation_lock);
+
+	return err;
+}
+
+int nfc_t2t_dbuf_emulation_stop(void)
+{
+	int err;
+
+	k_mutex_lock(&emulation_lock, K_FOREVER);
+
+	err = nfc_t2t_emulation_stop();
+	if (!err) {
+		running = false;
+		field_on = false;
+	}
+
+	k_mutex_unlock(&emulation_lock);
+
+	return err;
+}
+
+void nfc_t2t_dbuf_event_process(enum nfc_t2t_event event)
+{
+	switch (event) {
+	case NFC_T2T_EVENT_FIELD_ON:
+		field_on = true;
+		break;
+
+	case NFC_T2T_EVENT_FIELD_OFF:
+		field_on = false;
+		if (state == STAGE_PENDING) {
+			k_work_submit(&swap_work);
+		}
+		break;
+
+	default:
+		/* No implementation required */
+		break;
+	}
+}
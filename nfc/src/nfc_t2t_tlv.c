@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <misc/util.h>
+
+#include <nfc_t2t_lib.h>
+#include <nfc_t2t_tlv.h>
+
+/* The data area follows the internal bytes, lock bytes and CC. */
+#define T2T_DATA_OFFSET  16
+
+#define TLV_LONG_FORMAT  0xFF
+#define TLV_SHORT_MAX    0xFE
+
+/* Lock Control size is in bits, Memory Control size in bytes. Both
+ * encode 256 as 0.
+ */
+#define CONTROL_SIZE_MAX 256
+
+struct writer {
+	const struct nfc_t2t_tlv *tlvs;
+	u32_t count;
+	u8_t *buff;
+	u32_t size;
+	u32_t pos;
+};
+
+static bool is_control(const struct nfc_t2t_tlv *tlv)
+{
+	return tlv->type == NFC_T2T_TLV_LOCK_CONTROL ||
+	       tlv->type == NFC_T2T_TLV_MEMORY_CONTROL;
+}
+
+/* Converts a control TLV to a reserved area of the data area. */
+static int area_get(const struct nfc_t2t_tlv *tlv, u32_t *start,
+		    u32_t *size)
+{
+	u8_t page_addr = tlv->value[0] >> 4;
+	u8_t byte_offset = tlv->value[0] & 0x0F;
+	u8_t page_shift = tlv->value[2] & 0x0F;
+	u32_t address;
+
+	*size = tlv->value[1] ? tlv->value[1] : CONTROL_SIZE_MAX;
+	if (tlv->type == NFC_T2T_TLV_LOCK_CONTROL) {
+		*size = (*size + 7) / 8;
+	}
+
+	address = ((u32_t)page_addr << page_shift) + byte_offset;
+	if (address < T2T_DATA_OFFSET) {
+		return -EINVAL;
+	}
+
+	*start = address - T2T_DATA_OFFSET;
+
+	return 0;
+}
+
+static bool reserved(const struct writer *w, u32_t pos)
+{
+	for (u32_t i = 0; i < w->count; i++) {
+		u32_t start;
+		u32_t size;
+
+		if (is_control(&w->tlvs[i]) &&
+		    !area_get(&w->tlvs[i], &start, &size) &&
+		    pos >= start && pos - start < size) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int byte_put(struct writer *w, u8_t byte)
+{
+	/* TLV fields never start or continue inside a reserved area. */
+	while (reserved(w, w->pos)) {
+		if (w->pos >= w->size) {
+			return -ENOMEM;
+		}
+		if (w->buff) {
+			w->buff[w->pos] = 0x00;
+		}
+		w->pos++;
+	}
+
+	if (w->pos >= w->size) {
+		return -ENOMEM;
+	}
+
+	if (w->buff) {
+		w->buff[w->pos] = byte;
+	}
+	w->pos++;
+
+	return 0;
+}
+
+static int tlv_put(struct writer *w, const struct nfc_t2t_tlv *tlv)
+{
+	int err;
+
+	err = byte_put(w, tlv->type);
+	if (err) {
+		return err;
+	}
+
+	if (tlv->length > TLV_SHORT_MAX) {
+		err = byte_put(w, TLV_LONG_FORMAT);
+		if (!err) {
+			err = byte_put(w, (u8_t)(tlv->length >> 8));
+		}
+		if (!err) {
+			err = byte_put(w, (u8_t)tlv->length);
+		}
+	} else {
+		err = byte_put(w, (u8_t)tlv->length);
+	}
+
+	for (u32_t i = 0; !err && i < tlv->length; i++) {
+		err = byte_put(w, tlv->value[i]);
+	}
+
+	return err;
+}
+
+static int tlv_check(const struct nfc_t2t_tlv *tlv)
+{
+	u32_t start;
+	u32_t size;
+
+	if (tlv->length && !tlv->value) {
+		return -EINVAL;
+	}
+
+	switch (tlv->type) {
+	case NFC_T2T_TLV_LOCK_CONTROL:
+	case NFC_T2T_TLV_MEMORY_CONTROL:
+		if (tlv->length != NFC_T2T_TLV_CONTROL_SIZE) {
+			return -EINVAL;
+		}
+		return area_get(tlv, &start, &size);
+
+	case NFC_T2T_TLV_NDEF:
+	case NFC_T2T_TLV_PROPRIETARY:
+		return 0;
+
+	default:
+		return -EINVAL;
+	}
+}
+
+int nfc_t2t_tlv_layout(const struct nfc_t2t_tlv *tlvs, u32_t count,
+		       u8_t *buff, u32_t *len)
+{
+	/* Readers look for control TLVs before the NDEF TLV and may stop
+	 * reading at the first NDEF TLV.
+	 */
+	static const enum nfc_t2t_tlv_type order[] = {
+		NFC_T2T_TLV_LOCK_CONTROL,
+		NFC_T2T_TLV_MEMORY_CONTROL,
+		NFC_T2T_TLV_NDEF,
+		NFC_T2T_TLV_PROPRIETARY,
+	};
+	struct writer w = {
+		.tlvs = tlvs,
+		.count = count,
+		.buff = buff,
+		.size = NFC_T2T_MAX_PAYLOAD_SIZE_RAW,
+	};
+	int err;
+
+	if ((count && !tlvs) || !len) {
+		return -EINVAL;
+	}
+
+	if (buff && *len < w.size) {
+		w.size = *len;
+	}
+
+	for (u32_t i = 0; i < count; i++) {
+		err = tlv_check(&tlvs[i]);
+		if (err) {
+			return err;
+		}
+	}
+
+	for (size_t group = 0; group < ARRAY_SIZE(order); group++) {
+		for (u32_t i = 0; i < count; i++) {
+			if (tlvs[i].type != order[group]) {
+				continue;
+			}
+
+			err = tlv_put(&w, &tlvs[i]);
+			if (err) {
+				return err;
+			}
+		}
+	}
+
+	/* A data area filled up to its end needs no terminator. */
+	if (w.pos < NFC_T2T_MAX_PAYLOAD_SIZE_RAW) {
+		err = byte_put(&w, NFC_T2T_TLV_TERMINATOR);
+		if (err) {
+			return err;
+		}
+	}
+
+	*len = w.pos;
+
+	return 0;
+}
@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <misc/util.h>
+
+#include <nfc_t4t_apdu.h>
+
+#define APDU_HEADER_SIZE 4
+
+#define APDU_INS_SELECT       0xA4
+#define APDU_INS_GET_RESPONSE 0xC0
+#define APDU_SELECT_BY_NAME   0x04
+
+/* Le of 0 requests up to 256 bytes in a short APDU and up to 65536 bytes
+ * in an extended APDU.
+ */
+#define APDU_SHORT_LE_MAX     256
+#define APDU_EXTENDED_LE_MAX  65536
+
+static u32_t be16_get(const u8_t *buf)
+{
+	return ((u32_t)buf[0] << 8) | buf[1];
+}
+
+static int extended_parse(const u8_t *buf, size_t length,
+			  struct nfc_t4t_apdu *apdu)
+{
+	u32_t le;
+	u32_t lc;
+
+	apdu->extended = true;
+
+	/* Case 2E: Le only. */
+	if (length == 3) {
+		le = be16_get(&buf[1]);
+		apdu->le = le ? le : APDU_EXTENDED_LE_MAX;
+		apdu->le_present = true;
+		return 0;
+	}
+
+	if (length < 3) {
+		return -EINVAL;
+	}
+
+	lc = be16_get(&buf[1]);
+	if (lc == 0) {
+		return -EINVAL;
+	}
+
+	apdu->data = &buf[3];
+	apdu->lc = lc;
+
+	/* Case 3E: Lc and data. */
+	if (length == 3 + lc) {
+		return 0;
+	}
+
+	/* Case 4E: Lc, data and Le without the leading zero byte. */
+	if (length == 5 + lc) {
+		le = be16_get(&buf[3 + lc]);
+		apdu->le = le ? le : APDU_EXTENDED_LE_MAX;
+		apdu->le_present = true;
+		return 0;
+	}
+
+	return -EINVAL;
+}
+
+int nfc_t4t_apdu_parse(const u8_t *buf, size_t length,
+		       struct nfc_t4t_apdu *apdu)
+{
+	u32_t lc;
+
+	if (!buf || length < APDU_HEADER_SIZE) {
+		return -EINVAL;
+	}
+
+	apdu->cla = buf[0];
+	apdu->ins = buf[1];
+	apdu->p1 = buf[2];
+	apdu->p2 = buf[3];
+	apdu->data = NULL;
+	apdu->lc = 0;
+	apdu->le = 0;
+	apdu->le_present = false;
+	apdu->extended = false;
+
+	length -= APDU_HEADER_SIZE;
+	buf += APDU_HEADER_SIZE;
+
+	/* Case 1: header only. */
+	if (length == 0) {
+		return 0;
+	}
+
+	/* Case 2: Le only. */
+	if (length == 1) {
+		apdu->le = buf[0] ? buf[0] : APDU_SHORT_LE_MAX;
+		apdu->le_present = true;
+		return 0;
+	}
+
+	lc = buf[0];
+	if (lc == 0) {
+		return extended_parse(buf, length, apdu);
+	}
+
+	apdu->data = &buf[1];
+	apdu->lc = lc;
+
+	/* Case 3: Lc and data. */
+	if (length == 1 + lc) {
+		return 0;
+	}
+
+	/* Case 4: Lc, data and Le. */
+	if (length == 2 + lc) {
+		apdu->le = buf[1 + lc] ? buf[1 + lc] : APDU_SHORT_LE_MAX;
+		apdu->le_present = true;
+		return 0;
+	}
+
+	return -EINVAL;
+}
+
+int nfc_t4t_apdu_router_init(struct nfc_t4t_apdu_router *router,
+			     const struct nfc_t4t_apdu_app *apps,
+			     size_t app_count, u8_t *rsp_buf, size_t rsp_size)
+{
+	/* A streamed response needs room for data, or it never ends. */
+	if (!router || (app_count && !apps) || !rsp_buf ||
+	    rsp_size <= NFC_T4T_APDU_SW_SIZE) {
+		return -EINVAL;
+	}
+
+	router->apps = apps;
+	router->app_count = app_count;
+	router->selected = NULL;
+	router->rsp_buf = rsp_buf;
+	router->rsp_size = rsp_size;
+	router->producer = NULL;
+
+	return 0;
+}
+
+static void sw_write(u8_t *buf, u16_t sw)
+{
+	buf[0] = (u8_t)(sw >> 8);
+	buf[1] = (u8_t)sw;
+}
+
+static void rsp_sw(struct nfc_t4t_apdu_router *router, u16_t sw,
+		   const u8_t **rsp, size_t *rsp_length)
+{
+	sw_write(router->rsp_buf, sw);
+	*rsp = router->rsp_buf;
+	*rsp_length = NFC_T4T_APDU_SW_SIZE;
+}
+
+static void stream_send(struct nfc_t4t_apdu_router *router,
+			const struct nfc_t4t_apdu *apdu,
+			const u8_t **rsp, size_t *rsp_length)
+{
+	size_t chunk = min(router->stream_left,
+			   router->rsp_size - NFC_T4T_APDU_SW_SIZE);
+	u16_t sw;
+
+	if (apdu->le_present) {
+		chunk = min(chunk, apdu->le);
+	} else if (!apdu->extended) {
+		chunk = min(chunk, APDU_SHORT_LE_MAX);
+	}
+
+	if (router->producer(router->producer_context, router->stream_offset,
+			     router->rsp_buf, chunk)) {
+		router->producer = NULL;
+		rsp_sw(router, NFC_T4T_APDU_SW_UNKNOWN, rsp, rsp_length);
+		return;
+	}
+
+	router->stream_offset += chunk;
+	router->stream_left -= chunk;
+
+	if (router->stream_left) {
+		sw = NFC_T4T_APDU_SW_BYTES_REMAINING |
+		     (u8_t)min(router->stream_left, APDU_SHORT_LE_MAX);
+	} else {
+		sw = router->stream_sw;
+		router->producer = NULL;
+	}
+
+	sw_write(&router->rsp_buf[chunk], sw);
+	*rsp = router->rsp_buf;
+	*rsp_length = chunk + NFC_T4T_APDU_SW_SIZE;
+}
+
+static const struct nfc_t4t_apdu_app *
+app_find(const struct nfc_t4t_apdu_router *router, const u8_t *aid,
+	 u32_t aid_length)
+{
+	for (size_t i = 0; i < router->app_count; i++) {
+		const struct nfc_t4t_apdu_app *app = &router->apps[i];
+
+		if (app->aid_length == aid_length &&
+		    !memcmp(app->aid, aid, aid_length)) {
+			return app;
+		}
+	}
+
+	return NULL;
+}
+
+static bool route_match(const struct nfc_t4t_apdu_route *route,
+			const struct nfc_t4t_apdu *apdu)
+{
+	return route->ins == apdu->ins &&
+	       !((route->cla ^ apdu->cla) & route->cla_mask) &&
+	       !((route->p1 ^ apdu->p1) & route->p1_mask) &&
+	       !((route->p2 ^ apdu->p2) & route->p2_mask);
+}
+
+static void select_handle(struct nfc_t4t_apdu_router *router,
+			  const struct nfc_t4t_apdu *apdu,
+			  const u8_t **rsp, size_t *rsp_length)
+{
+	const struct nfc_t4t_apdu_app *app;
+
+	app = app_find(router, apdu->data, apdu->lc);
+	if (!app) {
+		rsp_sw(router, NFC_T4T_APDU_SW_NOT_FOUND, rsp, rsp_length);
+		return;
+	}
+
+	router->selected = app;
+
+	if (app->on_select) {
+		app->on_select(app->select_context);
+	}
+
+	if (app->select_response) {
+		*rsp = app->select_response;
+		*rsp_length = app->select_response_length;
+	} else {
+		rsp_sw(router, NFC_T4T_APDU_SW_OK, rsp, rsp_length);
+	}
+}
+
+void nfc_t4t_apdu_router_dispatch(struct nfc_t4t_apdu_router *router,
+				  const u8_t *buf, size_t length,
+				  const u8_t **rsp, size_t *rsp_length)
+{
+	const struct nfc_t4t_apdu_app *app;
+	struct nfc_t4t_apdu apdu;
+
+	if (nfc_t4t_apdu_parse(buf, length, &apdu)) {
+		router->producer = NULL;
+		rsp_sw(router, NFC_T4T_APDU_SW_WRONG_LENGTH, rsp, rsp_length);
+		return;
+	}
+
+	if (apdu.ins == APDU_INS_GET_RESPONSE && router->producer) {
+		stream_send(router, &apdu, rsp, rsp_length);
+		return;
+	}
+
+	/* Any other command abandons a pending streamed response. */
+	router->producer = NULL;
+
+	if (apdu.ins == APDU_INS_SELECT && apdu.p1 == APDU_SELECT_BY_NAME &&
+	    apdu.lc) {
+		select_handle(router, &apdu, rsp, rsp_length);
+		return;
+	}
+
+	app = router->selected;
+	if (!app) {
+		rsp_sw(router, NFC_T4T_APDU_SW_CONDITIONS_NOT_SAT, rsp,
+		       rsp_length);
+		return;
+	}
+
+	for (size_t i = 0; i < app->route_count; i++) {
+		const struct nfc_t4t_apdu_route *route = &app->routes[i];
+		struct nfc_t4t_apdu_rsp handler_rsp;
+		u16_t sw;
+
+		if (!route_match(route, &apdu)) {
+			continue;
+		}
+
+		if (!route->handler) {
+			*rsp = route->response;
+			*rsp_length = route->response_length;
+			return;
+		}
+
+		handler_rsp.data = router->rsp_buf;
+		handler_rsp.size = router->rsp_size - NFC_T4T_APDU_SW_SIZE;
+		handler_rsp.length = 0;
+		handler_rsp.producer = NULL;
+
+		sw = route->handler(route->context, &apdu, &handler_rsp);
+		if (handler_rsp.producer && handler_rsp.producer_length) {
+			router->producer = handler_rsp.producer;
+			router->producer_context = handler_rsp.producer_context;
+			router->stream_offset = 0;
+			router->stream_left = handler_rsp.producer_length;
+			router->stream_sw = sw;
+			stream_send(router, &apdu, rsp, rsp_length);
+			return;
+		}
+
+		if (handler_rsp.length > handler_rsp.size) {
+			rsp_sw(router, NFC_T4T_APDU_SW_UNKNOWN, rsp,
+			       rsp_length);
+			return;
+		}
+
+		sw_write(&router->rsp_buf[handler_rsp.length], sw);
+		*rsp = router->rsp_buf;
+		*rsp_length = handler_rsp.length + NFC_T4T_APDU_SW_SIZE;
+		return;
+	}
+
+	rsp_sw(router, NFC_T4T_APDU_SW_INS_NOT_SUPPORTED, rsp, rsp_length);
+}
+
+int nfc_t4t_apdu_router_process(struct nfc_t4t_apdu_router *router,
+				const u8_t *buf, size_t length)
+{
+	const u8_t *rsp;
+	size_t rsp_length;
+
+	nfc_t4t_apdu_router_dispatch(router, buf, length, &rsp, &rsp_length);
+
+	return nfc_t4t_response_pdu_send(rsp, rsp_length);
+}
+
+void nfc_t4t_apdu_router_reset(struct nfc_t4t_apdu_router *router)
+{
+	router->selected = NULL;
+	router->producer = NULL;
+}
+
+int nfc_t4t_apdu_reasm_init(struct nfc_t4t_apdu_reasm *reasm, u8_t *buf,
+			    size_t size)
+{
+	if (!reasm || !buf) {
+		return -EINVAL;
+	}
+
+	reasm->buf = buf;
+	reasm->size = size;
+	nfc_t4t_apdu_reasm_reset(reasm);
+
+	return 0;
+}
+
+int nfc_t4t_apdu_reasm_put(struct nfc_t4t_apdu_reasm *reasm, const u8_t *data,
+			   size_t length, u32_t flags,
+			   const u8_t **apdu, size_t *apdu_length)
+{
+	bool more = (flags & NFC_T4T_DI_FLAG_MORE) != 0;
+
+	/* Unchained command: hand out the library buffer directly. */
+	if (!more && reasm->length == 0 && !reasm->overflow) {
+		*apdu = data;
+		*apdu_length = length;
+		return 0;
+	}
+
+	/* The library reuses its buffer for the next frame, so chained
+	 * fragments have to be placed in the registered buffer.
+	 */
+	if (!reasm->overflow) {
+		if (length > reasm->size - reasm->length) {
+			reasm->overflow = true;
+		} else {
+			memcpy(&reasm->buf[reasm->length], data, length);
+			reasm->length += length;
+		}
+	}
+
+	if (more) {
+		return -EAGAIN;
+	}
+
+	if (reasm->overflow) {
+		nfc_t4t_apdu_reasm_reset(reasm);
+		return -ENOMEM;
+	}
+
+	*apdu = reasm->buf;
+	*apdu_length = reasm->length;
+	reasm->length = 0;
+
+	return 0;
+}
+
+void nfc_t4t_apdu_reasm_reset(struct nfc_t4t_apdu_reasm *reasm)
+{
+	reasm->length = 0;
+	reasm->overflow = false;
+}
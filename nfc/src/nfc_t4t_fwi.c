@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <kernel.h>
+
+#include <nfc_t4t_fwi.h>
+
+/* FWT = 256 * 16 / fc * 2^FWI, with fc = 13.56 MHz. */
+#define FWT_UNIT_CYCLES 4096
+#define FC_HZ           13560000
+
+/* Fraction of the peak kept from one tap to the next is 1 - 1/2^N. */
+#define PEAK_DECAY_SHIFT 3
+
+static u8_t lowest_fwi;
+static u8_t highest_fwi;
+static u32_t peak_margin_pct;
+static u32_t start_cycles;
+static bool measuring;
+static u32_t tap_max_us;
+static struct nfc_t4t_fwi_stats stats;
+
+u32_t nfc_t4t_fwi_to_us(u8_t fwi)
+{
+	return ((u64_t)FWT_UNIT_CYCLES << fwi) * USEC_PER_SEC / FC_HZ;
+}
+
+static int fwi_apply(u8_t fwi)
+{
+	int err;
+
+	err = nfc_t4t_parameter_set(NFC_T4T_PARAM_FWI, &fwi, sizeof(fwi));
+	if (!err) {
+		stats.fwi = fwi;
+	}
+
+	return err;
+}
+
+int nfc_t4t_fwi_init(u8_t fwi_min, u8_t fwi_max, u32_t margin_pct)
+{
+	if (fwi_min > fwi_max || fwi_max > NFC_T4T_FWI_MAX) {
+		return -EINVAL;
+	}
+
+	lowest_fwi = fwi_min;
+	highest_fwi = fwi_max;
+	peak_margin_pct = margin_pct;
+	measuring = false;
+	tap_max_us = 0;
+	memset(&stats, 0, sizeof(stats));
+
+	return fwi_apply(fwi_min);
+}
+
+void nfc_t4t_fwi_command_received(void)
+{
+	start_cycles = k_cycle_get_32();
+	measuring = true;
+}
+
+void nfc_t4t_fwi_response_sent(void)
+{
+	u32_t us;
+
+	if (!measuring) {
+		return;
+	}
+
+	measuring = false;
+	us = (u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(k_cycle_get_32() -
+						 start_cycles) /
+		     NSEC_PER_USEC);
+
+	stats.samples++;
+	stats.last_us = us;
+	stats.max_us = max(stats.max_us, us);
+	tap_max_us = max(tap_max_us, us);
+
+	if (us > nfc_t4t_fwi_to_us(stats.fwi)) {
+		stats.overruns++;
+	}
+}
+
+int nfc_t4t_fwi_field_off(void)
+{
+	u64_t required;
+	u8_t fwi;
+
+	measuring = false;
+
+	stats.peak_us -= stats.peak_us >> PEAK_DECAY_SHIFT;
+	stats.peak_us = max(stats.peak_us, tap_max_us);
+	tap_max_us = 0;
+
+	required = (u64_t)stats.peak_us * (100 + peak_margin_pct) / 100;
+
+	for (fwi = lowest_fwi; fwi < highest_fwi; fwi++) {
+		if (nfc_t4t_fwi_to_us(fwi) >= required) {
+			break;
+		}
+	}
+
+	if (fwi == stats.fwi) {
+		return 0;
+	}
+
+	return fwi_apply(fwi);
+}
+
+void nfc_t4t_fwi_stats_get(struct nfc_t4t_fwi_stats *out)
+{
+	unsigned int key = irq_lock();
+
+	*out = stats;
+	irq_unlock(key);
+}
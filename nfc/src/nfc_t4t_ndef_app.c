@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <errno.h>
+#include <string.h>
+#include <misc/util.h>
+
+#include <nfc_ndef_msg.h>
+#include <nfc_t4t_ndef_app.h>
+
+#define FILE_NONE        0x0000
+#define FILE_CC          0xE103
+#define FILE_NDEF        0xE104
+
+#define SELECT_FIRST_OR_ONLY 0x0C
+#define SELECT_FCI_NONE  0x00
+
+#define NDEF_FILE_MAX    0xFFFE
+#define NDEF_MAPPING_2_0 0x20
+#define NDEF_FILE_TLV    0x04
+#define ACCESS_GRANTED   0x00
+#define ACCESS_DENIED    0xFF
+
+const u8_t nfc_t4t_ndef_app_aid[7] = {
+	0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01
+};
+
+int nfc_t4t_ndef_app_init(struct nfc_t4t_ndef_app *app, u8_t *file,
+			  size_t size, bool writable,
+			  nfc_t4t_ndef_app_updated_t updated, void *context)
+{
+	u8_t *cc;
+
+	if (!app || !file || size < NFC_NDEF_MSG_NLEN_SIZE ||
+	    size > NDEF_FILE_MAX) {
+		return -EINVAL;
+	}
+
+	app->file = file;
+	app->size = size;
+	app->writable = writable;
+	app->selected = FILE_NONE;
+	app->updated = updated;
+	app->context = context;
+
+	cc = app->cc;
+	*cc++ = 0x00;
+	*cc++ = NFC_T4T_NDEF_APP_CC_SIZE;
+	*cc++ = NDEF_MAPPING_2_0;
+	*cc++ = (u8_t)(NFC_T4T_NDEF_APP_MLE >> 8);
+	*cc++ = (u8_t)NFC_T4T_NDEF_APP_MLE;
+	*cc++ = (u8_t)(NFC_T4T_NDEF_APP_MLC >> 8);
+	*cc++ = (u8_t)NFC_T4T_NDEF_APP_MLC;
+	*cc++ = NDEF_FILE_TLV;
+	*cc++ = 6;
+	*cc++ = (u8_t)(FILE_NDEF >> 8);
+	*cc++ = (u8_t)FILE_NDEF;
+	*cc++ = (u8_t)(size >> 8);
+	*cc++ = (u8_t)size;
+	*cc++ = ACCESS_GRANTED;
+	*cc = writable ? ACCESS_GRANTED : ACCESS_DENIED;
+
+	return 0;
+}
+
+void nfc_t4t_ndef_app_selected(void *context)
+{
+	struct nfc_t4t_ndef_app *app = context;
+
+	app->selected = FILE_NONE;
+}
+
+u16_t nfc_t4t_ndef_app_select(void *context, const struct nfc_t4t_apdu *apdu,
+			      struct nfc_t4t_apdu_rsp *rsp)
+{
+	struct nfc_t4t_ndef_app *app = context;
+	u16_t file_id;
+
+	if (apdu->p2 != SELECT_FIRST_OR_ONLY && apdu->p2 != SELECT_FCI_NONE) {
+		return NFC_T4T_APDU_SW_WRONG_P1P2;
+	}
+
+	if (apdu->lc != 2) {
+		return NFC_T4T_APDU_SW_WRONG_LENGTH;
+	}
+
+	file_id = (apdu->data[0] << 8) | apdu->data[1];
+	if (file_id != FILE_CC && file_id != FILE_NDEF) {
+		return NFC_T4T_APDU_SW_NOT_FOUND;
+	}
+
+	app->selected = file_id;
+
+	return NFC_T4T_APDU_SW_OK;
+}
+
+u16_t nfc_t4t_ndef_app_read(void *context, const struct nfc_t4t_apdu *apdu,
+			    struct nfc_t4t_apdu_rsp *rsp)
+{
+	struct nfc_t4t_ndef_app *app = context;
+	const u8_t *file;
+	size_t file_size;
+	size_t offset;
+	size_t length;
+
+	if (app->selected == FILE_CC) {
+		file = app->cc;
+		file_size = sizeof(app->cc);
+	} else if (app->selected == FILE_NDEF) {
+		file = app->file;
+		file_size = app->size;
+	} else {
+		return NFC_T4T_APDU_SW_NO_CURRENT_FILE;
+	}
+
+	/* P1 bit 8 set selects a short EF identifier, which is not used. */
+	if (apdu->p1 & 0x80) {
+		return NFC_T4T_APDU_SW_WRONG_P1P2;
+	}
+
+	offset = (apdu->p1 << 8) | apdu->p2;
+	if (offset > file_size) {
+		return NFC_T4T_APDU_SW_WRONG_PARAMS;
+	}
+
+	length = apdu->le_present ? apdu->le : NFC_T4T_NDEF_APP_MLE;
+	length = min(length, (size_t)NFC_T4T_NDEF_APP_MLE);
+	length = min(length, file_size - offset);
+	length = min(length, rsp->size);
+
+	memcpy(rsp->data, &file[offset], length);
+	rsp->length = length;
+
+	return NFC_T4T_APDU_SW_OK;
+}
+
+u16_t nfc_t4t_ndef_app_update(void *context, const struct nfc_t4t_apdu *apdu,
+			      struct nfc_t4t_apdu_rsp *rsp)
+{
+	struct nfc_t4t_ndef_app *app = context;
+	size_t offset;
+
+	if (app->selected != FILE_NDEF || !app->writable) {
+		return NFC_T4T_APDU_SW_SECURITY_NOT_SAT;
+	}
+
+	if (apdu->p1 & 0x80) {
+		return NFC_T4T_APDU_SW_WRONG_P1P2;
+	}
+
+	offset = (apdu->p1 << 8) | apdu->p2;
+	if (offset > app->size || apdu->lc > app->size - offset) {
+		return NFC_T4T_APDU_SW_WRONG_PARAMS;
+	}
+
+	memcpy(&app->file[offset], apdu->data, apdu->lc);
+
+	if (offset < NFC_NDEF_MSG_NLEN_SIZE && app->updated) {
+		app->updated(app->context,
+			     (app->file[0] << 8) | app->file[1]);
+	}
+
+	return NFC_T4T_APDU_SW_OK;
+}